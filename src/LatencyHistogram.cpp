@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QJsonArray>
+#include <QtMath>
+
+#include <bit>
+
+#include "LatencyHistogram.h"
+
+
+void LatencyHistogram::add(qint64 nanoseconds)
+{
+    nanoseconds = qMax(static_cast<qint64>(0), nanoseconds);
+    auto microseconds = static_cast<quint64>(nanoseconds/1000);
+    auto bucket = qMin(numBuckets-1, static_cast<int>(std::bit_width(microseconds)));
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumNanoseconds.fetch_add(static_cast<quint64>(nanoseconds), std::memory_order_relaxed);
+}
+
+
+auto LatencyHistogram::count() const -> quint64
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+
+auto LatencyHistogram::percentileMicroseconds(double fraction) const -> qint64
+{
+    quint64 total = 0;
+    std::array<quint32, numBuckets> buckets {};
+    for(int i=0; i<numBuckets; i++)
+    {
+        buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    auto threshold = static_cast<quint64>(qCeil(fraction*static_cast<double>(total)));
+    quint64 running = 0;
+    for(int i=0; i<numBuckets; i++)
+    {
+        running += buckets[i];
+        if (running >= threshold)
+        {
+            return static_cast<qint64>(1) << i;
+        }
+    }
+    return static_cast<qint64>(1) << (numBuckets-1);
+}
+
+
+void LatencyHistogram::reset()
+{
+    for(auto& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumNanoseconds.store(0, std::memory_order_relaxed);
+}
+
+
+auto LatencyHistogram::toJSON() const -> QJsonObject
+{
+    QJsonArray buckets;
+    for(const auto& bucket : m_buckets)
+    {
+        buckets.append(static_cast<qint64>(bucket.load(std::memory_order_relaxed)));
+    }
+
+    auto n = count();
+    QJsonObject result;
+    result.insert(QStringLiteral("count"), static_cast<qint64>(n));
+    result.insert(QStringLiteral("meanMicroseconds"), (n == 0) ? 0.0 : static_cast<double>(m_sumNanoseconds.load(std::memory_order_relaxed))/static_cast<double>(n)/1000.0);
+    result.insert(QStringLiteral("p50Microseconds"), percentileMicroseconds(0.5));
+    result.insert(QStringLiteral("p99Microseconds"), percentileMicroseconds(0.99));
+    result.insert(QStringLiteral("buckets"), buckets);
+    return result;
+}
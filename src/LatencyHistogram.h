@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QJsonObject>
+
+#include <array>
+#include <atomic>
+
+
+/*! \brief Lock-free histogram of latencies
+ *
+ *  This class records latencies in buckets whose boundaries are powers of two
+ *  microseconds. Recording a value costs a few relaxed atomic increments, so
+ *  that histograms can remain switched on in production builds and may be
+ *  filled from any thread.
+ */
+
+class LatencyHistogram
+{
+public:
+    /*! \brief Number of buckets
+     *
+     *  Bucket 0 counts latencies below one microsecond. Bucket i > 0 counts
+     *  latencies in the interval [2^(i-1), 2^i) microseconds. The last bucket
+     *  also counts all larger values.
+     */
+    static constexpr int numBuckets = 24;
+
+    /*! \brief Record a latency
+     *
+     *  @param nanoseconds Latency in nanoseconds
+     */
+    void add(qint64 nanoseconds);
+
+    /*! \brief Number of recorded latencies
+     *
+     *  @returns Number of recorded latencies
+     */
+    [[nodiscard]] auto count() const -> quint64;
+
+    /*! \brief Estimate of a percentile
+     *
+     *  @param fraction Number between 0 and 1, such as 0.99 for the 99th
+     *  percentile
+     *
+     *  @returns Upper bound of the bucket that contains the percentile, in
+     *  microseconds, or 0 if no latency has been recorded
+     */
+    [[nodiscard]] auto percentileMicroseconds(double fraction) const -> qint64;
+
+    /*! \brief Reset all buckets to zero */
+    void reset();
+
+    /*! \brief Description in JSON format
+     *
+     *  @returns JSON object with count, mean, 50th and 99th percentile and the
+     *  raw bucket counts
+     */
+    [[nodiscard]] auto toJSON() const -> QJsonObject;
+
+private:
+    std::array<std::atomic<quint32>, numBuckets> m_buckets {};
+    std::atomic<quint64> m_count {0};
+    std::atomic<quint64> m_sumNanoseconds {0};
+};
@@ -0,0 +1,538 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Headless benchmark of the traffic data pipeline
+ *
+ * This program feeds FLARM, GDL90 and XGPS data through the decoders of
+ * TrafficDataSource_Abstract and through a TrafficDataProvider, without QML,
+ * network or event loop. The data comes from capture files given on the
+ * command line (see Traffic::TrafficCapture) and from synthetic corpora with
+ * a configurable number of targets. For every corpus, the program reports
+ *
+ * - messages per second, for the decoders alone and for the whole pipeline,
+ * - heap allocations per message (see the allocation counter below), and
+ * - 50th and 99th percentile of the latency from the start of parsing to the
+ *   end of the provider update.
+ *
+ * Batches are handed to the provider as soon as a burst of data has been
+ * decoded. In the app, a source waits up to batchInterval before it emits a
+ * batch; this constant delay is not included in the latencies.
+ *
+ * With the option --live, the program additionally runs the traffic
+ * simulator of the app, TrafficDataSource_Simulate, in a real event loop, and
+ * reports the ingestion and latency statistics that the provider collects.
+ */
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QGeoPositionInfo>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "GlobalObject.h"
+#include "LatencyHistogram.h"
+#include "traffic/DatagramFilter.h"
+#include "traffic/GDL90.h"
+#include "traffic/LineFramer.h"
+#include "traffic/SyntheticTraffic.h"
+#include "traffic/TrafficCapture.h"
+#include "traffic/TrafficDataProvider.h"
+#include "traffic/TrafficDataSource_Abstract.h"
+#include "traffic/TrafficDataSource_Simulate.h"
+
+
+//
+// Allocation counter. Qt containers such as QString, QByteArray, QList and
+// QHash allocate with malloc and realloc directly, not with operator new.
+// On glibc, the program therefore interposes malloc, calloc and realloc,
+// which counts all heap allocations, including those made by Qt and by
+// operator new. On other platforms, only operator new is counted, and the
+// number of allocations is too small.
+//
+
+std::atomic<quint64> g_allocations {0};
+
+#if defined(__GLIBC__)
+
+extern "C" {
+
+// Implementations of glibc, which the functions below forward to
+auto __libc_malloc(std::size_t size) -> void*;
+auto __libc_calloc(std::size_t count, std::size_t size) -> void*;
+auto __libc_realloc(void* ptr, std::size_t size) -> void*;
+
+auto malloc(std::size_t size) noexcept -> void*
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+auto calloc(std::size_t count, std::size_t size) noexcept -> void*
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+auto realloc(void* ptr, std::size_t size) noexcept -> void*
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+
+#else
+
+auto operator new(std::size_t size) -> void*
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator new[](std::size_t size) -> void*
+{
+    return operator new(size);
+}
+
+auto operator new(std::size_t size, const std::nothrow_t& /*unused*/) noexcept -> void*
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+auto operator new[](std::size_t size, const std::nothrow_t& tag) noexcept -> void*
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*unused*/) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*unused*/) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
+
+
+//
+// Corpora
+//
+
+// One chunk of data, as a traffic receiver would deliver it
+struct CorpusEntry {
+    // Time since start of the corpus, in microseconds
+    qint64 timestamp {0};
+
+    Traffic::TrafficCapture::Channel channel {Traffic::TrafficCapture::Channel::Sentence};
+    QByteArray data;
+
+    // Number of sentences or GDL90 messages contained in data
+    int messages {1};
+};
+
+struct Corpus {
+    QString name;
+    QVector<CorpusEntry> entries;
+};
+
+
+// Position of the simulated ownship
+const QGeoCoordinate benchmarkOwnship(48.0, 7.85, 1000.0);
+
+
+// Counts the messages contained in captured data
+auto countMessages(Traffic::TrafficCapture::Channel channel, QByteArrayView data) -> int
+{
+    switch (channel) {
+    case Traffic::TrafficCapture::Channel::Sentence:
+        return 1;
+    case Traffic::TrafficCapture::Channel::TCP:
+        return static_cast<int>(std::count(data.begin(), data.end(), '\n'));
+    case Traffic::TrafficCapture::Channel::UDP:
+        break;
+    }
+    if (data.startsWith("XGPS") || data.startsWith("XTRA")) {
+        return 1;
+    }
+    int count = 0;
+    Traffic::GDL90::Deframer deframer;
+    auto onFrame = [&count](const Traffic::GDL90::Frame& /*unused*/) { count++; };
+    deframer.feed(data, onFrame);
+    deframer.finish(onFrame);
+    return count;
+}
+
+
+// Reads a capture file
+auto loadCapture(const QString& fileName) -> Corpus
+{
+    Corpus corpus;
+    corpus.name = fileName;
+
+    QFile file(fileName);
+    Traffic::TrafficCapture::Reader reader;
+    if (!file.open(QIODevice::ReadOnly) || !reader.setDevice(&file)) {
+        qWarning("%s is not a capture file", qPrintable(fileName));
+        return corpus;
+    }
+    Traffic::TrafficCapture::Record record;
+    while (reader.read(record)) {
+        CorpusEntry entry;
+        entry.timestamp = record.timestamp;
+        entry.channel = record.channel;
+        entry.data = record.data.toByteArray();
+        entry.messages = countMessages(record.channel, record.data);
+        corpus.entries.append(entry);
+    }
+    return corpus;
+}
+
+
+// Synthetic corpus. The targets are moved and encoded once per second by
+// Traffic::SyntheticTraffic, as in the traffic simulator of the app.
+auto syntheticCorpus(Traffic::SyntheticTraffic::Protocol protocol, int numTargets, int seconds) -> Corpus
+{
+    Corpus corpus;
+    auto channel = Traffic::TrafficCapture::Channel::UDP;
+    switch (protocol) {
+    case Traffic::SyntheticTraffic::Protocol::FLARM:
+        corpus.name = QStringLiteral("synthetic FLARM, %1 targets").arg(numTargets);
+        channel = Traffic::TrafficCapture::Channel::Sentence;
+        break;
+    case Traffic::SyntheticTraffic::Protocol::GDL90:
+        corpus.name = QStringLiteral("synthetic GDL90, %1 targets").arg(numTargets);
+        break;
+    case Traffic::SyntheticTraffic::Protocol::XGPS:
+        corpus.name = QStringLiteral("synthetic XGPS, %1 targets").arg(numTargets);
+        break;
+    }
+
+    Traffic::SyntheticTraffic traffic;
+    traffic.addRandomTargets(numTargets, 1, Units::Distance::fromKM(15));
+    const QGeoPositionInfo ownship(benchmarkOwnship, QDateTime::currentDateTimeUtc());
+    const auto pressureAltitude = Units::Distance::fromM(benchmarkOwnship.altitude());
+    for(int s=0; s<seconds; s++) {
+        auto timestamp = s*qint64(1000000);
+        traffic.encode(protocol, ownship, pressureAltitude, [&](QByteArrayView data) {
+            corpus.entries.append({timestamp, channel, data.toByteArray(), countMessages(channel, data)});
+        });
+        traffic.advance(1s);
+    }
+    return corpus;
+}
+
+
+//
+// Pipeline
+//
+
+// Data source that hands data to the decoders in the same way as the TCP and
+// UDP sources do
+class BenchmarkSource : public Traffic::TrafficDataSource_Abstract
+{
+public:
+    [[nodiscard]] auto sourceName() const -> QString override
+    {
+        return QStringLiteral("Benchmark");
+    }
+
+    void connectToTrafficReceiver() override {}
+    void disconnectFromTrafficReceiver() override {}
+
+    void feed(const CorpusEntry& entry)
+    {
+        stampReceiveTime();
+        switch (entry.channel) {
+        case Traffic::TrafficCapture::Channel::Sentence:
+            processFLARMSentence(entry.data);
+            break;
+        case Traffic::TrafficCapture::Channel::TCP: {
+            QByteArrayView data(entry.data);
+            while (!data.isEmpty()) {
+                auto buffer = m_lineFramer.writeBuffer();
+                auto size = qMin(data.size(), static_cast<qsizetype>(buffer.size()));
+                memcpy(buffer.data(), data.data(), size);
+                m_lineFramer.commit(size);
+                m_lineFramer.takeLines([this](QByteArrayView line) { processFLARMSentence(line); });
+                data = data.sliced(size);
+            }
+            break;
+        }
+        case Traffic::TrafficCapture::Channel::UDP:
+            if (m_datagramFilter.isDuplicate(entry.data, entry.timestamp/1000)) {
+                break;
+            }
+            if (entry.data.startsWith("XGPS") || entry.data.startsWith("XTRA")) {
+                processXGPSString(entry.data);
+            } else {
+                processGDLDatagram(entry.data);
+            }
+            break;
+        }
+    }
+
+    // Emits the current batch right away, instead of waiting for the batch
+    // timer
+    void flush()
+    {
+        QMetaObject::invokeMethod(this, "flushBatch", Qt::DirectConnection);
+    }
+
+private:
+    Traffic::LineFramer m_lineFramer;
+    Traffic::DatagramFilter m_datagramFilter;
+};
+
+
+// Runs one corpus through a fresh provider
+auto runCorpus(const Corpus& corpus) -> QJsonObject
+{
+    // The provider comes with the network sources of the app. They must not
+    // receive anything while the benchmark runs.
+    Traffic::TrafficDataProvider provider;
+    provider.clearDataSources();
+    auto* source = new BenchmarkSource();
+    Positioning::PositionInfo ownship(QGeoPositionInfo(benchmarkOwnship, QDateTime::currentDateTimeUtc()));
+    source->setOwnshipPosition(ownship, benchmarkOwnship);
+    provider.addDataSource(source);
+
+    // When a batch arrives here, the provider has already handled it
+    QElapsedTimer clock;
+    clock.start();
+    QVector<qint64> feedTimes(corpus.entries.size());
+    qsizetype fed = 0;
+    qsizetype delivered = 0;
+    LatencyHistogram latency;
+    bool measuring = false;
+    QObject::connect(source, &Traffic::TrafficDataSource_Abstract::dataBatchReady, &provider, [&]() {
+        auto now = clock.nsecsElapsed();
+        for(; delivered<fed; delivered++) {
+            if (!measuring) {
+                continue;
+            }
+            for(int m=0; m<corpus.entries[delivered].messages; m++) {
+                latency.add(now - feedTimes[delivered]);
+            }
+        }
+    });
+
+    // Data that arrives within one batchInterval is handed to the provider as
+    // one batch. The first burst warms up caches and lazily constructed
+    // objects and is not measured.
+    auto batchInterval = std::chrono::duration_cast<std::chrono::microseconds>(Traffic::TrafficDataSource_Abstract::batchInterval).count();
+    qint64 decodeNanoseconds = 0;
+    qint64 providerNanoseconds = 0;
+    quint64 messages = 0;
+    quint64 allocations = 0;
+    qint64 burstStart = corpus.entries.isEmpty() ? 0 : corpus.entries.first().timestamp;
+    for(const auto& entry : corpus.entries) {
+        if (entry.timestamp - burstStart > batchInterval) {
+            auto allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+            auto start = clock.nsecsElapsed();
+            source->flush();
+            if (measuring) {
+                providerNanoseconds += clock.nsecsElapsed() - start;
+                allocations += g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+            }
+            measuring = true;
+            burstStart = entry.timestamp;
+        }
+
+        auto allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+        auto start = clock.nsecsElapsed();
+        feedTimes[fed] = start;
+        fed++;
+        source->feed(entry);
+        if (measuring) {
+            decodeNanoseconds += clock.nsecsElapsed() - start;
+            allocations += g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+            messages += entry.messages;
+        }
+    }
+    auto allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+    auto start = clock.nsecsElapsed();
+    source->flush();
+    providerNanoseconds += clock.nsecsElapsed() - start;
+    allocations += g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+    auto perSecond = [messages](qint64 nanoseconds) {
+        return (nanoseconds > 0) ? 1e9*static_cast<double>(messages)/static_cast<double>(nanoseconds) : 0.0;
+    };
+    QJsonObject result;
+    result.insert(QStringLiteral("corpus"), corpus.name);
+    result.insert(QStringLiteral("messages"), static_cast<qint64>(messages));
+    result.insert(QStringLiteral("decoderMessagesPerSecond"), perSecond(decodeNanoseconds));
+    result.insert(QStringLiteral("pipelineMessagesPerSecond"), perSecond(decodeNanoseconds+providerNanoseconds));
+    result.insert(QStringLiteral("allocationsPerMessage"), (messages > 0) ? static_cast<double>(allocations)/static_cast<double>(messages) : 0.0);
+    result.insert(QStringLiteral("latency"), latency.toJSON());
+
+    std::printf("%-40s %10llu msgs  %12.0f msgs/s decode  %12.0f msgs/s pipeline  %8.2f allocs/msg  p50 %6lld us  p99 %6lld us\n",
+                qPrintable(corpus.name),
+                static_cast<unsigned long long>(messages),
+                perSecond(decodeNanoseconds),
+                perSecond(decodeNanoseconds+providerNanoseconds),
+                result.value(QStringLiteral("allocationsPerMessage")).toDouble(),
+                static_cast<long long>(latency.percentileMicroseconds(0.5)),
+                static_cast<long long>(latency.percentileMicroseconds(0.99)));
+    return result;
+}
+
+
+// Runs the traffic simulator of the app for the given number of seconds,
+// with a real event loop and the batch timers of the sources
+auto runSimulator(Traffic::SyntheticTraffic::Protocol protocol, int numTargets, int seconds) -> QJsonObject
+{
+    Traffic::TrafficDataProvider provider;
+    provider.clearDataSources();
+    auto* source = new Traffic::TrafficDataSource_Simulate();
+    source->setCoordinate(benchmarkOwnship);
+    source->setBarometricHeight(Units::Distance::fromM(benchmarkOwnship.altitude()));
+    source->setSyntheticProtocol(protocol);
+    source->setSyntheticInterval(1s);
+    source->addRandomSyntheticTargets(numTargets, 1, Units::Distance::fromKM(15));
+    provider.addDataSource(source);
+    provider.resetLatencyStatistics();
+
+    auto start = source->ingestionStatistics().snapshot();
+    source->connectToTrafficReceiver();
+    QEventLoop loop;
+    QTimer::singleShot(std::chrono::seconds(seconds), &loop, &QEventLoop::quit);
+    loop.exec();
+    source->disconnectFromTrafficReceiver();
+    auto ingestion = source->ingestionStatistics().snapshot().toJSON(start);
+
+    QString name;
+    switch (protocol) {
+    case Traffic::SyntheticTraffic::Protocol::FLARM:
+        name = QStringLiteral("simulator FLARM, %1 targets").arg(numTargets);
+        break;
+    case Traffic::SyntheticTraffic::Protocol::GDL90:
+        name = QStringLiteral("simulator GDL90, %1 targets").arg(numTargets);
+        break;
+    case Traffic::SyntheticTraffic::Protocol::XGPS:
+        name = QStringLiteral("simulator XGPS, %1 targets").arg(numTargets);
+        break;
+    }
+    auto latency = provider.latencyStatistics();
+    QJsonObject result;
+    result.insert(QStringLiteral("corpus"), name);
+    result.insert(QStringLiteral("ingestion"), ingestion);
+    result.insert(QStringLiteral("latency"), latency);
+
+    auto reportToProvider = latency.value(QStringLiteral("reportToProvider")).toObject();
+    std::printf("%-40s %10.0f msgs/s  %8.1f us/msg parse  report to provider p50 %6lld us  p99 %6lld us\n",
+                qPrintable(name),
+                ingestion.value(QStringLiteral("messagesPerSecond")).toDouble(),
+                ingestion.value(QStringLiteral("parseMicrosecondsPerMessage")).toDouble(),
+                static_cast<long long>(reportToProvider.value(QStringLiteral("p50Microseconds")).toDouble()),
+                static_cast<long long>(reportToProvider.value(QStringLiteral("p99Microseconds")).toDouble()));
+    return result;
+}
+
+
+auto main(int argc, char *argv[]) -> int
+{
+    // The provider and its helpers expect a GUI application, but nothing is
+    // shown
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    qRegisterMetaType<Traffic::Warning>();
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setOrganizationName(QStringLiteral("Akaflieg Freiburg"));
+    QCoreApplication::setOrganizationDomain(QStringLiteral("akaflieg_freiburg.de"));
+    QCoreApplication::setApplicationName(QStringLiteral("enroute flight navigation"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Feeds recorded and synthetic traffic data through the decoders and the traffic data provider, and reports throughput, allocations and latency."));
+    parser.addHelpOption();
+    QCommandLineOption targetsOption(QStringLiteral("targets"), QStringLiteral("Number of synthetic targets (default 1000)."), QStringLiteral("count"), QStringLiteral("1000"));
+    QCommandLineOption secondsOption(QStringLiteral("seconds"), QStringLiteral("Duration of the synthetic corpora in seconds (default 60)."), QStringLiteral("seconds"), QStringLiteral("60"));
+    QCommandLineOption liveOption(QStringLiteral("live"), QStringLiteral("Also run the traffic simulator of the app for the given number of seconds per protocol."), QStringLiteral("seconds"));
+    QCommandLineOption jsonOption(QStringLiteral("json"), QStringLiteral("Write results to JSON file."), QStringLiteral("fileName"));
+    parser.addOption(targetsOption);
+    parser.addOption(secondsOption);
+    parser.addOption(liveOption);
+    parser.addOption(jsonOption);
+    parser.addPositionalArgument(QStringLiteral("[captureFiles...]"), QStringLiteral("Capture files to be replayed."));
+    parser.process(app);
+
+    auto numTargets = qMax(1, parser.value(targetsOption).toInt());
+    auto seconds = qMax(2, parser.value(secondsOption).toInt());
+
+    QVector<Corpus> corpora;
+    foreach(auto fileName, parser.positionalArguments()) {
+        corpora.append(loadCapture(fileName));
+    }
+    corpora.append(syntheticCorpus(Traffic::SyntheticTraffic::Protocol::FLARM, numTargets, seconds));
+    corpora.append(syntheticCorpus(Traffic::SyntheticTraffic::Protocol::GDL90, numTargets, seconds));
+    corpora.append(syntheticCorpus(Traffic::SyntheticTraffic::Protocol::XGPS, numTargets, seconds));
+
+    QJsonArray results;
+    foreach(const auto& corpus, corpora) {
+        results.append(runCorpus(corpus));
+    }
+    if (parser.isSet(liveOption)) {
+        auto liveSeconds = qMax(2, parser.value(liveOption).toInt());
+        results.append(runSimulator(Traffic::SyntheticTraffic::Protocol::FLARM, numTargets, liveSeconds));
+        results.append(runSimulator(Traffic::SyntheticTraffic::Protocol::GDL90, numTargets, liveSeconds));
+        results.append(runSimulator(Traffic::SyntheticTraffic::Protocol::XGPS, numTargets, liveSeconds));
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly) || (file.write(QJsonDocument(results).toJson()) < 0)) {
+            qWarning("Cannot write %s", qPrintable(file.fileName()));
+            return 1;
+        }
+    }
+
+    GlobalObject::clear();
+    return 0;
+}
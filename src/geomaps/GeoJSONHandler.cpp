@@ -18,6 +18,9 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <QGeoRectangle>
+#include <QtMath>
+
 #include <qhttpengine/socket.h>
 
 #include "GeoJSONHandler.h"
@@ -32,8 +35,50 @@ GeoMaps::GeoJSONHandler::GeoJSONHandler(QObject* parent)
 
 void GeoMaps::GeoJSONHandler::process(QHttpEngine::Socket *socket, const QString &path)
 {
+    auto pathWithoutQuery = path.section('?', 0, 0);
+
+    // Serve GeoJSON for a given region, if requested
+    auto queryString = socket->queryString();
+    if (queryString.contains(QStringLiteral("bbox")))
+    {
+        auto box = queryString.value(QStringLiteral("bbox")).split(',');
+        bool ok = (box.size() == 4);
+        double west = 0.0;
+        double south = 0.0;
+        double east = 0.0;
+        double north = 0.0;
+        if (ok)
+        {
+            bool okW = false;
+            bool okS = false;
+            bool okE = false;
+            bool okN = false;
+            west = box[0].toDouble(&okW);
+            south = box[1].toDouble(&okS);
+            east = box[2].toDouble(&okE);
+            north = box[3].toDouble(&okN);
+            ok = okW && okS && okE && okN;
+        }
+        bool okZoom = false;
+        auto zoom = queryString.value(QStringLiteral("zoom"), QStringLiteral("10")).toDouble(&okZoom);
+        if (!ok || !okZoom)
+        {
+            socket->writeError(QHttpEngine::Socket::BadRequest);
+            socket->close();
+            return;
+        }
+
+        socket->setHeader("Content-Type", "application/json");
+        QGeoRectangle boundingBox(QGeoCoordinate(north, west), QGeoCoordinate(south, east));
+        QByteArray json = GlobalObject::geoMapProvider()->geoJSONInRegion(boundingBox, qFloor(zoom));
+        socket->setHeader("Content-Length", QByteArray::number(json.length()));
+        socket->write(json);
+        socket->close();
+        return;
+    }
+
     // Serve GeoJSONJSON file, if requested
-    if (path.isEmpty() || path.endsWith(QLatin1String("json"), Qt::CaseInsensitive))
+    if (pathWithoutQuery.isEmpty() || pathWithoutQuery.endsWith(QLatin1String("json"), Qt::CaseInsensitive))
     {
         socket->setHeader("Content-Type", "application/json");
         QByteArray json = GlobalObject::geoMapProvider()->geoJSON();
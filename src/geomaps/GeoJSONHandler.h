@@ -30,6 +30,11 @@ namespace GeoMaps {
 /*! \brief Implementation of QHttpEngine::Handler that serves GeoJSON from GeoMapProvider
  *
  *  This class serves the GeoJSON provided by GeoMapProvider at the URL path "aviationData.geojson".
+ *
+ *  If the query string contains a bounding box, as in
+ *  "aviationData.geojson?bbox=west,south,east,north&zoom=9", then only the
+ *  features that meet the bounding box are served, with polygons simplified
+ *  for the given zoom level. See GeoMapProvider::geoJSONInRegion() for details.
  */
 
 class GeoJSONHandler : public QHttpEngine::Handler
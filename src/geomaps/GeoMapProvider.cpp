@@ -33,6 +33,134 @@
 #include "navigation/Navigator.h"
 
 
+// Key of the grid cell that contains the given coordinate, used by the spatial
+// index of GeoMapProvider
+auto gridCellKey(double latitude, double longitude) -> int
+{
+    return (qBound(-90, qFloor(latitude), 89)+90)*360 + (qBound(-180, qFloor(longitude), 179)+180);
+}
+
+// Bounding box of a GeoJSON feature. Returns an invalid rectangle if the
+// feature has no geometry that we understand.
+auto featureBoundingBox(const QJsonObject& feature) -> QGeoRectangle
+{
+    auto geometry = feature[QStringLiteral("geometry")].toObject();
+    auto type = geometry[QStringLiteral("type")].toString();
+    auto coordinates = geometry[QStringLiteral("coordinates")].toArray();
+
+    QList<QGeoCoordinate> points;
+    auto addPoint = [&points](const QJsonValue& value) {
+        auto array = value.toArray();
+        if (array.size() >= 2)
+        {
+            points.append(QGeoCoordinate(array[1].toDouble(), array[0].toDouble()));
+        }
+    };
+
+    if (type == u"Point")
+    {
+        addPoint(coordinates);
+    }
+    if (type == u"LineString")
+    {
+        for(const auto& point : coordinates)
+        {
+            addPoint(point);
+        }
+    }
+    if (type == u"Polygon")
+    {
+        for(const auto& ring : coordinates)
+        {
+            for(const auto& point : ring.toArray())
+            {
+                addPoint(point);
+            }
+        }
+    }
+
+    if (points.isEmpty())
+    {
+        return {};
+    }
+    return QGeoRectangle(points);
+}
+
+// Simplifies a ring of GeoJSON coordinates using the Douglas-Peucker
+// algorithm. Distances are measured in degrees, which is good enough for
+// display purposes. Rings that would degenerate are returned unchanged.
+auto simplifyLinearRing(const QJsonArray& ring, double tolerance) -> QJsonArray
+{
+    auto size = ring.size();
+    if (size <= 4)
+    {
+        return ring;
+    }
+
+    QVector<QPointF> points;
+    points.reserve(size);
+    for(const auto& value : ring)
+    {
+        auto array = value.toArray();
+        points.append(QPointF(array[0].toDouble(), array[1].toDouble()));
+    }
+
+    auto distanceToSegment = [](QPointF p, QPointF a, QPointF b) {
+        auto ab = b-a;
+        auto lengthSquared = QPointF::dotProduct(ab, ab);
+        if (lengthSquared == 0.0)
+        {
+            auto ap = p-a;
+            return qSqrt(QPointF::dotProduct(ap, ap));
+        }
+        auto t = qBound(0.0, QPointF::dotProduct(p-a, ab)/lengthSquared, 1.0);
+        auto d = p-(a+t*ab);
+        return qSqrt(QPointF::dotProduct(d, d));
+    };
+
+    QVector<bool> keep(size, false);
+    keep[0] = true;
+    keep[size-1] = true;
+    QVector<QPair<qsizetype,qsizetype>> stack;
+    stack.append({0, size-1});
+    while(!stack.isEmpty())
+    {
+        auto [first, last] = stack.takeLast();
+        double maxDistance = 0.0;
+        qsizetype maxIndex = -1;
+        for(auto i=first+1; i<last; i++)
+        {
+            auto distance = distanceToSegment(points[i], points[first], points[last]);
+            if (distance > maxDistance)
+            {
+                maxDistance = distance;
+                maxIndex = i;
+            }
+        }
+        if (maxDistance > tolerance)
+        {
+            keep[maxIndex] = true;
+            stack.append({first, maxIndex});
+            stack.append({maxIndex, last});
+        }
+    }
+
+    QJsonArray result;
+    for(qsizetype i=0; i<size; i++)
+    {
+        if (keep[i])
+        {
+            result.append(ring[i]);
+        }
+    }
+    if (result.size() < 4)
+    {
+        return ring;
+    }
+    return result;
+}
+
+
 GeoMaps::GeoMapProvider::GeoMapProvider(QObject *parent)
     : GlobalObject(parent)
 {
@@ -274,6 +402,65 @@ auto GeoMaps::GeoMapProvider::emptyGeoJSON() -> QByteArray
     return geoDoc.toJson(QJsonDocument::JsonFormat::Compact);
 }
 
+auto GeoMaps::GeoMapProvider::geoJSONInRegion(const QGeoRectangle& boundingBox, int zoom) -> QByteArray
+{
+    if (!boundingBox.isValid())
+    {
+        return emptyGeoJSON();
+    }
+
+    // Tolerance of one pixel, for tiles of 512 pixel
+    zoom = qBound(0, zoom, 24);
+    auto tolerance = 360.0/(512.0*(1<<zoom));
+
+    QMutexLocker lock(&_aviationDataMutex);
+
+    // Find candidate features, using the spatial index. If the bounding box
+    // crosses the date line or covers a large part of the world, going
+    // through the grid does not pay off.
+    QVector<qsizetype> candidates;
+    auto minLat = qFloor(boundingBox.bottomLeft().latitude());
+    auto maxLat = qFloor(boundingBox.topRight().latitude());
+    auto minLon = qFloor(boundingBox.bottomLeft().longitude());
+    auto maxLon = qFloor(boundingBox.topRight().longitude());
+    if ((minLon > maxLon) || ((maxLat-minLat+1)*(maxLon-minLon+1) > _featureGrid_.size()))
+    {
+        candidates.reserve(_features_.size());
+        for(qsizetype i=0; i<_features_.size(); i++)
+        {
+            candidates.append(i);
+        }
+    }
+    else
+    {
+        for(auto lat=minLat; lat<=maxLat; lat++)
+        {
+            for(auto lon=minLon; lon<=maxLon; lon++)
+            {
+                candidates += _featureGrid_.value(gridCellKey(lat, lon));
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+
+    QJsonArray features;
+    for(auto index : candidates)
+    {
+        if (!_featureBoundingBoxes_[index].intersects(boundingBox))
+        {
+            continue;
+        }
+        features.append(simplifiedFeature(index, zoom, tolerance));
+    }
+
+    QJsonObject resultObject;
+    resultObject.insert(QStringLiteral("type"), "FeatureCollection");
+    resultObject.insert(QStringLiteral("features"), features);
+    QJsonDocument geoDoc(resultObject);
+    return geoDoc.toJson(QJsonDocument::JsonFormat::Compact);
+}
+
 auto GeoMaps::GeoMapProvider::filteredWaypoints(const QString &filter) -> QVector<GeoMaps::Waypoint>
 {
 
@@ -408,79 +595,33 @@ void GeoMaps::GeoMapProvider::onAviationMapsChanged()
 
 void GeoMaps::GeoMapProvider::onMBTILESChanged()
 {
-    terrainTileCache.clear();
-
-    qDeleteAll(m_baseMapRasterTiles);
-    m_baseMapRasterTiles.clear();
-    foreach(auto downloadableX, GlobalObject::dataManager()->baseMapsRaster()->downloadables())
-    {
-        auto *downloadable = qobject_cast<DataManagement::Downloadable_SingleFile*>(downloadableX);
-        if (downloadable == nullptr)
-        {
-            continue;
-        }
-        if (!downloadable->hasFile())
-        {
-            continue;
-        }
-
-        m_baseMapRasterTiles.append(new GeoMaps::MBTILES(downloadable->fileName(), this));
-    }
-    qDeleteAll(m_baseMapVectorTiles);
-    m_baseMapVectorTiles.clear();
-    foreach(auto downloadableX, GlobalObject::dataManager()->baseMapsVector()->downloadables())
+    // Open and close only those MBTILES files that have been added, removed or
+    // changed on disk. All others remain open.
+    auto rasterChanged = updateMBTILES(m_baseMapRasterTiles, GlobalObject::dataManager()->baseMapsRaster());
+    auto vectorChanged = updateMBTILES(m_baseMapVectorTiles, GlobalObject::dataManager()->baseMapsVector());
+    if (rasterChanged || vectorChanged)
     {
-        auto *downloadable = qobject_cast<DataManagement::Downloadable_SingleFile*>(downloadableX);
-        if (downloadable == nullptr)
-        {
-            continue;
-        }
-        if (!downloadable->hasFile())
-        {
-            continue;
-        }
-
-        m_baseMapVectorTiles.append(new GeoMaps::MBTILES(downloadable->fileName(), this));
+        emit baseMapTilesChanged();
     }
-    emit baseMapTilesChanged();
-
-    qDeleteAll(m_terrainMapTiles);
-    m_terrainMapTiles.clear();
-    foreach(auto downloadableX, GlobalObject::dataManager()->terrainMaps()->downloadables())
+    if (updateMBTILES(m_terrainMapTiles, GlobalObject::dataManager()->terrainMaps()))
     {
-        auto *downloadable = qobject_cast<DataManagement::Downloadable_SingleFile*>(downloadableX);
-        if (downloadable == nullptr)
-        {
-            continue;
-        }
-        if (!downloadable->hasFile())
-        {
-            continue;
-        }
-
-        m_terrainMapTiles.append(new GeoMaps::MBTILES(downloadable->fileName(), this));
+        terrainTileCache.clear();
+        emit terrainMapTilesChanged();
     }
-    emit terrainMapTilesChanged();
-
-    // Delete old style file, stop serving tiles
-    delete _styleFile;
-    _tileServer.removeMbtilesFileSet(_currentBaseMapPath);
-    _tileServer.removeMbtilesFileSet(_currentTerrainMapPath);
-    _currentBaseMapPath = QString::number(QRandomGenerator::global()->bounded(static_cast<quint32>(1000000000)));
-    _currentTerrainMapPath = QString::number(QRandomGenerator::global()->bounded(static_cast<quint32>(1000000000)));
 
+    // Find the set of base map tiles that will be served, and the matching style
+    QVector<QPointer<GeoMaps::MBTILES>> baseMapTiles;
     QFile file;
     if (GlobalObject::dataManager()->baseMaps()->hasFile())
     {
-        // Serve new tile set under new name
         if (!m_baseMapRasterTiles.isEmpty())
         {
-            _tileServer.addMbtilesFileSet(m_baseMapRasterTiles, _currentBaseMapPath);
+            baseMapTiles = m_baseMapRasterTiles;
             file.setFileName(QStringLiteral(":/flightMap/mapstyle-raster.json"));
         }
         else
         {
-            _tileServer.addMbtilesFileSet(m_baseMapVectorTiles, _currentBaseMapPath);
+            baseMapTiles = m_baseMapVectorTiles;
             file.setFileName(QStringLiteral(":/flightMap/osm-liberty.json"));
         }
     }
@@ -488,7 +629,26 @@ void GeoMaps::GeoMapProvider::onMBTILESChanged()
     {
         file.setFileName(QStringLiteral(":/flightMap/empty.json"));
     }
-    _tileServer.addMbtilesFileSet(m_terrainMapTiles, _currentTerrainMapPath);
+
+    // Serve tile sets under new names, but only if the served sets have really
+    // changed. Handlers of unchanged sets stay in place.
+    if (_currentBaseMapPath.isEmpty() || (baseMapTiles != _currentBaseMapTiles))
+    {
+        _tileServer.removeMbtilesFileSet(_currentBaseMapPath);
+        _currentBaseMapPath = QString::number(QRandomGenerator::global()->bounded(static_cast<quint32>(1000000000)));
+        _currentBaseMapTiles = baseMapTiles;
+        if (!baseMapTiles.isEmpty())
+        {
+            _tileServer.addMbtilesFileSet(baseMapTiles, _currentBaseMapPath);
+        }
+    }
+    if (_currentTerrainMapPath.isEmpty() || (m_terrainMapTiles != _currentTerrainMapTiles))
+    {
+        _tileServer.removeMbtilesFileSet(_currentTerrainMapPath);
+        _currentTerrainMapPath = QString::number(QRandomGenerator::global()->bounded(static_cast<quint32>(1000000000)));
+        _currentTerrainMapTiles = m_terrainMapTiles;
+        _tileServer.addMbtilesFileSet(m_terrainMapTiles, _currentTerrainMapPath);
+    }
 
     file.open(QIODevice::ReadOnly);
     QByteArray data = file.readAll();
@@ -502,6 +662,14 @@ void GeoMaps::GeoMapProvider::onMBTILESChanged()
         data.replace("%URLT%", (_tileServer.serverUrl()).toLatin1());
     }
     data.replace("%URL2%", _tileServer.serverUrl().toLatin1());
+
+    // Write a new style file only if the style has changed
+    if (!_styleFile.isNull() && (data == _currentStyleData))
+    {
+        return;
+    }
+    _currentStyleData = data;
+    delete _styleFile;
     _styleFile = new QTemporaryFile(this);
     _styleFile->open();
     _styleFile->write(data);
@@ -510,6 +678,77 @@ void GeoMaps::GeoMapProvider::onMBTILESChanged()
     emit styleFileURLChanged();
 }
 
+auto GeoMaps::GeoMapProvider::updateMBTILES(QList<QPointer<GeoMaps::MBTILES>>& mbtiles, DataManagement::Downloadable_MultiFile* downloadables) -> bool
+{
+    QStringList fileNames;
+    foreach(auto downloadableX, downloadables->downloadables())
+    {
+        auto *downloadable = qobject_cast<DataManagement::Downloadable_SingleFile*>(downloadableX);
+        if (downloadable == nullptr)
+        {
+            continue;
+        }
+        if (!downloadable->hasFile())
+        {
+            continue;
+        }
+        fileNames.append(downloadable->fileName());
+    }
+
+    bool changed = false;
+
+    // Close files that have been removed or changed on disk
+    for(auto it = mbtiles.begin(); it != mbtiles.end(); )
+    {
+        auto mbtPtr = *it;
+        if (mbtPtr.isNull() || !fileNames.contains(mbtPtr->fileName()) || mbtPtr->isOutdated())
+        {
+            delete mbtPtr;
+            it = mbtiles.erase(it);
+            changed = true;
+            continue;
+        }
+        fileNames.removeAll(mbtPtr->fileName());
+        it++;
+    }
+
+    // Open files that have been added
+    foreach(auto fileName, fileNames)
+    {
+        mbtiles.append(new GeoMaps::MBTILES(fileName, this));
+        changed = true;
+    }
+
+    return changed;
+}
+
+auto GeoMaps::GeoMapProvider::simplifiedFeature(qsizetype index, int zoom, double tolerance) -> QJsonObject
+{
+    auto feature = _features_[index];
+    auto geometry = feature[QStringLiteral("geometry")].toObject();
+    if (geometry[QStringLiteral("type")] != "Polygon")
+    {
+        return feature;
+    }
+
+    qint64 key = (static_cast<qint64>(index) << 5) + zoom;
+    auto* cached = _simplifiedFeatureCache_.object(key);
+    if (cached != nullptr)
+    {
+        return *cached;
+    }
+
+    QJsonArray rings;
+    foreach(auto ring, geometry[QStringLiteral("coordinates")].toArray())
+    {
+        rings.append(simplifyLinearRing(ring.toArray(), tolerance));
+    }
+    geometry.insert(QStringLiteral("coordinates"), rings);
+    feature.insert(QStringLiteral("geometry"), geometry);
+    _simplifiedFeatureCache_.insert(key, new QJsonObject(feature));
+    return feature;
+}
+
 void GeoMaps::GeoMapProvider::fillAviationDataCache(QStringList JSONFileNames, Units::Distance airspaceAltitudeLimit, bool hideGlidingSectors)
 {
     // Avoid rounding errors
@@ -592,6 +831,30 @@ void GeoMaps::GeoMapProvider::fillAviationDataCache(QStringList JSONFileNames, U
         newFeatures += object;
     }
 
+    // Build spatial index
+    QVector<QJsonObject> newFeatureVector;
+    QVector<QGeoRectangle> newFeatureBoundingBoxes;
+    QHash<int, QVector<qsizetype>> newFeatureGrid;
+    foreach(auto value, newFeatures)
+    {
+        auto feature = value.toObject();
+        auto box = featureBoundingBox(feature);
+        if (!box.isValid())
+        {
+            continue;
+        }
+        auto index = newFeatureVector.size();
+        newFeatureVector.append(feature);
+        newFeatureBoundingBoxes.append(box);
+        for(auto lat=qFloor(box.bottomLeft().latitude()); lat<=qFloor(box.topRight().latitude()); lat++)
+        {
+            for(auto lon=qFloor(box.bottomLeft().longitude()); lon<=qFloor(box.topRight().longitude()); lon++)
+            {
+                newFeatureGrid[gridCellKey(lat, lon)].append(index);
+            }
+        }
+    }
+
     QByteArray newGeoJSON;
     {
         QJsonObject resultObject;
@@ -608,6 +871,10 @@ void GeoMaps::GeoMapProvider::fillAviationDataCache(QStringList JSONFileNames, U
 
     _aviationDataMutex.lock();
     _airspaces_ = newAirspaces;
+    _features_ = newFeatureVector;
+    _featureBoundingBoxes_ = newFeatureBoundingBoxes;
+    _featureGrid_ = newFeatureGrid;
+    _simplifiedFeatureCache_.clear();
     if (_waypointsChanged)
     {
         _waypoints_ = newWaypoints;
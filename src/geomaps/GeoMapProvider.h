@@ -22,6 +22,7 @@
 
 #include <QCache>
 #include <QFuture>
+#include <QGeoRectangle>
 #include <QImage>
 #include <QTimer>
 #include <QTemporaryFile>
@@ -233,6 +234,24 @@ namespace GeoMaps
      */
     Q_INVOKABLE static QByteArray emptyGeoJSON();
 
+    /*! \brief Aviation data in a given region, in GeoJSON format
+     *
+     *  This method returns those features of the property geoJSON that meet
+     *  the given bounding box. Polygons are simplified with a tolerance of
+     *  roughly one screen pixel at the given zoom level, which makes the
+     *  document much smaller when large parts of the world are visible. The
+     *  features are found using a spatial index, and simplified geometries
+     *  are cached, so that repeated requests while the user pans the map are
+     *  cheap.
+     *
+     *  @param boundingBox Region of interest
+     *
+     *  @param zoom Zoom level of the map
+     *
+     *  @returns Valid GeoJSON document, possibly without features
+     */
+    Q_INVOKABLE QByteArray geoJSONInRegion(const QGeoRectangle& boundingBox, int zoom);
+
     /*! \brief Waypoints containing a given substring
      *
      * @param filter List of words
@@ -294,11 +313,21 @@ namespace GeoMaps
     // sets up the tile server to and generates a new style file.
     void onMBTILESChanged();
 
+    // Synchronizes a list of MBTILES with the files of a Downloadable_MultiFile.
+    // MBTILES whose files have been removed or changed on disk are deleted,
+    // new files are opened. Returns true if the list has changed.
+    bool updateMBTILES(QList<QPointer<GeoMaps::MBTILES>>& mbtiles, DataManagement::Downloadable_MultiFile* downloadables);
+
     // Interal function that does most of the work for aviationMapsChanged()
     // emits geoJSONChanged() when done. This function is meant to be run in a
     // separate thread.
     void fillAviationDataCache(QStringList JSONFileNames, Units::Distance airspaceAltitudeLimit, bool hideGlidingSectors);
 
+    // Returns the feature with the given index in _features_, with polygons
+    // simplified to the given tolerance. The caller must hold
+    // _aviationDataMutex.
+    QJsonObject simplifiedFeature(qsizetype index, int zoom, double tolerance);
+
     // Caches used to speed up the method simplifySpecialChars
     QRegularExpression specialChars{QStringLiteral("[^a-zA-Z0-9]")};
     QHash<QString, QString> simplifySpecialChars_cache;
@@ -309,11 +338,16 @@ namespace GeoMaps
     QString _currentBaseMapPath;
     QString _currentTerrainMapPath;
 
+    // Sets of MBTILES currently served under the paths above
+    QVector<QPointer<GeoMaps::MBTILES>> _currentBaseMapTiles;
+    QVector<QPointer<GeoMaps::MBTILES>> _currentTerrainMapTiles;
+
     // Tile Server
     TileServer _tileServer;
 
-    // Temporary file that holds the current style file
+    // Temporary file that holds the current style file, and its content
     QPointer<QTemporaryFile> _styleFile;
+    QByteArray _currentStyleData;
 
     //
     // Aviation Data Cache
@@ -336,6 +370,16 @@ namespace GeoMaps
     QList<Waypoint> _waypoints_; // Cache: Waypoints
     QList<Airspace> _airspaces_; // Cache: Airspaces
 
+    // Spatial index for the features in _combinedGeoJSON_. The grid maps
+    // cells of one degree by one degree to the indices of all features whose
+    // bounding box meets the cell.
+    QVector<QJsonObject> _features_;
+    QVector<QGeoRectangle> _featureBoundingBoxes_;
+    QHash<int, QVector<qsizetype>> _featureGrid_;
+
+    // Cache: simplified features, keyed by feature index and zoom level
+    QCache<qint64,QJsonObject> _simplifiedFeatureCache_ {20000};
+
     // TerrainImageCache
     QCache<qint64,QImage> terrainTileCache {6}; // Hold 6 tiles, roughly 1.2MB
 
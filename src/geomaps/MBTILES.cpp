@@ -18,70 +18,70 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
-#include <QSqlDatabase>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
 #include <QSqlQuery>
+#include <QStandardPaths>
 #include <QVariant>
 
 #include "geomaps/MBTILES.h"
 
+
+// Persistent catalog of MBTILES metadata, shared by all instances of the class
+// and protected by catalogMutex. The catalog is read from disk when first used.
+QMutex catalogMutex;
+QJsonObject catalog;
+bool catalogLoaded {false};
+
+auto catalogFileName() -> QString
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)+"/mbtilesCatalog.json";
+}
+
+
 GeoMaps::MBTILES::MBTILES(const QString& fileName, QObject *parent)
     : QObject(parent), m_fileName(fileName)
 {
     m_databaseConnectionName = QStringLiteral("GeoMaps::MBTILES::format %1,%2").arg(fileName).arg((quintptr)this);
-    auto m_dataBase = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_databaseConnectionName);
-    m_dataBase.setDatabaseName(fileName);
-    m_dataBase.open();
 
-    QSqlQuery query(m_dataBase);
-    if (query.exec(QStringLiteral("select name, value from metadata;")))
+    QFileInfo info(fileName);
+    m_fileSize = info.size();
+    m_fileLastModified = info.lastModified();
+
+    if (!readMetaDataFromCatalog())
     {
-        while(query.next())
-        {
-            QString key = query.value(0).toString();
-            QString value = query.value(1).toString();
-            m_metadata.insert(key, value);
-        }
+        readMetaDataFromDatabase();
+        writeMetaDataToCatalog();
     }
 }
 
 GeoMaps::MBTILES::~MBTILES()
 {
-    QSqlDatabase::database(m_databaseConnectionName).close();
-    QSqlDatabase::removeDatabase(m_databaseConnectionName);
+    if (m_databaseOpened)
+    {
+        QSqlDatabase::database(m_databaseConnectionName).close();
+        QSqlDatabase::removeDatabase(m_databaseConnectionName);
+    }
 }
 
 auto GeoMaps::MBTILES::attribution() -> QString
 {
-    auto m_dataBase = QSqlDatabase::database(m_databaseConnectionName);
-    QSqlQuery query(m_dataBase);
-    if (query.exec(QStringLiteral("select name, value from metadata where name='attribution';")))
-    {
-        if (query.first())
-        {
-            return query.value(1).toString();
-        }
-    }
-    return {};
+    return m_metadata.value(QStringLiteral("attribution"));
 }
 
 auto GeoMaps::MBTILES::format() -> GeoMaps::MBTILES::Format
 {
-    auto m_dataBase = QSqlDatabase::database(m_databaseConnectionName);
-    QSqlQuery query(m_dataBase);
-    if (query.exec(QStringLiteral("select name, value from metadata where name='format';")))
+    auto format = m_metadata.value(QStringLiteral("format"));
+    if (format == QLatin1String("pbf"))
     {
-        if (query.first())
-        {
-            auto format = query.value(1).toString();
-            if (format == QLatin1String("pbf"))
-            {
-                return Vector;
-            }
-            if ((format == QLatin1String("jpg")) || (format == QLatin1String("png")) || (format == QLatin1String("webp")))
-            {
-                return Raster;
-            }
-        }
+        return Vector;
+    }
+    if ((format == QLatin1String("jpg")) || (format == QLatin1String("png")) || (format == QLatin1String("webp")))
+    {
+        return Raster;
     }
     return Unknown;
 }
@@ -90,22 +90,13 @@ auto GeoMaps::MBTILES::info() -> QString
 {
     QString result;
 
-    // Read metadata from database
-    auto m_dataBase = QSqlDatabase::database(m_databaseConnectionName);
-    QSqlQuery query(m_dataBase);
     QString intResult;
-    if (query.exec(QStringLiteral("select name, value from metadata;")))
+    QMapIterator<QString, QString> iterator(m_metadata);
+    while (iterator.hasNext())
     {
-        while (query.next())
-        {
-            QString key = query.value(0).toString();
-            if (key == u"json")
-            {
-                continue;
-            }
-            intResult += QStringLiteral("<tr><td><strong>%1 :&nbsp;&nbsp;</strong></td><td>%2</td></tr>")
-                    .arg(key, query.value(1).toString());
-        }
+        iterator.next();
+        intResult += QStringLiteral("<tr><td><strong>%1 :&nbsp;&nbsp;</strong></td><td>%2</td></tr>")
+                .arg(iterator.key(), iterator.value());
     }
     if (!intResult.isEmpty())
     {
@@ -116,10 +107,16 @@ auto GeoMaps::MBTILES::info() -> QString
 }
 
 
+auto GeoMaps::MBTILES::isOutdated() const -> bool
+{
+    QFileInfo info(m_fileName);
+    return !info.exists() || (info.size() != m_fileSize) || (info.lastModified() != m_fileLastModified);
+}
+
+
 auto GeoMaps::MBTILES::tile(int zoom, int x, int y) -> QByteArray
 {
-    auto m_dataBase = QSqlDatabase::database(m_databaseConnectionName);
-    QSqlQuery query(m_dataBase);
+    QSqlQuery query(database());
     auto yflipped = (1<<zoom)-1-y;
     auto queryString = QStringLiteral("select tile_data from tiles where zoom_level=%1 and tile_row=%3 and tile_column=%2;").arg(zoom).arg(x).arg(yflipped);
     if (query.exec(queryString))
@@ -132,3 +129,111 @@ auto GeoMaps::MBTILES::tile(int zoom, int x, int y) -> QByteArray
 
     return {};
 }
+
+
+//
+// Private methods
+//
+
+auto GeoMaps::MBTILES::database() -> QSqlDatabase
+{
+    if (!m_databaseOpened)
+    {
+        auto dataBase = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_databaseConnectionName);
+        dataBase.setDatabaseName(m_fileName);
+        dataBase.open();
+        m_databaseOpened = true;
+        return dataBase;
+    }
+    return QSqlDatabase::database(m_databaseConnectionName);
+}
+
+void GeoMaps::MBTILES::readMetaDataFromDatabase()
+{
+    QSqlQuery query(database());
+    if (query.exec(QStringLiteral("select name, value from metadata;")))
+    {
+        while(query.next())
+        {
+            QString key = query.value(0).toString();
+            if (key == u"json")
+            {
+                continue;
+            }
+            QString value = query.value(1).toString();
+            m_metadata.insert(key, value);
+        }
+    }
+}
+
+auto GeoMaps::MBTILES::readMetaDataFromCatalog() -> bool
+{
+    QMutexLocker locker(&catalogMutex);
+    if (!catalogLoaded)
+    {
+        QFile file(catalogFileName());
+        if (file.open(QIODevice::ReadOnly))
+        {
+            catalog = QJsonDocument::fromJson(file.readAll()).object();
+        }
+        catalogLoaded = true;
+    }
+
+    auto entry = catalog.value(m_fileName).toObject();
+    if (entry.isEmpty())
+    {
+        return false;
+    }
+    if ((entry.value(QStringLiteral("size")).toInteger(-1) != m_fileSize) ||
+        (entry.value(QStringLiteral("lastModified")).toInteger(-1) != m_fileLastModified.toMSecsSinceEpoch()))
+    {
+        return false;
+    }
+
+    auto metadata = entry.value(QStringLiteral("metadata")).toObject();
+    for(auto it = metadata.constBegin(); it != metadata.constEnd(); it++)
+    {
+        m_metadata.insert(it.key(), it.value().toString());
+    }
+    return true;
+}
+
+void GeoMaps::MBTILES::writeMetaDataToCatalog() const
+{
+    // Do not record files that could not be read
+    if (m_metadata.isEmpty())
+    {
+        return;
+    }
+
+    QJsonObject metadata;
+    QMapIterator<QString, QString> iterator(m_metadata);
+    while (iterator.hasNext())
+    {
+        iterator.next();
+        metadata.insert(iterator.key(), iterator.value());
+    }
+
+    QJsonObject entry;
+    entry.insert(QStringLiteral("size"), m_fileSize);
+    entry.insert(QStringLiteral("lastModified"), m_fileLastModified.toMSecsSinceEpoch());
+    entry.insert(QStringLiteral("metadata"), metadata);
+
+    QMutexLocker locker(&catalogMutex);
+    catalog.insert(m_fileName, entry);
+
+    // Forget about files that no longer exist
+    foreach(auto key, catalog.keys())
+    {
+        if (!QFile::exists(key))
+        {
+            catalog.remove(key);
+        }
+    }
+
+    QFile file(catalogFileName());
+    if (file.open(QIODevice::WriteOnly))
+    {
+        file.write(QJsonDocument(catalog).toJson(QJsonDocument::Compact));
+    }
+}
@@ -20,7 +20,9 @@
 
 #pragma once
 
+#include <QDateTime>
 #include <QMap>
+#include <QSqlDatabase>
 
 namespace GeoMaps
 {
@@ -30,6 +32,11 @@ namespace GeoMaps
    *  MBTILES contain tiled map data. Internally, MBTILES are SQLite databases
    *  whose schema is specified here: https://github.com/mapbox/mbtiles-spec
    *  This class handles MBTILES and allows easy access to the data.
+   *
+   *  The metadata of all MBTILES files is kept in a small persistent catalog,
+   *  keyed by file name, size and modification time. If the catalog holds
+   *  valid metadata for a file, the SQLite database is not opened before a
+   *  tile is actually requested.
    */
 
   class MBTILES : public QObject
@@ -87,6 +94,14 @@ namespace GeoMaps
      */
     [[nodiscard]] QString info();
 
+    /*! \brief Check if the file has changed on disk
+     *
+     *  @returns True if size or modification time of the file differ from the
+     *  values found when this instance was constructed, or if the file no
+     *  longer exists.
+     */
+    [[nodiscard]] bool isOutdated() const;
+
     /*! \brief Retrieve tile from an MBTILES file
      *
      *  @param zoom Zoom level of the tile
@@ -103,7 +118,8 @@ namespace GeoMaps
     /*! \brief Retrieve metadata of the MBTILES file
      *
      *  MBTILES files contain metadata, in the form of a list of key/value
-     *  pairs.
+     *  pairs. The entry "json", which can be very large for vector maps, is
+     *  not included.
      *
      *  @returns A QMap containing the metadata, or an empty QMap on error.
      */
@@ -125,12 +141,33 @@ namespace GeoMaps
     //
     Q_DISABLE_COPY_MOVE(MBTILES)
 
+    // Opens the database, if this has not been done before, and returns the
+    // connection
+    QSqlDatabase database();
+
+    // Reads the metadata table of the database into m_metadata
+    void readMetaDataFromDatabase();
+
+    // Looks up the persistent catalog. If the catalog holds an entry for this
+    // file that matches size and modification time, copies the metadata to
+    // m_metadata and returns true.
+    bool readMetaDataFromCatalog();
+
+    // Adds m_metadata to the persistent catalog
+    void writeMetaDataToCatalog() const;
+
     // Name of the MBTILES file
     QString m_fileName;
 
+    // Size and modification time of the file, at the time of construction
+    qint64 m_fileSize {-1};
+    QDateTime m_fileLastModified;
+
     // Name of the data base connection. This name is unique to each instance of
-    // this class, and should therefore not be copied.
+    // this class, and should therefore not be copied. The database is opened
+    // lazily.
     QString m_databaseConnectionName;
+    bool m_databaseOpened {false};
     QMap<QString, QString> m_metadata;
   };
 
@@ -18,7 +18,10 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <QBuffer>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QImage>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -28,7 +31,7 @@
 
 #include "TileHandler.h"
 
-QRegularExpression tileQueryPattern(QStringLiteral("[0-9]{1,2}/[0-9]{1,4}/[0-9]{1,4}"));
+QRegularExpression tileQueryPattern(QStringLiteral("[0-9]{1,2}/[0-9]{1,6}/[0-9]{1,6}"));
 
 GeoMaps::TileHandler::TileHandler(const QVector<QPointer<GeoMaps::MBTILES>>& mbtileFiles, const QString& baseURL, QObject *parent)
     : Handler(parent)
@@ -73,6 +76,7 @@ void GeoMaps::TileHandler::process(QHttpEngine::Socket *socket, const QString &p
     // Serve tileJSON file, if requested
     if (path.isEmpty() || path.endsWith(QLatin1String("json"), Qt::CaseInsensitive))
     {
+        m_tileJSONRequests.fetch_add(1, std::memory_order_relaxed);
         socket->setHeader("Content-Type", "application/json");
         QByteArray json = tileJSON();
         socket->setHeader("Content-Length", QByteArray::number(json.length()));
@@ -90,21 +94,31 @@ void GeoMaps::TileHandler::process(QHttpEngine::Socket *socket, const QString &p
         auto x = path.section('/', 2, 2).toInt();
         auto y = path.section('/', 3, 3).section('.', 0, 0).toInt();
 
-        foreach(auto mbtilesPtr, m_mbtiles)
+        QElapsedTimer timer;
+        timer.start();
+        QByteArray tileData = tileFromFiles(z, x, y);
+        if (tileData.isEmpty())
         {
-            if (mbtilesPtr.isNull())
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            if (isRaster() && (z > _maxzoom))
             {
-                continue;
-            }
-
-            // Get data
-            QByteArray tileData = mbtilesPtr->tile(z,x,y);
-            if (tileData.isEmpty())
-            {
-                continue;
+                tileData = synthesizedTile(z, x, y);
+                if (!tileData.isEmpty())
+                {
+                    m_synthesized.fetch_add(1, std::memory_order_relaxed);
+                }
             }
+        }
+        else
+        {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_lookupLatency.add(timer.nsecsElapsed());
 
+        if (!tileData.isEmpty())
+        {
             // Set the headers and write the content
+            timer.restart();
             socket->setHeader("Content-Type", "application/octet-stream");
             if (_format == QLatin1String("pbf"))
             {
@@ -113,16 +127,36 @@ void GeoMaps::TileHandler::process(QHttpEngine::Socket *socket, const QString &p
             socket->setHeader("Content-Length", QByteArray::number(tileData.length()));
             socket->write(tileData);
             socket->close();
+            m_bytesServed.fetch_add(static_cast<quint64>(tileData.length()), std::memory_order_relaxed);
+            m_writeLatency.add(timer.nsecsElapsed());
             return;
         }
     }
 
     // Unknown request, responding with 'not found'
+    m_notFound.fetch_add(1, std::memory_order_relaxed);
     socket->writeError(QHttpEngine::Socket::NotFound);
     socket->close();
 }
 
 
+auto GeoMaps::TileHandler::statistics() const -> QJsonObject
+{
+    QJsonObject result;
+    result.insert(QStringLiteral("name"), _name);
+    result.insert(QStringLiteral("format"), _format);
+    result.insert(QStringLiteral("hits"), static_cast<qint64>(m_hits.load(std::memory_order_relaxed)));
+    result.insert(QStringLiteral("misses"), static_cast<qint64>(m_misses.load(std::memory_order_relaxed)));
+    result.insert(QStringLiteral("synthesized"), static_cast<qint64>(m_synthesized.load(std::memory_order_relaxed)));
+    result.insert(QStringLiteral("notFound"), static_cast<qint64>(m_notFound.load(std::memory_order_relaxed)));
+    result.insert(QStringLiteral("bytesServed"), static_cast<qint64>(m_bytesServed.load(std::memory_order_relaxed)));
+    result.insert(QStringLiteral("tileJSONRequests"), static_cast<qint64>(m_tileJSONRequests.load(std::memory_order_relaxed)));
+    result.insert(QStringLiteral("lookupLatency"), m_lookupLatency.toJSON());
+    result.insert(QStringLiteral("writeLatency"), m_writeLatency.toJSON());
+    return result;
+}
+
+
 auto GeoMaps::TileHandler::tileJSON() const -> QByteArray
 {
     QJsonObject result;
@@ -159,7 +193,7 @@ auto GeoMaps::TileHandler::tileJSON() const -> QByteArray
     }
     if (_maxzoom >= 0)
     {
-        result.insert(QStringLiteral("maxzoom"), _maxzoom);
+        result.insert(QStringLiteral("maxzoom"), isRaster() ? _maxzoom+maxOverzoom : _maxzoom);
     }
     if (_minzoom >= 0)
     {
@@ -170,3 +204,89 @@ auto GeoMaps::TileHandler::tileJSON() const -> QByteArray
     tileJSONDocument.setObject(result);
     return tileJSONDocument.toJson();
 }
+
+
+auto GeoMaps::TileHandler::isRaster() const -> bool
+{
+    return (_format == QLatin1String("png")) || (_format == QLatin1String("jpg")) || (_format == QLatin1String("webp"));
+}
+
+
+auto GeoMaps::TileHandler::tileFromFiles(int zoom, int x, int y) -> QByteArray
+{
+    foreach(auto mbtilesPtr, m_mbtiles)
+    {
+        if (mbtilesPtr.isNull())
+        {
+            continue;
+        }
+
+        QByteArray tileData = mbtilesPtr->tile(zoom, x, y);
+        if (!tileData.isEmpty())
+        {
+            return tileData;
+        }
+    }
+    return {};
+}
+
+
+auto GeoMaps::TileHandler::synthesizedTile(int zoom, int x, int y) -> QByteArray
+{
+    if (zoom > _maxzoom+maxOverzoom)
+    {
+        return {};
+    }
+
+    quint64 key = (static_cast<quint64>(zoom) << 48) + (static_cast<quint64>(x) << 24) + static_cast<quint64>(y);
+    auto* cached = m_synthesizedTileCache.object(key);
+    if (cached != nullptr)
+    {
+        return *cached;
+    }
+
+    // Find nearest ancestor
+    for(int ancestorZoom = qMin(zoom-1, _maxzoom); ancestorZoom >= qMax(0, zoom-maxOverzoom); ancestorZoom--)
+    {
+        auto dz = zoom-ancestorZoom;
+        auto ancestorData = tileFromFiles(ancestorZoom, x >> dz, y >> dz);
+        if (ancestorData.isEmpty())
+        {
+            continue;
+        }
+
+        QImage ancestor;
+        if (!ancestor.loadFromData(ancestorData) || (ancestor.width() != ancestor.height()))
+        {
+            return {};
+        }
+
+        // Crop the part of the ancestor that covers the requested tile, and
+        // scale it up. Terrain data encodes elevation in the color channels,
+        // which must not be interpolated.
+        auto size = ancestor.width();
+        auto cropSize = qMax(1, size >> dz);
+        auto mask = (1 << dz) - 1;
+        auto cropped = ancestor.copy((x & mask)*cropSize, (y & mask)*cropSize, cropSize, cropSize);
+        auto transformation = _encoding.isEmpty() ? Qt::SmoothTransformation : Qt::FastTransformation;
+        auto image = cropped.scaled(size, size, Qt::IgnoreAspectRatio, transformation);
+
+        QByteArray result;
+        QBuffer buffer(&result);
+        buffer.open(QIODevice::WriteOnly);
+        if ((_format == QLatin1String("jpg")) && _encoding.isEmpty())
+        {
+            image.save(&buffer, "JPG", 90);
+        }
+        else
+        {
+            image.save(&buffer, "PNG");
+        }
+        buffer.close();
+
+        m_synthesizedTileCache.insert(key, new QByteArray(result), qMax(1, static_cast<int>(result.size()/1024)));
+        return result;
+    }
+
+    return {};
+}
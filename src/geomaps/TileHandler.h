@@ -20,12 +20,16 @@
 
 #pragma once
 
+#include <QCache>
 #include <QVector>
 
+#include <atomic>
+
 #include <qhttpengine/handler.h>
 
 #include <dataManagement/Downloadable_SingleFile.h>
 #include <geomaps/MBTILES.h>
+#include "LatencyHistogram.h"
 
 
 namespace GeoMaps {
@@ -39,6 +43,11 @@ namespace GeoMaps {
   TileJSON Specification 2.2.0 found
   https://github.com/mapbox/tilejson-spec/tree/master/2.2.0) is served at the
   URL whose names is set in the baseURLName argument of the constructor.
+
+  For raster and terrain data, the handler synthesizes tiles above the maximal
+  zoom level of the mbtile files, by cropping and upsampling the nearest
+  available ancestor tile. The TileJSON announces these additional zoom
+  levels. Synthesized tiles are kept in a small LRU cache.
 */
 
 class TileHandler : public QHttpEngine::Handler
@@ -105,7 +114,8 @@ public:
   
   /*! \brief Maxzoom property, as found in the metadata table of the mbtile file
     
-    This property is set to -1 if no maxversion is found.
+    This property is set to -1 if no maxversion is found. For raster and
+    terrain data, the TileJSON announces maxOverzoom additional levels.
   */
   Q_PROPERTY(int maxzoom READ maxzoom CONSTANT)
 
@@ -175,6 +185,19 @@ public:
     @returns Property version
   */
   [[nodiscard]] auto version() const -> QString {return _version;}
+
+  /*! \brief Request statistics
+    
+    The handler counts tiles served from the mbtile files (hits), tiles that
+    were not found in the files (misses), synthesized tiles, requests answered
+    with 'not found' and the number of bytes served. Latencies are recorded
+    separately for the database lookup (including synthesis) and for writing
+    the reply to the socket. The overhead is a few atomic increments per
+    request.
+
+    @returns JSON object with statistics
+  */
+  [[nodiscard]] auto statistics() const -> QJsonObject;
   
 protected:
   /*
@@ -186,7 +209,34 @@ protected:
 private:
   Q_DISABLE_COPY_MOVE(TileHandler)
 
+  // Number of zoom levels above maxzoom for which raster tiles are synthesized
+  static constexpr int maxOverzoom = 4;
+
+  // True if the tiles contain raster data, which can be upsampled
+  [[nodiscard]] auto isRaster() const -> bool;
+
+  // Returns the tile from the first mbtile file that contains it, or an empty
+  // QByteArray if no file contains the tile
+  [[nodiscard]] auto tileFromFiles(int zoom, int x, int y) -> QByteArray;
+
+  // Synthesizes a tile from the nearest available ancestor tile. Returns an
+  // empty QByteArray if no ancestor is found.
+  [[nodiscard]] auto synthesizedTile(int zoom, int x, int y) -> QByteArray;
+
   QVector<QPointer<GeoMaps::MBTILES>> m_mbtiles;
+
+  // LRU cache for synthesized tiles, with cost measured in kB
+  QCache<quint64, QByteArray> m_synthesizedTileCache {8*1024};
+
+  // Statistics
+  std::atomic<quint64> m_hits {0};
+  std::atomic<quint64> m_misses {0};
+  std::atomic<quint64> m_synthesized {0};
+  std::atomic<quint64> m_notFound {0};
+  std::atomic<quint64> m_bytesServed {0};
+  std::atomic<quint64> m_tileJSONRequests {0};
+  LatencyHistogram m_lookupLatency;
+  LatencyHistogram m_writeLatency;
   
   QString _name;
   QString _encoding;
@@ -30,7 +30,15 @@
 GeoMaps::TileServer::TileServer(QUrl baseUrl, QObject *parent)
     : QHttpEngine::Server(parent), _baseUrl(std::move(baseUrl))
 {
-    setUpTileHandlers();
+    // Static content and GeoJSON
+    fileSystemHandler = new QHttpEngine::FilesystemHandler(QStringLiteral(":"), this);
+    fileSystemHandler->addRedirect(QRegExp("^$"), QStringLiteral("/index.html"));
+    auto* geoJSONHandler = new GeoJSONHandler(fileSystemHandler);
+    fileSystemHandler->addSubHandler(QRegExp("^aviation"), geoJSONHandler);
+
+    // Tile sets are dispatched by the root handler
+    rootHandler = new TileServerHandler(fileSystemHandler, this);
+    setHandler(rootHandler);
 }
 
 
@@ -45,46 +53,32 @@ auto GeoMaps::TileServer::serverUrl() const -> QString
 
 void GeoMaps::TileServer::addMbtilesFileSet(const QVector<QPointer<GeoMaps::MBTILES>>& baseMapsWithFiles, const QString& baseName)
 {
+    if (mbtileFileNameSets.contains(baseName) && (mbtileFileNameSets.value(baseName) == baseMapsWithFiles))
+    {
+        return;
+    }
+
     mbtileFileNameSets[baseName] = baseMapsWithFiles;
-    setUpTileHandlers();
+    rootHandler->insertTileHandler(baseName, new TileHandler(baseMapsWithFiles, tileSetURL(baseName)));
 }
 
 
 void GeoMaps::TileServer::removeMbtilesFileSet(const QString& path)
 {
+    if (!mbtileFileNameSets.contains(path))
+    {
+        return;
+    }
+
     mbtileFileNameSets.remove(path);
-    setUpTileHandlers();
+    rootHandler->removeTileHandler(path);
 }
 
 
-void GeoMaps::TileServer::setUpTileHandlers()
+auto GeoMaps::TileServer::tileSetURL(const QString& baseName) const -> QString
 {
-    // Create new file system handler and delete old one
-    auto* newFileSystemHandler = new QHttpEngine::FilesystemHandler(QStringLiteral(":"), this);
-    newFileSystemHandler->addRedirect(QRegExp("^$"), QStringLiteral("/index.html"));
-    setHandler(newFileSystemHandler);
-    delete currentFileSystemHandler;
-    currentFileSystemHandler = newFileSystemHandler;
-
-    // Now add a subhandlers for each GeoJSON
-    auto* geoJSONHandlet = new GeoJSONHandler(newFileSystemHandler);
-    newFileSystemHandler->addSubHandler(QRegExp("^aviation"), geoJSONHandlet);
-
-    // Now add subhandlers for each tile
-    QMapIterator<QString, QVector<QPointer<GeoMaps::MBTILES>>> iterator(mbtileFileNameSets);
-    while (iterator.hasNext()) {
-        iterator.next();
-
-        // Find base name of the file
-        QString URL;
-        if (_baseUrl.isEmpty()) {
-            URL = serverUrl()+"/"+iterator.key();
-        } else {
-            URL = _baseUrl.toString()+"/"+iterator.key();
-        }
-
-        auto* handler = new TileHandler(iterator.value(), URL, newFileSystemHandler);
-        newFileSystemHandler->addSubHandler(QRegExp("^"+iterator.key()), handler);
+    if (_baseUrl.isEmpty()) {
+        return serverUrl()+"/"+baseName;
     }
-
+    return _baseUrl.toString()+"/"+baseName;
 }
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "geomaps/MBTILES.h"
+#include "geomaps/TileServerHandler.h"
 #include <qhttpengine/filesystemhandler.h>
 #include <qhttpengine/server.h>
 
@@ -49,6 +50,9 @@ namespace GeoMaps {
   containing openstreetmap data and one set with raster data used for
   hillshading. Each set contains two MBTiles files, one for Africa and one for
   Europe.
+
+  For debugging, request statistics of all tile sets are available under
+  serverUrl()+"/stats" (JSON) and serverUrl()+"/stats.html" (human-readable).
 */
 
 class TileServer : public QHttpEngine::Server
@@ -107,6 +111,9 @@ public slots:
     files.
      
     @param baseName The path under which the tiles willconst be available.
+
+    If a set with the same name and the same files is already served, this
+    method does nothing. Handlers of other sets are never touched.
   */
   void addMbtilesFileSet(const QVector<QPointer<GeoMaps::MBTILES>>& baseMapsWithFiles, const QString& baseName);
 
@@ -119,9 +126,12 @@ public slots:
 private:
   Q_DISABLE_COPY_MOVE(TileServer)
 
-  void setUpTileHandlers();
-  
-  QPointer<QHttpEngine::FilesystemHandler> currentFileSystemHandler;
+  // URL of a tile set, as announced in its TileJSON
+  [[nodiscard]] auto tileSetURL(const QString& baseName) const -> QString;
+
+  // The handlers are set up once, in the constructor
+  QPointer<QHttpEngine::FilesystemHandler> fileSystemHandler;
+  QPointer<GeoMaps::TileServerHandler> rootHandler;
   
   QMap<QString,QVector<QPointer<GeoMaps::MBTILES>>> mbtileFileNameSets;
   
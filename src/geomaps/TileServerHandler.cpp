@@ -0,0 +1,139 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QJsonDocument>
+
+#include <qhttpengine/socket.h>
+
+#include "TileServerHandler.h"
+
+
+GeoMaps::TileServerHandler::TileServerHandler(QHttpEngine::Handler* fallbackHandler, QObject* parent)
+    : Handler(parent), m_fallbackHandler(fallbackHandler)
+{
+}
+
+
+void GeoMaps::TileServerHandler::insertTileHandler(const QString& name, GeoMaps::TileHandler* handler)
+{
+    removeTileHandler(name);
+    handler->setParent(this);
+    m_tileHandlers.insert(name, handler);
+}
+
+
+void GeoMaps::TileServerHandler::removeTileHandler(const QString& name)
+{
+    auto handler = m_tileHandlers.take(name);
+    if (!handler.isNull())
+    {
+        handler->deleteLater();
+    }
+}
+
+
+auto GeoMaps::TileServerHandler::statistics() const -> QJsonObject
+{
+    QJsonObject result;
+    QMapIterator<QString, QPointer<GeoMaps::TileHandler>> iterator(m_tileHandlers);
+    while (iterator.hasNext())
+    {
+        iterator.next();
+        if (iterator.value().isNull())
+        {
+            continue;
+        }
+        result.insert(iterator.key(), iterator.value()->statistics());
+    }
+    return result;
+}
+
+
+auto GeoMaps::TileServerHandler::statisticsHTML() const -> QByteArray
+{
+    QString result = QStringLiteral("<html><head><meta http-equiv='refresh' content='2'><title>Tile server statistics</title></head><body>");
+    auto stats = statistics();
+    foreach(auto key, stats.keys())
+    {
+        auto set = stats.value(key).toObject();
+        result += QStringLiteral("<h3>%1 (%2, %3)</h3>").arg(key, set.value(QStringLiteral("name")).toString(), set.value(QStringLiteral("format")).toString());
+        result += QStringLiteral("<table>");
+        const QStringList counters {QStringLiteral("hits"), QStringLiteral("misses"), QStringLiteral("synthesized"), QStringLiteral("notFound"), QStringLiteral("bytesServed"), QStringLiteral("tileJSONRequests")};
+        for(const auto& counter : counters)
+        {
+            result += QStringLiteral("<tr><td>%1</td><td>%2</td></tr>").arg(counter).arg(set.value(counter).toInteger());
+        }
+        const QStringList histograms {QStringLiteral("lookupLatency"), QStringLiteral("writeLatency")};
+        for(const auto& histogram : histograms)
+        {
+            auto hist = set.value(histogram).toObject();
+            result += QStringLiteral("<tr><td>%1</td><td>mean %2 µs, p50 &lt; %3 µs, p99 &lt; %4 µs</td></tr>")
+                          .arg(histogram)
+                          .arg(hist.value(QStringLiteral("meanMicroseconds")).toDouble(), 0, 'f', 1)
+                          .arg(hist.value(QStringLiteral("p50Microseconds")).toInteger())
+                          .arg(hist.value(QStringLiteral("p99Microseconds")).toInteger());
+        }
+        result += QStringLiteral("</table>");
+    }
+    result += QStringLiteral("</body></html>");
+    return result.toUtf8();
+}
+
+
+void GeoMaps::TileServerHandler::process(QHttpEngine::Socket *socket, const QString &path)
+{
+    // Serve statistics, if requested
+    if ((path == u"stats") || (path == u"stats.html"))
+    {
+        QByteArray data;
+        if (path == u"stats")
+        {
+            socket->setHeader("Content-Type", "application/json");
+            data = QJsonDocument(statistics()).toJson();
+        }
+        else
+        {
+            socket->setHeader("Content-Type", "text/html; charset=utf-8");
+            data = statisticsHTML();
+        }
+        socket->setHeader("Content-Length", QByteArray::number(data.length()));
+        socket->write(data);
+        socket->close();
+        return;
+    }
+
+    auto name = path.section('/', 0, 0);
+    auto handler = m_tileHandlers.value(name);
+    if (!handler.isNull())
+    {
+        handler->route(socket, path.mid(name.size()));
+        return;
+    }
+
+    if (!m_fallbackHandler.isNull())
+    {
+        m_fallbackHandler->route(socket, path);
+        return;
+    }
+
+    // Unknown request, responding with 'not found'
+    socket->writeError(QHttpEngine::Socket::NotFound);
+    socket->close();
+}
@@ -0,0 +1,105 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QMap>
+#include <QPointer>
+
+#include <qhttpengine/handler.h>
+
+#include "geomaps/TileHandler.h"
+
+
+namespace GeoMaps {
+
+
+/*! \brief Root handler of the TileServer
+ *
+ *  This class dispatches incoming requests. Requests whose first path
+ *  component is the name of a tile set are forwarded to the TileHandler
+ *  registered under that name. All other requests are forwarded to a fallback
+ *  handler, which serves static content and GeoJSON.
+ *
+ *  Unlike the sub-handlers of QHttpEngine::Handler, tile handlers can be
+ *  removed at any time. This allows the TileServer to add and remove tile sets
+ *  without tearing down the handlers that remain in use.
+ *
+ *  The handler also serves request statistics of all tile sets, in JSON
+ *  format under the path "stats" and as a human-readable debug page under
+ *  the path "stats.html".
+ */
+
+class TileServerHandler : public QHttpEngine::Handler
+{
+  Q_OBJECT
+
+public:
+  /*! \brief Create a new root handler
+   *
+   *  @param fallbackHandler Handler for requests that do not refer to a tile
+   *  set. The handler is not owned by this class.
+   *
+   *  @param parent The standard QObject parent
+   */
+  explicit TileServerHandler(QHttpEngine::Handler* fallbackHandler, QObject* parent = nullptr);
+
+  /*! \brief Register a tile handler
+   *
+   *  The handler is re-parented to this class. If another handler is already
+   *  registered under the same name, that handler is deleted.
+   *
+   *  @param name Name of the tile set, used as the first path component
+   *
+   *  @param handler Tile handler
+   */
+  void insertTileHandler(const QString& name, GeoMaps::TileHandler* handler);
+
+  /*! \brief Remove and delete a tile handler
+   *
+   *  @param name Name of the tile set
+   */
+  void removeTileHandler(const QString& name);
+
+  /*! \brief Request statistics of all tile sets
+   *
+   *  @returns JSON object that maps names of tile sets to the statistics of
+   *  the respective handler, see TileHandler::statistics()
+   */
+  [[nodiscard]] auto statistics() const -> QJsonObject;
+
+protected:
+  /*
+   * @brief Reimplementation of
+   * [Handler::process()](QHttpEngine::Handler::process)
+   */
+  void process(QHttpEngine::Socket* socket, const QString& path) override;
+
+private:
+  Q_DISABLE_COPY_MOVE(TileServerHandler)
+
+  // Human-readable version of statistics(), in HTML format
+  [[nodiscard]] auto statisticsHTML() const -> QByteArray;
+
+  QPointer<QHttpEngine::Handler> m_fallbackHandler;
+  QMap<QString, QPointer<GeoMaps::TileHandler>> m_tileHandlers;
+};
+
+} // namespace GeoMaps
@@ -49,7 +49,9 @@
 #include "platform/FileExchange_Abstract.h"
 #include "platform/Notifier_Abstract.h"
 #include "platform/PlatformAdaptor_Abstract.h"
+#include "positioning/PositionProvider.h"
 #include "traffic/TrafficDataProvider.h"
+#include "traffic/TrafficDataSource_Simulate.h"
 #include "traffic/TrafficFactor_WithPosition.h"
 #include "weather/WeatherDataProvider.h"
 #include <chrono>
@@ -136,6 +138,14 @@ auto main(int argc, char *argv[]) -> int
     parser.addVersionOption();
     QCommandLineOption screenshotOption(QStringLiteral("s"), QCoreApplication::translate("main", "Run simulator and generate screenshots for manual"));
     parser.addOption(screenshotOption);
+    QCommandLineOption syntheticTrafficOption(QStringLiteral("synthetic-traffic"), QCoreApplication::translate("main", "Simulate <count> traffic targets around the current position, for profiling"), QStringLiteral("count"));
+    parser.addOption(syntheticTrafficOption);
+    QCommandLineOption syntheticProtocolOption(QStringLiteral("synthetic-protocol"), QCoreApplication::translate("main", "Data format of the simulated traffic: flarm, gdl90 or xgps (default flarm)"), QStringLiteral("protocol"), QStringLiteral("flarm"));
+    parser.addOption(syntheticProtocolOption);
+    QCommandLineOption syntheticIntervalOption(QStringLiteral("synthetic-interval"), QCoreApplication::translate("main", "Update interval of the simulated traffic in milliseconds (default 1000)"), QStringLiteral("ms"), QStringLiteral("1000"));
+    parser.addOption(syntheticIntervalOption);
+    QCommandLineOption captureTrafficOption(QStringLiteral("capture-traffic"), QCoreApplication::translate("main", "Record raw traffic receiver data to capture files in <directory>"), QStringLiteral("directory"));
+    parser.addOption(captureTrafficOption);
     parser.addPositionalArgument(QStringLiteral("[fileName]"), QCoreApplication::translate("main", "File to import."));
     parser.process(app);
     auto positionalArguments = parser.positionalArguments();
@@ -143,6 +153,20 @@ auto main(int argc, char *argv[]) -> int
     {
         parser.showHelp();
     }
+    auto syntheticProtocol = Traffic::SyntheticTraffic::Protocol::FLARM;
+    auto syntheticProtocolName = parser.value(syntheticProtocolOption).toLower();
+    if (syntheticProtocolName == u"gdl90")
+    {
+        syntheticProtocol = Traffic::SyntheticTraffic::Protocol::GDL90;
+    }
+    else if (syntheticProtocolName == u"xgps")
+    {
+        syntheticProtocol = Traffic::SyntheticTraffic::Protocol::XGPS;
+    }
+    else if (syntheticProtocolName != u"flarm")
+    {
+        parser.showHelp(1);
+    }
 
 #if !defined(Q_OS_ANDROID)
     // Single application on desktops
@@ -182,6 +206,33 @@ auto main(int argc, char *argv[]) -> int
     engine->rootContext()->setContextProperty(QStringLiteral("leg"), QVariant::fromValue(Navigation::Leg()) );
     engine->load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
 
+    // Measure the latency of traffic data up to the screen
+    foreach (auto* rootObject, engine->rootObjects()) {
+        auto* window = qobject_cast<QQuickWindow*>(rootObject);
+        if (window != nullptr) {
+            GlobalObject::trafficDataProvider()->setRenderWindow(window);
+        }
+    }
+
+    // Load generator for profiling the traffic pipeline and the QML rendering
+    if (parser.isSet(syntheticTrafficOption))
+    {
+        auto coordinate = Positioning::PositionProvider::lastValidCoordinate();
+        auto* simulator = new Traffic::TrafficDataSource_Simulate();
+        simulator->setCoordinate(coordinate);
+        simulator->setBarometricHeight(Units::Distance::fromM(qIsFinite(coordinate.altitude()) ? coordinate.altitude() : 0.0));
+        simulator->setSyntheticProtocol(syntheticProtocol);
+        simulator->setSyntheticInterval(std::chrono::milliseconds(qMax(10, parser.value(syntheticIntervalOption).toInt())));
+        simulator->addRandomSyntheticTargets(qMax(1, parser.value(syntheticTrafficOption).toInt()));
+        GlobalObject::trafficDataProvider()->addDataSource(simulator);
+        simulator->connectToTrafficReceiver();
+    }
+
+    if (parser.isSet(captureTrafficOption))
+    {
+        GlobalObject::trafficDataProvider()->startCapture(parser.value(captureTrafficOption));
+    }
+
     if (parser.isSet(screenshotOption))
     {
         GlobalObject::demoRunner()->setEngine(engine);
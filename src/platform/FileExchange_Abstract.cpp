@@ -91,8 +91,8 @@ void Platform::FileExchange_Abstract::processFileOpenRequest(const QString& path
         return;
     }
 
-    // FLARM Simulator file
-    if (Traffic::TrafficDataSource_File::containsFLARMSimulationData(myPath))
+    // FLARM Simulator file or traffic data capture
+    if (Traffic::TrafficDataSource_File::containsFLARMSimulationData(myPath) || Traffic::TrafficDataSource_File::containsTrafficCapture(myPath))
     {
         auto *source = new Traffic::TrafficDataSource_File(myPath);
         GlobalObject::trafficDataProvider()->addDataSource(source); // Will take ownership of source
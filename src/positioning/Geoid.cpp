@@ -18,6 +18,7 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QMutex>
 #include <QtEndian>
 #include <QtMath>
 
@@ -27,6 +28,10 @@
 
 QVector<qint16> Positioning::Geoid::egm {};
 
+// Protects the lazy initialization of egm. Geoid::separation is used by the
+// traffic data sources in the traffic I/O thread as well as in the main thread.
+static QMutex egmMutex;
+
 
 // reading binary geoid data was carefully optimized for speed. We read the
 // binary content at once and do the byte order conversion afterwards.  This
@@ -81,10 +86,13 @@ auto Positioning::Geoid::separation(const QGeoCoordinate& coord) -> Units::Dista
     }
 
     // Read EGM vector if this has not been done already
-    if (egm.empty()) {
-        readEGM();
+    {
+        QMutexLocker locker(&egmMutex);
         if (egm.empty()) {
-            return Units::Distance::fromM( qQNaN() );
+            readEGM();
+            if (egm.empty()) {
+                return Units::Distance::fromM( qQNaN() );
+            }
         }
     }
 
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtMath>
+
+#include "positioning/LocalTangentPlane.h"
+
+
+// Static Helper functions
+
+// Semi-major axis and first eccentricity squared of the WGS84 ellipsoid
+constexpr double wgs84SemiMajorAxis = 6378137.0;
+constexpr double wgs84EccentricitySquared = 6.69437999014e-3;
+
+// Wraps a longitude that is at most 360° out of range into [-180, 180]
+inline auto wrapLongitude(double longitude) -> double
+{
+    if (longitude > 180.0) {
+        return longitude - 360.0;
+    }
+    if (longitude < -180.0) {
+        return longitude + 360.0;
+    }
+    return longitude;
+}
+
+
+// Member functions
+
+Positioning::LocalTangentPlane::LocalTangentPlane(const QGeoCoordinate& origin)
+    : m_origin(origin)
+{
+    if (!m_origin.isValid()) {
+        return;
+    }
+
+    // Radii of curvature in the meridian and in the prime vertical
+    auto sinLatitude = qSin(qDegreesToRadians(m_origin.latitude()));
+    auto cosLatitude = qCos(qDegreesToRadians(m_origin.latitude()));
+    auto w = qSqrt(1.0 - wgs84EccentricitySquared*sinLatitude*sinLatitude);
+    auto meridionalRadius = wgs84SemiMajorAxis*(1.0 - wgs84EccentricitySquared)/(w*w*w);
+    auto primeVerticalRadius = wgs84SemiMajorAxis/w;
+
+    // Use the altitude, if known
+    auto altitude = m_origin.altitude();
+    if (qIsFinite(altitude)) {
+        meridionalRadius += altitude;
+        primeVerticalRadius += altitude;
+    }
+
+    // Avoid division by zero at the poles
+    cosLatitude = qMax(cosLatitude, 1e-9);
+
+    m_metersPerDegreeLatitude = qDegreesToRadians(meridionalRadius);
+    m_metersPerDegreeLongitude = qDegreesToRadians(primeVerticalRadius*cosLatitude);
+}
+
+
+void Positioning::LocalTangentPlane::displace(std::span<double> latitude, std::span<double> longitude, std::span<const double> north, std::span<const double> east) const
+{
+    const auto degreesPerMeterLatitude = 1.0/m_metersPerDegreeLatitude;
+    const auto degreesPerMeterLongitude = 1.0/m_metersPerDegreeLongitude;
+
+    const auto size = latitude.size();
+    for(size_t i=0; i<size; i++) {
+        latitude[i] += north[i]*degreesPerMeterLatitude;
+        longitude[i] = wrapLongitude(longitude[i] + east[i]*degreesPerMeterLongitude);
+    }
+}
+
+
+auto Positioning::LocalTangentPlane::distanceTo(const QGeoCoordinate& coordinate) const -> Units::Distance
+{
+    if (!isValid() || !coordinate.isValid()) {
+        return {};
+    }
+    auto offset = toOffset(coordinate);
+    return Units::Distance::fromM( qSqrt(offset.north*offset.north + offset.east*offset.east) );
+}
+
+
+auto Positioning::LocalTangentPlane::toCoordinate(double north, double east, Units::Distance up) const -> QGeoCoordinate
+{
+    if (!isValid()) {
+        return {};
+    }
+
+    QGeoCoordinate result(m_origin.latitude() + north/m_metersPerDegreeLatitude,
+                          wrapLongitude(m_origin.longitude() + east/m_metersPerDegreeLongitude));
+    if (up.isFinite() && qIsFinite(m_origin.altitude())) {
+        result.setAltitude(m_origin.altitude() + up.toM());
+    }
+    return result;
+}
+
+
+void Positioning::LocalTangentPlane::toLatLon(std::span<const double> north, std::span<const double> east, std::span<double> latitude, std::span<double> longitude) const
+{
+    const auto latitude0 = m_origin.latitude();
+    const auto longitude0 = m_origin.longitude();
+    const auto degreesPerMeterLatitude = 1.0/m_metersPerDegreeLatitude;
+    const auto degreesPerMeterLongitude = 1.0/m_metersPerDegreeLongitude;
+
+    const auto size = north.size();
+    for(size_t i=0; i<size; i++) {
+        latitude[i] = latitude0 + north[i]*degreesPerMeterLatitude;
+        longitude[i] = wrapLongitude(longitude0 + east[i]*degreesPerMeterLongitude);
+    }
+}
+
+
+auto Positioning::LocalTangentPlane::toOffset(const QGeoCoordinate& coordinate) const -> Offset
+{
+    return { (coordinate.latitude() - m_origin.latitude())*m_metersPerDegreeLatitude,
+             wrapLongitude(coordinate.longitude() - m_origin.longitude())*m_metersPerDegreeLongitude };
+}
+
+
+void Positioning::LocalTangentPlane::toOffsets(std::span<const double> latitude, std::span<const double> longitude, std::span<double> north, std::span<double> east) const
+{
+    const auto latitude0 = m_origin.latitude();
+    const auto longitude0 = m_origin.longitude();
+    const auto metersPerDegreeLatitude = m_metersPerDegreeLatitude;
+    const auto metersPerDegreeLongitude = m_metersPerDegreeLongitude;
+
+    const auto size = latitude.size();
+    for(size_t i=0; i<size; i++) {
+        north[i] = (latitude[i] - latitude0)*metersPerDegreeLatitude;
+        east[i] = wrapLongitude(longitude[i] - longitude0)*metersPerDegreeLongitude;
+    }
+}
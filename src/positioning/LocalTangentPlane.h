@@ -0,0 +1,172 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QGeoCoordinate>
+
+#include <span>
+
+#include "units/Distance.h"
+
+
+namespace Positioning {
+
+/*! \brief Local tangent plane
+ *
+ *  This class implements a local east-north-up (ENU) coordinate system,
+ *  anchored at an origin.  Within a few tens of kilometers of the origin,
+ *  geographic coordinates and metric offsets can be converted into one another
+ *  with a few multiplications, using the radii of curvature of the WGS84
+ *  ellipsoid at the origin.  For distances up to 20 km, the error is well below
+ *  the accuracy of GNSS positions.
+ *
+ *  The class is meant for short-range geometry around the own aircraft, such
+ *  as the reconstruction of traffic positions from relative FLARM data.  For
+ *  long-range computations, use the geodesic methods of QGeoCoordinate.
+ *
+ *  The batch methods take arrays of coordinates, so that the compiler can
+ *  vectorize the loops.
+ */
+
+class LocalTangentPlane
+{
+public:
+    /*! \brief Offset from the origin */
+    struct Offset {
+        /*! \brief Offset towards true north, in meters */
+        double north {0.0};
+
+        /*! \brief Offset towards east, in meters */
+        double east {0.0};
+    };
+
+    /*! \brief Constructs an invalid tangent plane */
+    LocalTangentPlane() = default;
+
+    /*! \brief Constructs a tangent plane
+     *
+     *  @param origin Origin of the tangent plane. If the coordinate is
+     *  invalid, then so is the tangent plane.
+     */
+    explicit LocalTangentPlane(const QGeoCoordinate& origin);
+
+    /*! \brief Validity
+     *
+     *  @returns True if the tangent plane has a valid origin
+     */
+    [[nodiscard]] auto isValid() const -> bool
+    {
+        return m_origin.isValid();
+    }
+
+    /*! \brief Origin
+     *
+     *  @returns Origin, as set in the constructor
+     */
+    [[nodiscard]] auto origin() const -> QGeoCoordinate
+    {
+        return m_origin;
+    }
+
+    /*! \brief Convert offset to geographic coordinate
+     *
+     *  @param north Offset towards true north, in meters
+     *
+     *  @param east Offset towards east, in meters
+     *
+     *  @param up Offset upwards. If the distance is not finite or if the
+     *  origin has no altitude, the result has no altitude either.
+     *
+     *  @returns Coordinate, or an invalid coordinate if the plane is invalid
+     */
+    [[nodiscard]] auto toCoordinate(double north, double east, Units::Distance up = {}) const -> QGeoCoordinate;
+
+    /*! \brief Convert geographic coordinate to offset
+     *
+     *  @param coordinate Coordinate
+     *
+     *  @returns Offset of the coordinate from the origin. The result is
+     *  meaningless if the plane or the coordinate is invalid.
+     */
+    [[nodiscard]] auto toOffset(const QGeoCoordinate& coordinate) const -> Offset;
+
+    /*! \brief Horizontal distance from origin
+     *
+     *  @param coordinate Coordinate
+     *
+     *  @returns Horizontal distance of the coordinate from the origin, or NaN
+     *  if the plane or the coordinate is invalid
+     */
+    [[nodiscard]] auto distanceTo(const QGeoCoordinate& coordinate) const -> Units::Distance;
+
+    /*! \brief Convert offsets to geographic coordinates, in batch
+     *
+     *  All arrays must have the same size.
+     *
+     *  @param north Offsets towards true north, in meters
+     *
+     *  @param east Offsets towards east, in meters
+     *
+     *  @param latitude Output array for the latitudes, in degrees
+     *
+     *  @param longitude Output array for the longitudes, in degrees
+     */
+    void toLatLon(std::span<const double> north, std::span<const double> east, std::span<double> latitude, std::span<double> longitude) const;
+
+    /*! \brief Convert geographic coordinates to offsets, in batch
+     *
+     *  All arrays must have the same size.
+     *
+     *  @param latitude Latitudes, in degrees
+     *
+     *  @param longitude Longitudes, in degrees
+     *
+     *  @param north Output array for the offsets towards true north, in meters
+     *
+     *  @param east Output array for the offsets towards east, in meters
+     */
+    void toOffsets(std::span<const double> latitude, std::span<const double> longitude, std::span<double> north, std::span<double> east) const;
+
+    /*! \brief Move geographic coordinates by offsets, in batch
+     *
+     *  This method uses the scale of the tangent plane at its origin for all
+     *  coordinates, which is accurate for small offsets near the origin.  All
+     *  arrays must have the same size.
+     *
+     *  @param latitude Latitudes, in degrees, modified in place
+     *
+     *  @param longitude Longitudes, in degrees, modified in place
+     *
+     *  @param north Offsets towards true north, in meters
+     *
+     *  @param east Offsets towards east, in meters
+     */
+    void displace(std::span<double> latitude, std::span<double> longitude, std::span<const double> north, std::span<const double> east) const;
+
+private:
+    QGeoCoordinate m_origin;
+
+    // Meters per degree of latitude and longitude at the origin
+    double m_metersPerDegreeLatitude {0.0};
+    double m_metersPerDegreeLongitude {0.0};
+};
+
+} // namespace Positioning
@@ -235,10 +235,10 @@ Item {
         }
 
         MapItemView { // Labels for traffic opponents
-            model: global.trafficDataProvider().trafficObjects4QML
+            model: global.trafficDataProvider().trafficTargets
             delegate: Component {
                 TrafficLabel {
-                    trafficInfo: model.modelData
+                    trafficInfo: model
                 }
             }
         }
@@ -376,11 +376,28 @@ Item {
             path: visible ? [PositionProvider.lastValidCoordinate, Navigator.remainingRouteInfo.nextWP.coordinate] : []
         }
 
+        MapItemView { // Recent tracks of traffic opponents
+            model: global.trafficDataProvider().trafficTargets
+            delegate: Component {
+                MapPolyline {
+                    line.width: 2
+                    line.color: model.color
+                    opacity: 0.5
+
+                    // Re-evaluated whenever the target reports a new position
+                    path: {
+                        model.positionInfo
+                        return global.trafficDataProvider().trackPolyline(model.ID)
+                    }
+                }
+            }
+        }
+
         MapItemView { // Traffic opponents
-            model: global.trafficDataProvider().trafficObjects4QML
+            model: global.trafficDataProvider().trafficTargets
             delegate: Component {
                 Traffic {
-                    trafficInfo: model.modelData
+                    trafficInfo: model
                 }
             }
         }
@@ -28,10 +28,11 @@ MapQuickItem {
 
     property var trafficInfo: ({})
 
-    coordinate: trafficInfo.positionInfo.coordinate()
-    Behavior on coordinate {
-        CoordinateAnimation { duration: 1000 }
-        enabled: trafficInfo.animate
+    // Position is extrapolated by dead reckoning and updated once per frame
+    coordinate: {
+        global.trafficDataProvider().deadReckoning.frame
+        const extrapolated = global.trafficDataProvider().deadReckoning.targetCoordinate(trafficInfo.ID)
+        return extrapolated.isValid ? extrapolated : trafficInfo.positionInfo.coordinate()
     }
 
     visible: trafficInfo.valid
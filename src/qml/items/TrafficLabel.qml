@@ -33,10 +33,13 @@ MapQuickItem {
     property real distFromCenter: 0.5*Math.sqrt(lbl.width*lbl.width + lbl.height*lbl.height) + 18
     property real t: trafficInfo.positionInfo.trueTrack().isFinite() ? 2*Math.PI*(trafficInfo.positionInfo.trueTrack().toDEG()-flightMap.bearing)/360.0 : 0
 
-    coordinate: trafficInfo.positionInfo.coordinate().isValid ? trafficInfo.positionInfo.coordinate() : PositionProvider.lastValidCoordinate
-    Behavior on coordinate {
-        CoordinateAnimation { duration: 1000 }
-        enabled: trafficInfo.animate
+    // Position is extrapolated by dead reckoning and updated once per frame
+    coordinate: {
+        global.trafficDataProvider().deadReckoning.frame
+        const extrapolated = global.trafficDataProvider().deadReckoning.targetCoordinate(trafficInfo.ID)
+        if (extrapolated.isValid)
+            return extrapolated
+        return trafficInfo.positionInfo.coordinate().isValid ? trafficInfo.positionInfo.coordinate() : PositionProvider.lastValidCoordinate
     }
 
     visible: trafficInfo.valid
@@ -72,7 +75,6 @@ MapQuickItem {
 
             Behavior on color {
                 ColorAnimation { duration: 400 }
-                enabled: trafficInfo.animate
             }
             radius: 4
         }
@@ -0,0 +1,155 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+import QtQml
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Controls.Material
+import QtQuick.Layouts
+
+import akaflieg_freiburg.enroute
+import enroute 1.0
+import "../items"
+
+Page {
+    id: trafficLatencyPage
+    objectName: "TrafficLatencyPage"
+
+    title: qsTr("Traffic Data Latency")
+
+    header: StandardHeader {}
+
+    // Latency statistics, as returned by TrafficDataProvider::latencyStatistics()
+    property var statistics: global.trafficDataProvider().latencyStatistics()
+
+    Timer {
+        interval: 1000
+        repeat: true
+        running: true
+        onTriggered: trafficLatencyPage.statistics = global.trafficDataProvider().latencyStatistics()
+    }
+
+    ScrollView {
+        id: sView
+
+        anchors.fill: parent
+        contentWidth: availableWidth // Disable horizontal scrolling
+
+        clip: true
+
+        bottomPadding: view.font.pixelSize + SafeInsets.bottom
+        leftPadding: view.font.pixelSize + SafeInsets.left
+        rightPadding: view.font.pixelSize + SafeInsets.right
+        topPadding: view.font.pixelSize
+
+        ColumnLayout {
+            width: sView.availableWidth
+
+            Label {
+                Layout.fillWidth: true
+
+                text: qsTr("Latencies are measured from the moment data is read from the network. Values are upper bounds of histogram buckets.")
+                wrapMode: Text.WordWrap
+            }
+
+            Repeater {
+                model: [
+                    { key: "warningToRender", title: qsTr("Traffic warning, network to screen") },
+                    { key: "warningToProvider", title: qsTr("Traffic warning, network to data provider") },
+                    { key: "reportToProvider", title: qsTr("Traffic report, network to data provider") },
+                    { key: "providerToRender", title: qsTr("Data provider to screen") }
+                ]
+
+                delegate: ColumnLayout {
+                    Layout.fillWidth: true
+
+                    required property var modelData
+                    property var histogram: trafficLatencyPage.statistics[modelData.key]
+
+                    Label {
+                        Layout.fillWidth: true
+                        Layout.topMargin: view.font.pixelSize*0.5
+
+                        text: modelData.title
+                        font.pixelSize: view.font.pixelSize*1.2
+                        font.bold: true
+                        color: Material.accent
+                        wrapMode: Text.WordWrap
+                    }
+
+                    Label {
+                        Layout.fillWidth: true
+                        Layout.leftMargin: 4
+                        Layout.rightMargin: 4
+
+                        text: {
+                            if (histogram.count === 0)
+                                return qsTr("No data")
+                            var result = qsTr("Count: %1").arg(histogram.count) + "<br>"
+                            result += qsTr("Mean: %1 ms").arg((histogram.meanMicroseconds/1000).toFixed(1)) + "<br>"
+                            result += qsTr("50th percentile: < %1 ms").arg((histogram.p50Microseconds/1000).toFixed(1)) + "<br>"
+                            result += qsTr("99th percentile: < %1 ms").arg((histogram.p99Microseconds/1000).toFixed(1))
+                            return result
+                        }
+                        wrapMode: Text.WordWrap
+                        textFormat: Text.RichText
+                    }
+                }
+            }
+
+            Item {
+                height: view.font.pixelSize*0.5
+            }
+
+            Button {
+                Layout.alignment: Qt.AlignHCenter
+
+                text: Qt.platform.os === "android" ? qsTr("Share…") : qsTr("Export…")
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    var errorString = global.fileExchange().shareContent(global.trafficDataProvider().latencyStatisticsJSON(), "application/json", qsTr("Traffic Data Latency"))
+                    if (errorString === "abort") {
+                        toast.doToast(qsTr("Aborted"))
+                        return
+                    }
+                    if (errorString !== "") {
+                        toast.doToast(errorString)
+                        return
+                    }
+                    if (Qt.platform.os === "android")
+                        toast.doToast(qsTr("Latency statistics shared"))
+                    else
+                        toast.doToast(qsTr("Latency statistics exported"))
+                }
+            }
+
+            Button {
+                Layout.alignment: Qt.AlignHCenter
+
+                text: qsTr("Reset")
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    global.trafficDataProvider().resetLatencyStatistics()
+                    trafficLatencyPage.statistics = global.trafficDataProvider().latencyStatistics()
+                }
+            }
+        }
+    }
+}
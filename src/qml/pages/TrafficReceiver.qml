@@ -37,6 +37,10 @@ Page {
 
     header: StandardHeader {}
 
+    // Sample the ingestion statistics only while this page exists
+    Component.onCompleted: global.trafficDataProvider().ingestionStatistics.active = true
+    Component.onDestruction: global.trafficDataProvider().ingestionStatistics.active = false
+
     ScrollView {
         id: sView
 
@@ -134,6 +138,76 @@ Page {
 
             }
 
+            Label {
+                Layout.fillWidth: true
+                visible: global.trafficDataProvider().ingestionStatistics.receivingSources > 0
+
+                text: qsTr("Data Sources")
+                font.pixelSize: view.font.pixelSize*1.2
+                font.bold: true
+                color: Material.accent
+            }
+
+            Repeater {
+                model: global.trafficDataProvider().ingestionStatistics
+
+                delegate: Label {
+                    Layout.fillWidth: true
+                    Layout.leftMargin: 4
+                    Layout.rightMargin: 4
+
+                    required property string sourceName
+                    required property var statistics
+
+                    visible: statistics.bytes > 0
+
+                    bottomPadding: 0.6*view.font.pixelSize
+                    topPadding: 0.6*view.font.pixelSize
+                    leftPadding: 0.2*view.font.pixelSize
+                    rightPadding: 0.2*view.font.pixelSize
+
+                    leftInset: -4
+                    rightInset: -4
+
+                    text: {
+                        var result = "<strong>" + sourceName + "</strong><br>"
+                        result += qsTr("%1 messages/s, %2 bytes/s")
+                        .arg(Math.round(statistics.messagesPerSecond ?? 0))
+                        .arg(Math.round(statistics.bytesPerSecond ?? 0)) + "<br>"
+                        result += qsTr("Checksum errors: %1, unknown messages: %2, duplicates: %3")
+                        .arg(statistics.checksumErrors)
+                        .arg(statistics.unknownMessages)
+                        .arg(statistics.duplicates) + "<br>"
+                        if (statistics.parseMicrosecondsPerMessage !== undefined)
+                            result += qsTr("Parse time: %1 µs/message").arg(statistics.parseMicrosecondsPerMessage.toFixed(1)) + "<br>"
+                        if (statistics.lastMessageAge >= 0)
+                            result += qsTr("Last message: %1 s ago").arg(statistics.lastMessageAge.toFixed(1))
+                        else
+                            result += qsTr("No message decoded")
+                        return result
+                    }
+                    wrapMode: Text.WordWrap
+                    textFormat: Text.RichText
+
+                    background: Rectangle {
+                        border.color: "black"
+                        color: ((statistics.lastMessageAge >= 0) && (statistics.lastMessageAge < 5)) ? "green" : "red"
+                        opacity: 0.2
+                        radius: 4
+                    }
+                }
+            }
+
+            WordWrappingItemDelegate {
+                Layout.fillWidth: true
+                visible: global.trafficDataProvider().ingestionStatistics.receivingSources > 0
+                icon.source: "/icons/material/ic_info_outline.svg"
+                text: qsTr("Latency statistics…")
+                onClicked: {
+                    PlatformAdaptor.vibrateBrief()
+                    stackView.push("TrafficLatency.qml")
+                }
+            }
 
             Button {
                 Layout.alignment: Qt.AlignHCenter
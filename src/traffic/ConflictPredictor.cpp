@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtMath>
+
+#include "traffic/ConflictPredictor.h"
+
+
+// Static Helper functions
+
+// Computes north and east components of a velocity. If ground speed or track
+// is unknown, both components are NaN. PositionInfo does not report a track
+// at very low speed; the velocity is then taken to be zero.
+void velocityComponents(const Positioning::PositionInfo& info, double& north, double& east)
+{
+    auto groundSpeed = info.groundSpeed();
+    if (groundSpeed.isFinite() && (groundSpeed.toKN() < 4.0)) {
+        north = 0.0;
+        east = 0.0;
+        return;
+    }
+    auto track = info.trueTrack().toRAD();
+    north = groundSpeed.toMPS()*qCos(track);
+    east = groundSpeed.toMPS()*qSin(track);
+}
+
+
+// Member functions
+
+void Traffic::ConflictPredictor::predict(std::span<Traffic::TrafficTargetTable::Entry> entries)
+{
+    const auto size = static_cast<qsizetype>(entries.size());
+
+    // Without ownship data, there is nothing to predict
+    if (!m_tangentPlane.isValid() || !qIsFinite(m_ownshipVelocityNorth) || !qIsFinite(m_ownshipVelocityEast)) {
+        for(auto& entry : entries) {
+            entry.report.cpaDist = {};
+            entry.report.tcpa = {};
+        }
+        return;
+    }
+
+    // Gather data. The buffers grow to the size of the target table and keep
+    // their capacity afterwards.
+    m_latitude.resize(size);
+    m_longitude.resize(size);
+    m_north.resize(size);
+    m_east.resize(size);
+    m_velocityNorth.resize(size);
+    m_velocityEast.resize(size);
+    m_cpaDistance.resize(size);
+    m_tcpa.resize(size);
+    for(qsizetype i=0; i<size; i++) {
+        const auto& positionInfo = entries[i].report.positionInfo;
+        auto coordinate = positionInfo.coordinate();
+        m_latitude[i] = coordinate.latitude();
+        m_longitude[i] = coordinate.longitude();
+        velocityComponents(positionInfo, m_velocityNorth[i], m_velocityEast[i]);
+    }
+
+    // Compute positions relative to own aircraft
+    m_tangentPlane.toOffsets({m_latitude.constData(), static_cast<size_t>(size)},
+                             {m_longitude.constData(), static_cast<size_t>(size)},
+                             {m_north.data(), static_cast<size_t>(size)},
+                             {m_east.data(), static_cast<size_t>(size)});
+
+    // Compute CPA. With relative position p and relative velocity v, the
+    // distance |p + t·v| is minimal at t = -(p·v)/(v·v). Unknown velocities
+    // are NaN and propagate to the result.
+    const auto ownshipVelocityNorth = m_ownshipVelocityNorth;
+    const auto ownshipVelocityEast = m_ownshipVelocityEast;
+    const auto maxTime = std::chrono::duration<double>(lookAhead).count();
+    const auto* north = m_north.constData();
+    const auto* east = m_east.constData();
+    const auto* velocityNorth = m_velocityNorth.constData();
+    const auto* velocityEast = m_velocityEast.constData();
+    auto* cpaDistance = m_cpaDistance.data();
+    auto* tcpa = m_tcpa.data();
+    for(qsizetype i=0; i<size; i++) {
+        auto relativeVelocityNorth = velocityNorth[i] - ownshipVelocityNorth;
+        auto relativeVelocityEast = velocityEast[i] - ownshipVelocityEast;
+        auto speedSquared = relativeVelocityNorth*relativeVelocityNorth + relativeVelocityEast*relativeVelocityEast;
+        auto closing = north[i]*relativeVelocityNorth + east[i]*relativeVelocityEast;
+
+        // The comparison below is false for NaN, so unknown velocities need
+        // to be caught first
+        auto time = qQNaN();
+        if (qIsFinite(speedSquared)) {
+            time = (speedSquared > 1e-6) ? -closing/speedSquared : 0.0;
+            time = qBound(0.0, time, maxTime);
+        }
+
+        auto cpaNorth = north[i] + time*relativeVelocityNorth;
+        auto cpaEast = east[i] + time*relativeVelocityEast;
+        cpaDistance[i] = qSqrt(cpaNorth*cpaNorth + cpaEast*cpaEast);
+        tcpa[i] = time;
+    }
+
+    // Scatter results
+    for(qsizetype i=0; i<size; i++) {
+        auto& report = entries[i].report;
+        if (qIsFinite(m_cpaDistance[i])) {
+            report.cpaDist = Units::Distance::fromM(m_cpaDistance[i]);
+            report.tcpa = Units::Time::fromS(m_tcpa[i]);
+        } else {
+            report.cpaDist = {};
+            report.tcpa = {};
+        }
+    }
+}
+
+
+void Traffic::ConflictPredictor::setOwnship(const Positioning::PositionInfo& ownship)
+{
+    if (!ownship.isValid()) {
+        m_tangentPlane = {};
+        m_ownshipVelocityNorth = qQNaN();
+        m_ownshipVelocityEast = qQNaN();
+        return;
+    }
+
+    auto coordinate = ownship.coordinate();
+    if (m_tangentPlane.origin() != coordinate) {
+        m_tangentPlane = Positioning::LocalTangentPlane(coordinate);
+    }
+    velocityComponents(ownship, m_ownshipVelocityNorth, m_ownshipVelocityEast);
+}
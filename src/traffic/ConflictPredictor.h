@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QVector>
+#include <chrono>
+#include <span>
+
+#include "positioning/LocalTangentPlane.h"
+#include "positioning/PositionInfo.h"
+#include "traffic/TrafficTargetTable.h"
+
+using namespace std::chrono_literals;
+
+
+namespace Traffic {
+
+/*! \brief Conflict prediction
+ *
+ *  This class predicts the closest point of approach (CPA) between the own
+ *  aircraft and traffic targets, assuming that all aircraft keep their
+ *  current ground speed and true track.  For every target whose ground speed
+ *  and track are known, the predictor computes the time to the closest point
+ *  of approach (TCPA), limited to the range [0, lookAhead], and the horizontal
+ *  distance at that time.
+ *
+ *  The computation takes place on a local tangent plane anchored at the own
+ *  position. Targets are processed in batches, with the data held in
+ *  structure-of-arrays buffers that are reused between calls, so that no
+ *  memory is allocated once the buffers have reached the size of the target
+ *  table.
+ */
+
+class ConflictPredictor {
+
+public:
+    /*! \brief Prediction horizon */
+    static constexpr auto lookAhead = 120s;
+
+    /*! \brief Set position of own aircraft
+     *
+     *  @param ownship Position of own aircraft. If the position, ground speed
+     *  or true track is unknown, no predictions are made.
+     */
+    void setOwnship(const Positioning::PositionInfo& ownship);
+
+    /*! \brief Compute predictions
+     *
+     *  This method sets the members cpaDist and tcpa of the reports. If no
+     *  prediction can be made, they are set to NaN.
+     *
+     *  @param entries Entries of a traffic target table
+     */
+    void predict(std::span<Traffic::TrafficTargetTable::Entry> entries);
+
+private:
+    // Tangent plane at the own position
+    Positioning::LocalTangentPlane m_tangentPlane;
+
+    // Velocity of own aircraft, in meters per second, or NaN
+    double m_ownshipVelocityNorth {qQNaN()};
+    double m_ownshipVelocityEast {qQNaN()};
+
+    // Buffers for batch computation, one element per target
+    QVector<double> m_latitude;
+    QVector<double> m_longitude;
+    QVector<double> m_north;
+    QVector<double> m_east;
+    QVector<double> m_velocityNorth;
+    QVector<double> m_velocityEast;
+    QVector<double> m_cpaDistance;
+    QVector<double> m_tcpa;
+};
+
+} // namespace Traffic
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QHash>
+
+#include "traffic/DatagramFilter.h"
+
+
+// Static Helper functions
+
+// 64-bit hash of a datagram. On platforms where size_t has only 32 bits, such
+// as 32-bit Android, qHash() yields 32 bits, so two hashes with different
+// seeds are combined.
+auto hash64(QByteArrayView datagram) -> quint64
+{
+    if constexpr (sizeof(size_t) >= sizeof(quint64)) {
+        return static_cast<quint64>(qHash(datagram));
+    } else {
+        return (static_cast<quint64>(qHash(datagram, 0x9e3779b9U)) << 32) | static_cast<quint64>(qHash(datagram));
+    }
+}
+
+
+// Member functions
+
+Traffic::DatagramFilter::DatagramFilter()
+{
+    m_clock.start();
+}
+
+
+auto Traffic::DatagramFilter::isDuplicate(QByteArrayView datagram, qint64 now) -> bool
+{
+    m_received.fetch_add(1, std::memory_order_relaxed);
+
+    auto hash = hash64(datagram);
+
+    // Probe a few slots. Remember the best slot for insertion: a free one if
+    // possible, otherwise the one that expires first.
+    qsizetype insertAt = -1;
+    for(qsizetype i = 0; i < maxProbes; i++) {
+        auto index = static_cast<qsizetype>((hash + i) & (numSlots-1));
+        auto& slot = m_slots[index];
+        if (slot.expiry <= now) {
+            if ((insertAt < 0) || (m_slots[insertAt].expiry > now)) {
+                insertAt = index;
+            }
+            continue;
+        }
+        if (slot.hash == hash) {
+            m_duplicates.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if ((insertAt < 0) || (slot.expiry < m_slots[insertAt].expiry)) {
+            insertAt = index;
+        }
+    }
+
+    m_slots[insertAt] = {hash, now + window.count()};
+    return false;
+}
+
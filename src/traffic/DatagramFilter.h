@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QByteArrayView>
+#include <QElapsedTimer>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+
+namespace Traffic {
+
+/*! \brief Filter for duplicate datagrams
+ *
+ *  Many traffic receivers send every datagram more than once, for instance
+ *  as broadcast and as unicast.  This class recognizes datagrams that have
+ *  been seen within a short time window.  It stores 64-bit hashes of recent
+ *  datagrams in an open-addressing hash set with bounded linear probing, so
+ *  that checking a datagram takes constant time regardless of the traffic
+ *  load.  Entries expire after the time window; if all probed slots are in
+ *  use, the oldest of them is overwritten.
+ *
+ *  The class counts checked datagrams and duplicates.  The counters are
+ *  atomic, so that IngestionStatistics can read them from any thread while
+ *  the filter is used in the traffic I/O thread.
+ */
+
+class DatagramFilter
+{
+public:
+    /*! \brief Number of slots in the hash set, a power of two */
+    static constexpr qsizetype numSlots = 1024;
+
+    /*! \brief Maximal number of slots probed per datagram */
+    static constexpr qsizetype maxProbes = 8;
+
+    /*! \brief Time window
+     *
+     *  Identical datagrams are considered duplicates if they arrive within
+     *  this time.  The window is shorter than the one-second update interval
+     *  of typical traffic receivers, so that legitimately repeated data, such
+     *  as reports of a stationary aircraft, are not dropped.
+     */
+    static constexpr std::chrono::milliseconds window {500};
+
+    /*! \brief Default constructor */
+    DatagramFilter();
+
+    /*! \brief Check if a datagram is a duplicate, and remember it
+     *
+     *  @param datagram Datagram payload
+     *
+     *  @returns True if an identical datagram has been seen within the time
+     *  window
+     */
+    auto isDuplicate(QByteArrayView datagram) -> bool
+    {
+        return isDuplicate(datagram, m_clock.elapsed());
+    }
+
+    /*! \brief Check if a datagram is a duplicate, and remember it
+     *
+     *  This method does not use the wall clock.  It is meant for replaying
+     *  recorded data, where the time of reception is known.
+     *
+     *  @param datagram Datagram payload
+     *
+     *  @param now Time of reception in milliseconds, on an arbitrary time
+     *  base that does not decrease between calls
+     *
+     *  @returns True if an identical datagram has been seen within the time
+     *  window
+     */
+    auto isDuplicate(QByteArrayView datagram, qint64 now) -> bool;
+
+    /*! \brief Number of datagrams checked
+     *
+     *  @returns Number of calls to isDuplicate()
+     */
+    [[nodiscard]] auto received() const -> quint64 { return m_received.load(std::memory_order_relaxed); }
+
+    /*! \brief Number of duplicates found
+     *
+     *  @returns Number of calls to isDuplicate() that returned true
+     */
+    [[nodiscard]] auto duplicates() const -> quint64 { return m_duplicates.load(std::memory_order_relaxed); }
+
+private:
+    // Slot of the hash set. A slot whose expiry lies in the past is free.
+    struct Slot {
+        quint64 hash {0};
+        qint64 expiry {0};
+    };
+    std::array<Slot, numSlots> m_slots {};
+
+    // Time base for the expiry times, if the caller does not provide the
+    // time of reception
+    QElapsedTimer m_clock;
+
+    // Statistics
+    std::atomic<quint64> m_received {0};
+    std::atomic<quint64> m_duplicates {0};
+};
+
+} // namespace Traffic
@@ -0,0 +1,191 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QDateTime>
+
+#include "traffic/DeadReckoning.h"
+
+
+// Member functions
+
+Traffic::DeadReckoning::DeadReckoning(QObject* parent)
+    : QObject(parent)
+{
+    m_frameTimer.setInterval(frameInterval);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, &Traffic::DeadReckoning::advance);
+}
+
+
+void Traffic::DeadReckoning::advance()
+{
+    const auto now = static_cast<double>(QDateTime::currentMSecsSinceEpoch());
+    const auto maxTime = std::chrono::duration<double>(maxExtrapolation).count();
+    const auto size = m_baseLatitude.size();
+
+    // Displacement of the own aircraft since its last report
+    auto ownAge = (now-m_ownTimestamp)/1000.0;
+    auto ownTime = qBound(0.0, ownAge, maxTime);
+    auto ownNorth = ownTime*m_ownVelocityNorth;
+    auto ownEast = ownTime*m_ownVelocityEast;
+    bool moving = (size > 0) && (ownAge < maxTime) && ((m_ownVelocityNorth != 0.0) || (m_ownVelocityEast != 0.0));
+
+    for(qsizetype i=0; i<size; i++) {
+        auto age = (now-m_timestamp[i])/1000.0;
+        if ((age < maxTime) && ((m_velocityNorth[i] != 0.0) || (m_velocityEast[i] != 0.0) || (m_velocityUp[i] != 0.0))) {
+            moving = true;
+        }
+        auto time = qBound(0.0, age, maxTime);
+        auto turn = time*m_turnRate[i];
+        if (qAbs(turn) < 1e-3) {
+            m_north[i] = time*m_velocityNorth[i];
+            m_east[i] = time*m_velocityEast[i];
+        } else {
+            // Integrate the velocity vector while it rotates at the turn rate
+            auto sinTurn = qSin(turn);
+            auto oneMinusCosTurn = 1.0-qCos(turn);
+            m_north[i] = (m_velocityNorth[i]*sinTurn - m_velocityEast[i]*oneMinusCosTurn)/m_turnRate[i];
+            m_east[i] = (m_velocityNorth[i]*oneMinusCosTurn + m_velocityEast[i]*sinTurn)/m_turnRate[i];
+        }
+        m_north[i] -= ownNorth;
+        m_east[i] -= ownEast;
+        m_latitude[i] = m_baseLatitude[i];
+        m_longitude[i] = m_baseLongitude[i];
+        m_altitude[i] = m_baseAltitude[i] + time*m_velocityUp[i];
+    }
+    if (m_tangentPlane.isValid()) {
+        m_tangentPlane.displace({m_latitude.data(), static_cast<size_t>(size)},
+                                {m_longitude.data(), static_cast<size_t>(size)},
+                                {m_north.constData(), static_cast<size_t>(size)},
+                                {m_east.constData(), static_cast<size_t>(size)});
+    }
+
+    if (!moving) {
+        m_frameTimer.stop();
+    } else if (!m_frameTimer.isActive()) {
+        m_frameTimer.start();
+    }
+
+    m_frame++;
+    emit frameChanged();
+}
+
+
+auto Traffic::DeadReckoning::coordinateAt(qsizetype index) const -> QGeoCoordinate
+{
+    QGeoCoordinate result(m_latitude[index], m_longitude[index]);
+    if (qIsFinite(m_altitude[index])) {
+        result.setAltitude(m_altitude[index]);
+    }
+    return result;
+}
+
+
+void Traffic::DeadReckoning::resize(qsizetype size)
+{
+    m_baseLatitude.resize(size);
+    m_baseLongitude.resize(size);
+    m_baseAltitude.resize(size);
+    m_timestamp.resize(size);
+    m_velocityNorth.resize(size);
+    m_velocityEast.resize(size);
+    m_velocityUp.resize(size);
+    m_turnRate.resize(size);
+    m_latitude.resize(size);
+    m_longitude.resize(size);
+    m_altitude.resize(size);
+    m_north.resize(size);
+    m_east.resize(size);
+}
+
+
+void Traffic::DeadReckoning::setObject(qsizetype index, const Positioning::PositionInfo& positionInfo)
+{
+    auto coordinate = positionInfo.coordinate();
+    m_baseLatitude[index] = coordinate.isValid() ? coordinate.latitude() : qQNaN();
+    m_baseLongitude[index] = coordinate.isValid() ? coordinate.longitude() : qQNaN();
+    m_baseAltitude[index] = coordinate.altitude();
+    m_timestamp[index] = static_cast<double>(positionInfo.timestamp().toMSecsSinceEpoch());
+
+    m_velocityNorth[index] = 0.0;
+    m_velocityEast[index] = 0.0;
+    m_velocityUp[index] = 0.0;
+    if (!positionInfo.isValid()) {
+        return;
+    }
+    auto groundSpeed = positionInfo.groundSpeed().toMPS();
+    auto track = positionInfo.trueTrack().toRAD();
+    if (qIsFinite(groundSpeed) && qIsFinite(track)) {
+        m_velocityNorth[index] = groundSpeed*qCos(track);
+        m_velocityEast[index] = groundSpeed*qSin(track);
+    }
+    auto verticalSpeed = positionInfo.verticalSpeed().toMPS();
+    if (qIsFinite(verticalSpeed)) {
+        m_velocityUp[index] = verticalSpeed;
+    }
+}
+
+
+void Traffic::DeadReckoning::setOwnship(const Positioning::PositionInfo& positionInfo, const QGeoCoordinate& lastValidCoordinate)
+{
+    if (m_tangentPlane.origin() != lastValidCoordinate) {
+        m_tangentPlane = Positioning::LocalTangentPlane(lastValidCoordinate);
+    }
+
+    m_ownTimestamp = static_cast<double>(positionInfo.timestamp().toMSecsSinceEpoch());
+    m_ownVelocityNorth = 0.0;
+    m_ownVelocityEast = 0.0;
+    if (positionInfo.isValid()) {
+        auto groundSpeed = positionInfo.groundSpeed().toMPS();
+        auto track = positionInfo.trueTrack().toRAD();
+        if (qIsFinite(groundSpeed) && qIsFinite(track)) {
+            m_ownVelocityNorth = groundSpeed*qCos(track);
+            m_ownVelocityEast = groundSpeed*qSin(track);
+        }
+    }
+    advance();
+}
+
+
+void Traffic::DeadReckoning::setTargets(const QVector<const Traffic::TrafficTargetTable::Entry*>& entries)
+{
+    resize(entries.size());
+    m_indexOfID.clear();
+    for(qsizetype i=0; i<entries.size(); i++) {
+        const auto& report = entries[i]->report;
+        setObject(i, report.positionInfo);
+        if (report.climbRate.isFinite()) {
+            m_velocityUp[i] = report.climbRate.toMPS();
+        }
+        m_turnRate[i] = report.turnRate.isFinite() ? report.turnRate.toRAD() : 0.0;
+        m_indexOfID.insert(report.ID, i);
+    }
+    advance();
+}
+
+
+auto Traffic::DeadReckoning::targetCoordinate(const QString& ID) const -> QGeoCoordinate
+{
+    auto index = m_indexOfID.value(ID, -1);
+    if (index < 0) {
+        return {};
+    }
+    return coordinateAt(index);
+}
@@ -0,0 +1,199 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QGeoCoordinate>
+#include <QHash>
+#include <QTimer>
+#include <QVector>
+#include <chrono>
+
+#include "positioning/LocalTangentPlane.h"
+#include "positioning/PositionInfo.h"
+#include "traffic/TrafficTargetTable.h"
+
+using namespace std::chrono_literals;
+
+
+namespace Traffic {
+
+/*! \brief Dead reckoning of traffic, for smooth display
+ *
+ *  Positions of traffic are reported once or twice per second.  This class
+ *  extrapolates the positions at display rate, using the last reported
+ *  position, ground speed, true track and vertical speed.  The climb rate
+ *  estimated from the track history replaces the reported vertical speed,
+ *  where available.  Targets for which the track history yields a turn rate
+ *  are extrapolated along a circular arc, so that circling gliders do not
+ *  overshoot their turn.  Extrapolation is limited to maxExtrapolation; targets
+ *  that have not been reported for longer stay at their extrapolated
+ *  position.
+ *
+ *  The own aircraft is not extrapolated, because the map centre, the map
+ *  bearing and the ownship icon follow the reported position.  To keep the
+ *  relative picture right, traffic is instead extrapolated by its motion
+ *  relative to the own aircraft: the displacement that the own aircraft
+ *  would have made since its last report is subtracted.  Otherwise, traffic
+ *  would run ahead of the ownship icon, and a head-on encounter would show
+ *  more separation than there really is.
+ *
+ *  To avoid emitting one signal per target and frame, the class emits a
+ *  single signal frameChanged() per display frame.  QML items read the
+ *  property "frame" in their bindings and then fetch their positions with
+ *  targetCoordinate().  All positions are computed in one batch per frame.
+ *  The frame timer runs only while a target moves and has been reported
+ *  less than maxExtrapolation ago.
+ */
+
+class DeadReckoning : public QObject {
+    Q_OBJECT
+
+public:
+    /*! \brief Default constructor
+     *
+     *  @param parent The standard QObject parent pointer
+     */
+    explicit DeadReckoning(QObject* parent = nullptr);
+
+    // Standard destructor
+    ~DeadReckoning() override = default;
+
+    /*! \brief Interval between display frames */
+    static constexpr auto frameInterval = 16ms;
+
+    /*! \brief Maximal time span for extrapolation */
+    static constexpr auto maxExtrapolation = 3s;
+
+
+    //
+    // Methods
+    //
+
+    /*! \brief Set position of own aircraft
+     *
+     *  The last valid coordinate is used as the origin of the tangent plane
+     *  in which offsets are computed.  Ground speed, true track and time of
+     *  the position info are used to extrapolate traffic relative to the own
+     *  aircraft.
+     *
+     *  @param positionInfo Position info of own aircraft, might be invalid
+     *
+     *  @param lastValidCoordinate Last valid coordinate of own aircraft
+     */
+    void setOwnship(const Positioning::PositionInfo& positionInfo, const QGeoCoordinate& lastValidCoordinate);
+
+    /*! \brief Set traffic targets
+     *
+     *  @param entries Entries of a TrafficTargetTable, as returned by
+     *  TrafficTargetTable::topN(). The pointers need to be valid only for the
+     *  duration of the call.
+     */
+    void setTargets(const QVector<const Traffic::TrafficTargetTable::Entry*>& entries);
+
+    /*! \brief Extrapolated position of a traffic target
+     *
+     *  @param ID Target ID
+     *
+     *  @returns Position of the target at the current frame, or an invalid
+     *  coordinate if the ID is not known
+     */
+    Q_INVOKABLE [[nodiscard]] QGeoCoordinate targetCoordinate(const QString& ID) const;
+
+
+    //
+    // Properties
+    //
+
+    /*! \brief Frame counter
+     *
+     *  This number increases with every display frame.  QML bindings read it
+     *  to get re-evaluated once per frame.
+     */
+    Q_PROPERTY(int frame READ frame NOTIFY frameChanged)
+
+    /*! \brief Getter method for property with the same name
+     *
+     *  @returns Property frame
+     */
+    [[nodiscard]] auto frame() const -> int
+    {
+        return m_frame;
+    }
+
+signals:
+    /*! \brief Notifier signal */
+    void frameChanged();
+
+private:
+    Q_DISABLE_COPY_MOVE(DeadReckoning)
+
+    // Computes all positions for the current time and emits frameChanged().
+    // Starts m_frameTimer if a target or the own aircraft moves and has been
+    // reported less than maxExtrapolation ago, and stops it otherwise.
+    void advance();
+
+    // Coordinate of the object at the given index of the arrays
+    [[nodiscard]] auto coordinateAt(qsizetype index) const -> QGeoCoordinate;
+
+    // Sets the array entries at index from the position info
+    void setObject(qsizetype index, const Positioning::PositionInfo& positionInfo);
+
+    // Resizes all arrays
+    void resize(qsizetype size);
+
+    // Tangent plane at the own position, used to convert offsets into
+    // coordinates
+    Positioning::LocalTangentPlane m_tangentPlane;
+
+    // Own aircraft. Timestamp in milliseconds since epoch, velocities in
+    // meters per second, zero if unknown.
+    double m_ownTimestamp {0.0};
+    double m_ownVelocityNorth {0.0};
+    double m_ownVelocityEast {0.0};
+
+    // Traffic targets, as structure of arrays. Timestamps are in milliseconds
+    // since epoch, velocities in meters per second, turn rates in radians per
+    // second, positive for right turns. Unknown velocities and turn rates
+    // are zero.
+    QVector<double> m_baseLatitude;
+    QVector<double> m_baseLongitude;
+    QVector<double> m_baseAltitude;
+    QVector<double> m_timestamp;
+    QVector<double> m_velocityNorth;
+    QVector<double> m_velocityEast;
+    QVector<double> m_velocityUp;
+    QVector<double> m_turnRate;
+
+    // Positions at the current frame, and offsets used to compute them
+    QVector<double> m_latitude;
+    QVector<double> m_longitude;
+    QVector<double> m_altitude;
+    QVector<double> m_north;
+    QVector<double> m_east;
+
+    // Maps target ID to index in the arrays
+    QHash<QString, qsizetype> m_indexOfID;
+
+    QTimer m_frameTimer;
+    int m_frame {0};
+};
+
+} // namespace Traffic
@@ -21,20 +21,41 @@
 #include <QCoreApplication>
 #include <QTimer>
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
 #include "GlobalObject.h"
 #include "dataManagement/DataManager.h"
 #include "traffic/FlarmnetDB.h"
 
 
+// Static Helper functions
+
+// Parses a Flarm ID, which consists of exactly six hex digits. Returns true
+// on success.
+auto parseFlarmID(const char* data, qsizetype length, quint32& ID) -> bool
+{
+    if (length != 6) {
+        return false;
+    }
+    auto result = std::from_chars(data, data+length, ID, 16);
+    return (result.ec == std::errc()) && (result.ptr == data+length);
+}
+
+
+// Member functions
+
 Traffic::FlarmnetDB::FlarmnetDB(QObject* parent) : QObject(parent)
 {
     QTimer::singleShot(0, this, &Traffic::FlarmnetDB::deferredInitialization);
 }
 
 
-void Traffic::FlarmnetDB::clearCache()
+Traffic::FlarmnetDB::~FlarmnetDB()
 {
-    m_cache.clear();
+    QMutexLocker locker(&m_mutex);
+    unmap();
 }
 
 
@@ -71,12 +92,18 @@ void Traffic::FlarmnetDB::findFlarmnetDBDownloadable()
     }
 
     if (flarmnetDBDownloadable != nullptr) {
-        disconnect(flarmnetDBDownloadable, &DataManagement::Downloadable_Abstract::fileContentChanged, this, &Traffic::FlarmnetDB::clearCache);
+        disconnect(flarmnetDBDownloadable, &DataManagement::Downloadable_SingleFile::aboutToChangeFile, this, &Traffic::FlarmnetDB::onAboutToChangeFile);
+        disconnect(flarmnetDBDownloadable, &DataManagement::Downloadable_Abstract::fileContentChanged, this, &Traffic::FlarmnetDB::rebuildIndex);
     }
 
     flarmnetDBDownloadable = newFlarmnetDBDownloadable;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_fileName = (flarmnetDBDownloadable != nullptr) ? flarmnetDBDownloadable->fileName() : QString();
+    }
     if (flarmnetDBDownloadable != nullptr) {
-        connect(flarmnetDBDownloadable, &DataManagement::Downloadable_Abstract::fileContentChanged, this, &Traffic::FlarmnetDB::clearCache);
+        connect(flarmnetDBDownloadable, &DataManagement::Downloadable_SingleFile::aboutToChangeFile, this, &Traffic::FlarmnetDB::onAboutToChangeFile);
+        connect(flarmnetDBDownloadable, &DataManagement::Downloadable_Abstract::fileContentChanged, this, &Traffic::FlarmnetDB::rebuildIndex);
 
         // Create an empty file, if no file exists. We set the FileModificationTime
         // to a point in the past, so that it will automatically be updated at the
@@ -90,7 +117,7 @@ void Traffic::FlarmnetDB::findFlarmnetDBDownloadable()
         }
 
     }
-    clearCache();
+    rebuildIndex();
 
 }
 
@@ -102,71 +129,100 @@ auto Traffic::FlarmnetDB::getRegistration(const QString& key) -> QString
         return result;
     }
 
-    // Check if key exists in the cache
-    auto* cachedValue = m_cache[key];
-    if (cachedValue != nullptr) {
-        return *cachedValue;
+    // Flarm IDs are six hex digits
+    if (key.size() != 6) {
+        return {};
+    }
+    char keyLatin1[6];
+    for(int i=0; i<6; i++) {
+        keyLatin1[i] = key[i].toLatin1();
+    }
+    quint32 ID = 0;
+    if (!parseFlarmID(keyLatin1, 6, ID)) {
+        return {};
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // Binary search in the index
+    auto entry = std::lower_bound(m_index.constBegin(), m_index.constEnd(), quint64(ID) << 32);
+    if ((entry == m_index.constEnd()) || ((*entry >> 32) != ID)) {
+        return {};
     }
 
-    auto result = getRegistrationFromFile(key);
-    m_cache.insert(key, new QString(result));
-    return result;
+    // Registration strings are at most 16 characters long and end with a
+    // newline
+    auto offset = static_cast<qint64>(*entry & 0xFFFFFFFF);
+    auto length = qMin(m_dataSize-offset, qint64(16));
+    const auto* begin = m_data+offset;
+    const auto* end = static_cast<const char*>(memchr(begin, '\n', length));
+    if (end == nullptr) {
+        end = begin+length;
+    }
+    return QString::fromLatin1(begin, end-begin).simplified();
 }
 
 
-auto Traffic::FlarmnetDB::getRegistrationFromFile(const QString& key) -> QString
+void Traffic::FlarmnetDB::onAboutToChangeFile()
 {
+    QMutexLocker locker(&m_mutex);
+    unmap();
+}
 
-    // If not in the cache, try to find the values in the file.
-    if (flarmnetDBDownloadable == nullptr) {
-        return {};
-    }
 
-    QFile dataFile(flarmnetDBDownloadable->fileName());
-    if (!dataFile.open(QIODevice::ReadOnly)) {
-        dataFile.open(QIODevice::WriteOnly);
-        dataFile.write(tr("Placeholder file.").toLatin1());
-        dataFile.flush();
-        dataFile.setFileTime(QDateTime( QDate(2021, 8, 21), QTime(13, 0)), QFileDevice::FileModificationTime);
-        return {};
+void Traffic::FlarmnetDB::rebuildIndex()
+{
+    QMutexLocker locker(&m_mutex);
+    unmap();
+
+    if (m_fileName.isEmpty()) {
+        return;
     }
-    dataFile.readLine();
-
-    // Now to a binary search in the file
-    qint64 lineSize   = 24;
-    qint64 firstEntry = dataFile.pos();
-    qint64 numEntries = (dataFile.size()-firstEntry)/lineSize;
-
-    auto getKey = [firstEntry, lineSize](QFile& dataFile, qint64 entry) {
-        dataFile.seek(firstEntry + entry*lineSize);
-        return QString::fromLatin1(dataFile.readLine(7));
-    };
-    auto getVal = [firstEntry, lineSize](QFile& dataFile, qint64 entry) {
-        dataFile.seek(firstEntry + entry*lineSize + 7);
-        return QString::fromLatin1(dataFile.readLine(16)).simplified();
-    };
-
-    qint64 startIndex = 0;
-    qint64 endIndex   = numEntries-1;
-    do{
-        if (getKey(dataFile, startIndex) == key) {
-            auto value = getVal(dataFile, startIndex);
-            return value;
-        }
-        if (getKey(dataFile, endIndex) == key) {
-            auto value = getVal(dataFile, endIndex);
-            return value;
-        }
-        qint64 midIndex = (startIndex + endIndex)/2;
-        if (midIndex == startIndex) {
-            return {};
-        }
-        if (getKey(dataFile, midIndex) > key) {
-            endIndex = midIndex;
-        } else {
-            startIndex = midIndex;
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    auto size = m_file.size();
+    if ((size <= 0) || (size > 0xFFFFFFFF)) {
+        m_file.close();
+        return;
+    }
+    m_data = reinterpret_cast<const char*>(m_file.map(0, size));
+    if (m_data == nullptr) {
+        m_file.close();
+        return;
+    }
+    m_dataSize = size;
+
+    // The file consists of a header line, followed by lines of the form
+    // "<Flarm ID> <Registration>". Lines that do not have this form are
+    // ignored.
+    m_index.reserve(static_cast<qsizetype>(m_dataSize/24));
+    const char* line = static_cast<const char*>(memchr(m_data, '\n', m_dataSize));
+    const char* dataEnd = m_data+m_dataSize;
+    while ((line != nullptr) && (++line < dataEnd)) {
+        quint32 ID = 0;
+        if ((dataEnd-line > 7) && (line[6] == ' ') && parseFlarmID(line, 6, ID)) {
+            m_index.append((quint64(ID) << 32) | quint64(line+7-m_data));
         }
-    }while(startIndex != endIndex);
+        line = static_cast<const char*>(memchr(line, '\n', dataEnd-line));
+    }
+
+    // The database file is sorted by Flarm ID, but we do not rely on that
+    if (!std::is_sorted(m_index.constBegin(), m_index.constEnd())) {
+        std::sort(m_index.begin(), m_index.end());
+    }
+    m_index.squeeze();
+}
+
 
-    return {};
+void Traffic::FlarmnetDB::unmap()
+{
+    if (m_data != nullptr) {
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_data)));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_dataSize = 0;
+    m_index.clear();
 }
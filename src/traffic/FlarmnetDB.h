@@ -20,8 +20,10 @@
 
 #pragma once
 
-#include <QCache>
+#include <QFile>
+#include <QMutex>
 #include <QObject>
+#include <QVector>
 
 #include "dataManagement/Downloadable_SingleFile.h"
 
@@ -33,6 +35,15 @@ namespace Traffic {
  *  This simple class provides access to a Flarmnet database, which is in
  *  essence a glorified QHash<QString, QString>, where keys are Flarm IDs and
  *  values are aircraft registration strings.
+ *
+ *  Whenever the database file is installed or changed, the class maps the
+ *  file into memory and builds a compact index, a sorted array that holds the
+ *  24-bit Flarm ID and the offset of the registration string for every entry.
+ *  Lookups are then binary searches in memory and do not involve any file
+ *  I/O.
+ *
+ *  The method getRegistration() can be called from any thread; the traffic
+ *  data sources use it from the traffic I/O thread.
  */
 class FlarmnetDB : public QObject {
     Q_OBJECT
@@ -40,13 +51,15 @@ class FlarmnetDB : public QObject {
 public:
     /*! \brief Default constructor
      *
-     *  This default constructor will read the database from a file into memory.
+     *  This default constructor will map the database file into memory and
+     *  index it.
      *
      *  @param parent The standard QObject parent pointer
      */
     FlarmnetDB(QObject* parent=nullptr);
 
-    ~FlarmnetDB() override = default;
+    // Destructor, unmaps the database file
+    ~FlarmnetDB() override;
 
     //
     // Methods
@@ -62,8 +75,11 @@ public:
     Q_INVOKABLE QString getRegistration(const QString& key);
 
 private slots:
-    // The title says everything
-    void clearCache();
+    // Maps the database file and rebuilds m_index
+    void rebuildIndex();
+
+    // Unmaps the database file before it gets replaced
+    void onAboutToChangeFile();
 
     // The title says everything
     void deferredInitialization();
@@ -72,11 +88,27 @@ private slots:
     void findFlarmnetDBDownloadable();
 
 private:
-    auto getRegistrationFromFile(const QString& key) -> QString;
+    // Unmaps the database file and clears m_index. The caller must hold
+    // m_mutex.
+    void unmap();
 
     QPointer<DataManagement::Downloadable_SingleFile> flarmnetDBDownloadable;
 
-    QCache<QString, QString> m_cache {};
+    // Protects all members below
+    QMutex m_mutex;
+
+    // Name of the database file, or empty if there is none
+    QString m_fileName;
+
+    // Database file, and its memory mapping
+    QFile m_file;
+    const char* m_data {nullptr};
+    qint64 m_dataSize {0};
+
+    // Sorted index of the database. Every entry holds a 24-bit Flarm ID in
+    // the upper 32 bits, and the offset of the registration string in m_data
+    // in the lower 32 bits.
+    QVector<quint64> m_index;
 };
 
 } // namespace Traffic
@@ -0,0 +1,304 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtNumeric>
+#include <cmath>
+
+#include "traffic/GDL90.h"
+#include "units/Distance.h"
+
+
+// Static Helper functions
+
+// Lookup tables for the slice-by-8 CRC. The GDL90 checksum of a message M is
+// M(x) mod P(x), where P(x) = x^16+x^12+x^5+1. Table k-2 maps a byte v to
+// v(x)*x^(8k) mod P(x), for k = 2, …, 9. Table 0 is the table given in the
+// GDL90 specification.
+constexpr auto makeCRCTables() -> std::array<std::array<quint16, 256>, 8>
+{
+    std::array<std::array<quint16, 256>, 8> tables {};
+    for(int v=0; v<256; v++) {
+        auto crc = static_cast<quint16>(v << 8);
+        for(int bit=0; bit<8; bit++) {
+            crc = ((crc & 0x8000U) != 0) ? static_cast<quint16>((crc << 1U) ^ 0x1021U) : static_cast<quint16>(crc << 1U);
+        }
+        tables[0][v] = crc;
+    }
+    for(int k=1; k<8; k++) {
+        for(int v=0; v<256; v++) {
+            auto previous = tables[k-1][v];
+            tables[k][v] = static_cast<quint16>((previous << 8U) ^ tables[0][previous >> 8U]);
+        }
+    }
+    return tables;
+}
+constexpr auto crcTables = makeCRCTables();
+static_assert(crcTables[0][1] == 4129, "CRC table does not match the GDL90 specification");
+
+
+// Reads a signed 24-bit big-endian number
+auto readInt24(const quint8* data) -> qint32
+{
+    qint32 result = (data[0] << 16) + (data[1] << 8) + data[2];
+    if (result > 8388607) {
+        result -= 16777216;
+    }
+    return result;
+}
+
+void writeInt24(qint32 value, quint8* data)
+{
+    data[0] = (value >> 16) & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = value & 0xFF;
+}
+
+
+// Member functions
+
+auto Traffic::GDL90::crc16(const quint8* data, qsizetype size) -> quint16
+{
+    const auto& T = crcTables;
+    quint16 crc = 0;
+    while (size >= 8) {
+        crc = T[7][crc >> 8U] ^ T[6][crc & 0xFFU]
+              ^ T[5][data[0]] ^ T[4][data[1]] ^ T[3][data[2]] ^ T[2][data[3]]
+              ^ T[1][data[4]] ^ T[0][data[5]] ^ static_cast<quint16>(data[6] << 8U) ^ data[7];
+        data += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        crc = T[0][crc >> 8U] ^ static_cast<quint16>(crc << 8U) ^ *data;
+        data++;
+        size--;
+    }
+    return crc;
+}
+
+
+auto Traffic::GDL90::writeFrame(quint8 messageID, const quint8* payload, qsizetype size, quint8* out, qsizetype capacity) -> qsizetype
+{
+    qsizetype length = 0;
+    auto put = [&](quint8 byte) {
+        if ((byte == 0x7d) || (byte == 0x7e)) {
+            if (length < capacity) {
+                out[length] = 0x7d;
+            }
+            length++;
+            byte ^= 0x20U;
+        }
+        if (length < capacity) {
+            out[length] = byte;
+        }
+        length++;
+    };
+
+    // Checksum over message ID and payload
+    auto checksum = static_cast<quint16>(crcTables[0][0] ^ messageID);
+    for(qsizetype i=0; i<size; i++) {
+        checksum = crcTables[0][checksum >> 8U] ^ static_cast<quint16>(checksum << 8U) ^ payload[i];
+    }
+
+    if (capacity > 0) {
+        out[0] = 0x7e;
+    }
+    length = 1;
+    put(messageID);
+    for(qsizetype i=0; i<size; i++) {
+        put(payload[i]);
+    }
+    put(checksum & 0xFFU);
+    put(checksum >> 8U);
+    if (length < capacity) {
+        out[length] = 0x7e;
+    }
+    length++;
+
+    return (length <= capacity) ? length : 0;
+}
+
+
+void Traffic::GDL90::Deframer::append(const quint8* begin, const quint8* end)
+{
+    for(const auto* pos = begin; pos < end; pos++) {
+        auto byte = *pos;
+        if (m_escaped) {
+            byte ^= 0x20U;
+            m_escaped = false;
+        } else if (byte == 0x7d) {
+            m_escaped = true;
+            continue;
+        }
+        if (m_size == maxMessageSize) {
+            m_overflow = true;
+            continue;
+        }
+        m_buffer[m_size++] = byte;
+    }
+}
+
+
+auto Traffic::GDL90::Heartbeat::decode(const Frame& frame) -> bool
+{
+    if ((frame.messageID != 0) || (frame.size < encodedSize)) {
+        return false;
+    }
+    status1 = frame.payload[0];
+    status2 = frame.payload[1];
+    return true;
+}
+
+
+void Traffic::GDL90::Heartbeat::encode(quint8* payload) const
+{
+    payload[0] = status1;
+    payload[1] = status2;
+    payload[2] = 0;
+    payload[3] = 0;
+    payload[4] = 0;
+    payload[5] = 0;
+}
+
+
+auto Traffic::GDL90::OwnshipGeometricAltitude::decode(const Frame& frame) -> bool
+{
+    if ((frame.messageID != 11) || (frame.size < 4)) {
+        return false;
+    }
+    const auto* p = frame.payload;
+
+    qint32 altitude = (p[0] << 8) + p[1];
+    if (altitude > 32767) {
+        altitude -= 65536;
+    }
+    altitudeFT = altitude*5.0;
+    verticalFigureOfMeritM = static_cast<quint16>(((p[2] & 0x7FU) << 8U) + p[3]);
+    return true;
+}
+
+
+auto Traffic::GDL90::TargetReport::decode(const Frame& frame) -> bool
+{
+    if (((frame.messageID != 10) && (frame.messageID != 20)) || (frame.size != 27)) {
+        return false;
+    }
+    const auto* p = frame.payload;
+
+    alertStatus = p[0] >> 4U;
+    addressType = p[0] & 0x0FU;
+    address = (p[1] << 16U) + (p[2] << 8U) + p[3];
+
+    latitude = (180.0/0x800000)*readInt24(p+4);
+    longitude = (180.0/0x800000)*readInt24(p+7);
+
+    quint32 dd = (p[10] << 4U) + (p[11] >> 4U);
+    hasPressureAltitude = (dd != 0xFFF);
+    pressureAltitudeFT = 25.0*dd - 1000.0;
+
+    miscIndicators = p[11] & 0x0FU;
+    NACp = p[12] & 0x0FU;
+
+    quint32 hh = (p[13] << 4U) + (p[14] >> 4U);
+    hasHorizontalVelocity = (hh != 0xFFF);
+    horizontalVelocityKN = hh;
+
+    qint32 vv = ((p[14] & 0x0FU) << 8U) + p[15];
+    hasVerticalVelocity = (vv != 0x800);
+    verticalVelocityFPM = (vv < 0x800) ? 64.0*vv : -64.0*((1<<12)-vv);
+
+    hasTrack = ((miscIndicators & 0x03U) == 1);
+    trackDEG = p[16]*360.0/256.0;
+
+    emitterCategory = p[17];
+    memcpy(callSign.data(), p+18, callSign.size());
+    return true;
+}
+
+
+void Traffic::GDL90::TargetReport::encode(quint8* payload) const
+{
+    auto* p = payload;
+
+    p[0] = static_cast<quint8>(((alertStatus & 0x0FU) << 4U) | (addressType & 0x0FU));
+    p[1] = (address >> 16U) & 0xFFU;
+    p[2] = (address >> 8U) & 0xFFU;
+    p[3] = address & 0xFFU;
+
+    writeInt24(qRound(qBound(-90.0, latitude, 90.0)*0x800000/180.0), p+4);
+    writeInt24(qRound(qBound(-180.0, longitude, 180.0-180.0/0x800000)*0x800000/180.0), p+7);
+
+    quint32 dd = 0xFFF;
+    if (hasPressureAltitude) {
+        dd = qBound(0, qRound((pressureAltitudeFT+1000.0)/25.0), 0xFFE);
+    }
+    quint32 misc = (miscIndicators & 0x0CU) | (hasTrack ? 0x01U : 0x00U);
+    p[10] = (dd >> 4U) & 0xFFU;
+    p[11] = static_cast<quint8>(((dd & 0x0FU) << 4U) | misc);
+    p[12] = NACp & 0x0FU;
+
+    quint32 hh = 0xFFF;
+    if (hasHorizontalVelocity) {
+        hh = qBound(0, qRound(horizontalVelocityKN), 0xFFE);
+    }
+    quint32 vv = 0x800;
+    if (hasVerticalVelocity) {
+        vv = static_cast<quint32>(qBound(-0x7FF, qRound(verticalVelocityFPM/64.0), 0x7FF)) & 0xFFFU;
+    }
+    p[13] = (hh >> 4U) & 0xFFU;
+    p[14] = static_cast<quint8>(((hh & 0x0FU) << 4U) | (vv >> 8U));
+    p[15] = vv & 0xFFU;
+
+    p[16] = static_cast<quint8>(qRound(std::fmod(std::fmod(trackDEG, 360.0)+360.0, 360.0)*256.0/360.0) & 0xFF);
+    p[17] = emitterCategory;
+    memcpy(p+18, callSign.data(), callSign.size());
+    p[26] = 0;
+}
+
+
+auto Traffic::GDL90::TargetReport::horizontalAccuracyM() const -> double
+{
+    switch (NACp) {
+    case 1:
+        return Units::Distance::fromNM(10.0).toM();
+    case 2:
+        return Units::Distance::fromNM(4.0).toM();
+    case 3:
+        return Units::Distance::fromNM(2.0).toM();
+    case 4:
+        return Units::Distance::fromNM(1.0).toM();
+    case 5:
+        return Units::Distance::fromNM(0.5).toM();
+    case 6:
+        return Units::Distance::fromNM(0.3).toM();
+    case 7:
+        return Units::Distance::fromNM(0.1).toM();
+    case 8:
+        return Units::Distance::fromNM(0.05).toM();
+    case 9:
+        return 30.0;
+    case 10:
+        return 10.0;
+    case 11:
+        return 3.0;
+    default:
+        break;
+    }
+    return qQNaN();
+}
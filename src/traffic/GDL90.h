@@ -0,0 +1,340 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QByteArrayView>
+
+#include <array>
+#include <cstring>
+
+
+namespace Traffic::GDL90 {
+
+/*! \brief CRC-16 checksum as specified by GDL90
+ *
+ *  This is the CRC-CCITT checksum, computed as described in the GDL90
+ *  specification.  The implementation processes eight bytes per step
+ *  ("slice-by-8").
+ *
+ *  @param data Pointer to data
+ *
+ *  @param size Number of bytes
+ *
+ *  @returns Checksum
+ */
+auto crc16(const quint8* data, qsizetype size) -> quint16;
+
+
+/*! \brief Frame a GDL90 message
+ *
+ *  This method writes a complete GDL90 message: flag byte, message ID,
+ *  escaped payload, escaped checksum and closing flag byte.
+ *
+ *  @param messageID Message ID
+ *
+ *  @param payload Message data, without message ID
+ *
+ *  @param size Size of payload
+ *
+ *  @param out Output buffer
+ *
+ *  @param capacity Size of output buffer
+ *
+ *  @returns Number of bytes written, or 0 if the output buffer is too small
+ */
+auto writeFrame(quint8 messageID, const quint8* payload, qsizetype size, quint8* out, qsizetype capacity) -> qsizetype;
+
+
+/*! \brief GDL90 message
+ *
+ *  This is a view into the unescaped message.  It does not own the data and
+ *  is valid only during the callback that receives it.
+ */
+struct Frame {
+    /*! \brief Message ID */
+    quint8 messageID {0};
+
+    /*! \brief Message data, without message ID and checksum */
+    const quint8* payload {nullptr};
+
+    /*! \brief Size of payload */
+    qsizetype size {0};
+};
+
+
+/*! \brief Streaming GDL90 deframer
+ *
+ *  GDL90 messages are delimited by flag bytes 0x7e, and the bytes 0x7d and
+ *  0x7e within a message are escaped.  This class cuts a byte stream into
+ *  messages, unescapes them and verifies their checksums.  Bytes of an
+ *  unfinished message are kept in a fixed buffer until the rest of the
+ *  message arrives.
+ *
+ *  Messages that lie completely within the data passed to feed() and contain
+ *  no escape sequences are not copied; the frame then points directly into
+ *  the caller's data.
+ */
+class Deframer {
+public:
+    /*! \brief Maximal size of a message
+     *
+     *  Longer messages are dropped.  The longest message defined by GDL90,
+     *  the uplink data message, has 436 bytes.
+     */
+    static constexpr qsizetype maxMessageSize = 512;
+
+    /*! \brief Process data
+     *
+     *  @param data Bytes received
+     *
+     *  @param onFrame Callable with signature void(const Frame&). It is
+     *  called for every complete message with a valid checksum.
+     */
+    template<typename F> void feed(QByteArrayView data, F&& onFrame)
+    {
+        const auto* pos = reinterpret_cast<const quint8*>(data.data());
+        const auto* end = pos + data.size();
+        while (pos < end) {
+            const auto* flag = static_cast<const quint8*>(memchr(pos, 0x7e, end-pos));
+            const auto* chunkEnd = (flag != nullptr) ? flag : end;
+
+            if ((flag != nullptr) && (m_size == 0) && !m_escaped && !m_overflow
+                && (memchr(pos, 0x7d, chunkEnd-pos) == nullptr)) {
+                // Complete message without escape sequences: no copy needed
+                deliver(pos, chunkEnd-pos, onFrame);
+            } else {
+                append(pos, chunkEnd);
+                if (flag != nullptr) {
+                    finish(onFrame);
+                }
+            }
+            if (flag == nullptr) {
+                break;
+            }
+            pos = flag + 1;
+        }
+    }
+
+    /*! \brief Terminate the current message
+     *
+     *  This method treats the bytes received since the last flag byte as a
+     *  complete message. Call this at the end of a datagram, if the sender
+     *  does not terminate its messages with a flag byte.
+     *
+     *  @param onFrame Callable, as in feed()
+     */
+    template<typename F> void finish(F&& onFrame)
+    {
+        if (!m_escaped && !m_overflow) {
+            deliver(m_buffer.data(), m_size, onFrame);
+        } else {
+            m_checksumErrors++;
+        }
+        reset();
+    }
+
+    /*! \brief Number of messages with invalid checksum or framing
+     *
+     *  Messages that are too long, too short or whose checksum does not match
+     *  are dropped and counted.  Empty messages between two flag bytes are
+     *  not counted.
+     *
+     *  @returns Number of messages dropped since the last call to this
+     *  method
+     */
+    auto takeChecksumErrors() -> qsizetype
+    {
+        auto result = m_checksumErrors;
+        m_checksumErrors = 0;
+        return result;
+    }
+
+    /*! \brief Discard the current message */
+    void reset()
+    {
+        m_size = 0;
+        m_escaped = false;
+        m_overflow = false;
+    }
+
+private:
+    // Unescapes bytes into m_buffer
+    void append(const quint8* begin, const quint8* end);
+
+    // Verifies the checksum and calls onFrame
+    template<typename F> void deliver(const quint8* data, qsizetype size, F& onFrame)
+    {
+        if (size == 0) {
+            return;
+        }
+        if (size < 3) {
+            m_checksumErrors++;
+            return;
+        }
+        quint16 savedCRC = data[size-2] | (data[size-1] << 8U);
+        if (crc16(data, size-2) != savedCRC) {
+            m_checksumErrors++;
+            return;
+        }
+        onFrame( Frame {data[0], data+1, size-3} );
+    }
+
+    // Unescaped bytes of the current message
+    std::array<quint8, maxMessageSize> m_buffer {};
+    qsizetype m_size {0};
+
+    // True if the last byte was the escape byte 0x7d
+    bool m_escaped {false};
+
+    // True if the current message is too long
+    bool m_overflow {false};
+
+    // Number of messages dropped, see takeChecksumErrors()
+    qsizetype m_checksumErrors {0};
+};
+
+
+/*! \brief Heartbeat message (message ID 0) */
+struct Heartbeat {
+    /*! \brief Status byte 1 */
+    quint8 status1 {0};
+
+    /*! \brief Status byte 2 */
+    quint8 status2 {0};
+
+    /*! \brief Size of the encoded message, without message ID */
+    static constexpr qsizetype encodedSize = 6;
+
+    /*! \brief Encode message
+     *
+     *  @param payload Output buffer for encodedSize bytes
+     */
+    void encode(quint8* payload) const;
+
+    /*! \brief Decode message
+     *
+     *  @param frame Message
+     *
+     *  @returns True on success. Fails if the frame is shorter than
+     *  encodedSize
+     */
+    auto decode(const Frame& frame) -> bool;
+};
+
+
+/*! \brief Ownship or traffic report (message IDs 10 and 20) */
+struct TargetReport {
+    /*! \brief Traffic alert status, 1 if a traffic alert is active */
+    quint8 alertStatus {0};
+
+    /*! \brief Address type */
+    quint8 addressType {0};
+
+    /*! \brief Participant address, 24 bits */
+    quint32 address {0};
+
+    /*! \brief Latitude in degrees */
+    double latitude {0.0};
+
+    /*! \brief Longitude in degrees */
+    double longitude {0.0};
+
+    /*! \brief True if pressure altitude is known */
+    bool hasPressureAltitude {false};
+
+    /*! \brief Pressure altitude in feet */
+    double pressureAltitudeFT {0.0};
+
+    /*! \brief Miscellaneous indicators */
+    quint8 miscIndicators {0};
+
+    /*! \brief Navigation accuracy category for position */
+    quint8 NACp {0};
+
+    /*! \brief True if horizontal velocity is known */
+    bool hasHorizontalVelocity {false};
+
+    /*! \brief Horizontal velocity in knots */
+    double horizontalVelocityKN {0.0};
+
+    /*! \brief True if vertical velocity is known */
+    bool hasVerticalVelocity {false};
+
+    /*! \brief Vertical velocity in feet per minute */
+    double verticalVelocityFPM {0.0};
+
+    /*! \brief True if true track is known */
+    bool hasTrack {false};
+
+    /*! \brief True track in degrees */
+    double trackDEG {0.0};
+
+    /*! \brief Emitter category */
+    quint8 emitterCategory {0};
+
+    /*! \brief Call sign, padded with spaces, not null-terminated */
+    std::array<char, 8> callSign {};
+
+    /*! \brief Size of the encoded message, without message ID */
+    static constexpr qsizetype encodedSize = 27;
+
+    /*! \brief Encode message
+     *
+     *  Values that are out of range are clamped.
+     *
+     *  @param payload Output buffer for encodedSize bytes
+     */
+    void encode(quint8* payload) const;
+
+    /*! \brief Horizontal accuracy for the NACp
+     *
+     *  @returns Accuracy in meters, or NaN if unknown
+     */
+    [[nodiscard]] auto horizontalAccuracyM() const -> double;
+
+    /*! \brief Decode message
+     *
+     *  @param frame Message
+     *
+     *  @returns True on success
+     */
+    auto decode(const Frame& frame) -> bool;
+};
+
+
+/*! \brief Ownship geometric altitude message (message ID 11) */
+struct OwnshipGeometricAltitude {
+    /*! \brief Geometric altitude in feet */
+    double altitudeFT {0.0};
+
+    /*! \brief Vertical figure of merit in meters */
+    quint16 verticalFigureOfMeritM {0};
+
+    /*! \brief Decode message
+     *
+     *  @param frame Message
+     *
+     *  @returns True on success
+     */
+    auto decode(const Frame& frame) -> bool;
+};
+
+} // namespace Traffic::GDL90
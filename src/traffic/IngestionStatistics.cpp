@@ -0,0 +1,76 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "traffic/DatagramFilter.h"
+#include "traffic/IngestionStatistics.h"
+
+
+// Member functions
+
+auto Traffic::IngestionStatistics::snapshot() const -> Snapshot
+{
+    Snapshot result;
+    result.time = now();
+    result.bytes = m_bytes.load(std::memory_order_relaxed);
+    result.messages = m_messages.load(std::memory_order_relaxed);
+    result.checksumErrors = m_checksumErrors.load(std::memory_order_relaxed);
+    result.unknownMessages = m_unknownMessages.load(std::memory_order_relaxed);
+    if (m_datagramFilter != nullptr) {
+        result.datagrams = m_datagramFilter->received();
+        result.duplicates = m_datagramFilter->duplicates();
+    }
+    result.parseNanoseconds = m_parseNanoseconds.load(std::memory_order_relaxed);
+    result.lastMessageTime = m_lastMessageTime.load(std::memory_order_relaxed);
+    return result;
+}
+
+
+auto Traffic::IngestionStatistics::Snapshot::toJSON(const Snapshot& previous) const -> QJsonObject
+{
+    QJsonObject result;
+    result.insert(QStringLiteral("bytes"), static_cast<qint64>(bytes));
+    result.insert(QStringLiteral("messages"), static_cast<qint64>(messages));
+    result.insert(QStringLiteral("checksumErrors"), static_cast<qint64>(checksumErrors));
+    result.insert(QStringLiteral("unknownMessages"), static_cast<qint64>(unknownMessages));
+    result.insert(QStringLiteral("datagrams"), static_cast<qint64>(datagrams));
+    result.insert(QStringLiteral("duplicates"), static_cast<qint64>(duplicates));
+    if (messages > 0) {
+        result.insert(QStringLiteral("parseMicrosecondsPerMessage"), static_cast<double>(parseNanoseconds)/(1000.0*static_cast<double>(messages)));
+    }
+    if (lastMessageTime > 0) {
+        result.insert(QStringLiteral("lastMessageAge"), static_cast<double>(time-lastMessageTime)/1e9);
+    } else {
+        result.insert(QStringLiteral("lastMessageAge"), -1.0);
+    }
+
+    // Rates
+    if ((previous.time > 0) && (time > previous.time)) {
+        auto seconds = static_cast<double>(time-previous.time)/1e9;
+        auto rate = [seconds](quint64 current, quint64 earlier) {
+            return (current >= earlier) ? static_cast<double>(current-earlier)/seconds : 0.0;
+        };
+        result.insert(QStringLiteral("bytesPerSecond"), rate(bytes, previous.bytes));
+        result.insert(QStringLiteral("messagesPerSecond"), rate(messages, previous.messages));
+        result.insert(QStringLiteral("checksumErrorsPerSecond"), rate(checksumErrors, previous.checksumErrors));
+        result.insert(QStringLiteral("unknownMessagesPerSecond"), rate(unknownMessages, previous.unknownMessages));
+        result.insert(QStringLiteral("duplicatesPerSecond"), rate(duplicates, previous.duplicates));
+    }
+    return result;
+}
@@ -0,0 +1,195 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QJsonObject>
+
+#include <atomic>
+#include <chrono>
+
+
+namespace Traffic {
+
+class DatagramFilter;
+
+/*! \brief Health and throughput counters of a traffic data source
+ *
+ *  This class counts the data that a traffic data source decodes: bytes,
+ *  messages, messages with bad checksums, messages of unknown type and the
+ *  time spent parsing. All counters are cumulative and atomic, so that they
+ *  can be updated in the traffic I/O thread and read from any other thread
+ *  without locking. Datagrams and duplicates are counted by the
+ *  DatagramFilter of the source, if any, and reported alongside, see
+ *  setDatagramFilter().
+ *
+ *  Rates are computed by comparing two snapshots, see Snapshot::toJSON().
+ */
+
+class IngestionStatistics
+{
+public:
+    /*! \brief Values of all counters at one point in time */
+    struct Snapshot {
+        /*! \brief Time of the snapshot, in nanoseconds on the steady clock */
+        qint64 time {0};
+
+        /*! \brief Number of bytes handed to the decoders */
+        quint64 bytes {0};
+
+        /*! \brief Number of messages decoded */
+        quint64 messages {0};
+
+        /*! \brief Number of messages with invalid checksum or framing */
+        quint64 checksumErrors {0};
+
+        /*! \brief Number of messages of unknown type */
+        quint64 unknownMessages {0};
+
+        /*! \brief Number of datagrams checked for duplicates */
+        quint64 datagrams {0};
+
+        /*! \brief Number of duplicate datagrams dropped */
+        quint64 duplicates {0};
+
+        /*! \brief Total parse time, in nanoseconds */
+        quint64 parseNanoseconds {0};
+
+        /*! \brief Time of the last message, in nanoseconds on the steady clock, or 0 if no message has been decoded */
+        qint64 lastMessageTime {0};
+
+        /*! \brief Description in JSON format
+         *
+         *  @param previous Earlier snapshot of the same counters, used to
+         *  compute rates. If previous.time is zero, for instance for a
+         *  default-constructed Snapshot, rates are not included.
+         *
+         *  @returns JSON object with totals, rates per second, mean parse time
+         *  per message in microseconds, and the age of the last message in
+         *  seconds (negative if no message has been decoded)
+         */
+        [[nodiscard]] auto toJSON(const Snapshot& previous) const -> QJsonObject;
+    };
+
+    /*! \brief Count bytes handed to the decoders
+     *
+     *  @param size Number of bytes
+     */
+    void addBytes(qsizetype size)
+    {
+        m_bytes.fetch_add(static_cast<quint64>(size), std::memory_order_relaxed);
+    }
+
+    /*! \brief Count a decoded message */
+    void addMessage()
+    {
+        m_messages.fetch_add(1, std::memory_order_relaxed);
+        m_lastMessageTime.store(now(), std::memory_order_relaxed);
+    }
+
+    /*! \brief Count messages with invalid checksum or framing
+     *
+     *  @param count Number of messages
+     */
+    void addChecksumErrors(qsizetype count = 1)
+    {
+        if (count > 0) {
+            m_checksumErrors.fetch_add(static_cast<quint64>(count), std::memory_order_relaxed);
+        }
+    }
+
+    /*! \brief Count a message of unknown type */
+    void addUnknownMessage()
+    {
+        m_unknownMessages.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*! \brief Report the counters of a duplicate filter
+     *
+     *  Snapshots take the number of datagrams and duplicates from this filter.
+     *  The pointer is not protected against concurrent access; set it before
+     *  the statistics are read from other threads, typically in the
+     *  constructor of the source.
+     *
+     *  @param filter Filter, which must outlive this object
+     */
+    void setDatagramFilter(const Traffic::DatagramFilter* filter)
+    {
+        m_datagramFilter = filter;
+    }
+
+    /*! \brief Current values of all counters
+     *
+     *  This method can be called from any thread.
+     *
+     *  @returns Snapshot
+     */
+    [[nodiscard]] auto snapshot() const -> Snapshot;
+
+    /*! \brief Measures parse time
+     *
+     *  Construct an object of this class on the stack at the beginning of a
+     *  decoder function. The time until the object is destroyed is added to
+     *  the parse time.
+     */
+    class ParseTimer
+    {
+    public:
+        /*! \brief Start measuring
+         *
+         *  @param statistics Statistics that the parse time is added to
+         */
+        explicit ParseTimer(IngestionStatistics& statistics) : m_statistics(statistics), m_start(now()) {}
+
+        /*! \brief Stop measuring and add time */
+        ~ParseTimer()
+        {
+            m_statistics.m_parseNanoseconds.fetch_add(static_cast<quint64>(now()-m_start), std::memory_order_relaxed);
+        }
+
+    private:
+        Q_DISABLE_COPY_MOVE(ParseTimer)
+
+        IngestionStatistics& m_statistics;
+        qint64 m_start;
+    };
+
+    /*! \brief Current time on the steady clock
+     *
+     *  @returns Nanoseconds since an arbitrary, fixed point in time
+     */
+    static auto now() -> qint64
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    std::atomic<quint64> m_bytes {0};
+    std::atomic<quint64> m_messages {0};
+    std::atomic<quint64> m_checksumErrors {0};
+    std::atomic<quint64> m_unknownMessages {0};
+    std::atomic<quint64> m_parseNanoseconds {0};
+    std::atomic<qint64> m_lastMessageTime {0};
+
+    // Counts datagrams and duplicates, see setDatagramFilter()
+    const Traffic::DatagramFilter* m_datagramFilter {nullptr};
+};
+
+} // namespace Traffic
@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "traffic/IngestionStatisticsModel.h"
+
+
+Traffic::IngestionStatisticsModel::IngestionStatisticsModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+
+void Traffic::IngestionStatisticsModel::setActive(bool newActive)
+{
+    if (newActive == m_active) {
+        return;
+    }
+    m_active = newActive;
+    emit activeChanged();
+}
+
+
+auto Traffic::IngestionStatisticsModel::data(const QModelIndex& index, int role) const -> QVariant
+{
+    if (!index.isValid() || (index.row() < 0) || (index.row() >= m_rows.size())) {
+        return {};
+    }
+    const auto& row = m_rows[index.row()];
+
+    switch(role) {
+    case SourceNameRole:
+        return row.sourceName;
+    case StatisticsRole:
+        return row.statistics;
+    default:
+        return {};
+    }
+}
+
+
+auto Traffic::IngestionStatisticsModel::roleNames() const -> QHash<int, QByteArray>
+{
+    return {
+        {SourceNameRole, "sourceName"},
+        {StatisticsRole, "statistics"}
+    };
+}
+
+
+auto Traffic::IngestionStatisticsModel::rowCount(const QModelIndex& parent) const -> int
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return static_cast<int>(m_rows.size());
+}
+
+
+void Traffic::IngestionStatisticsModel::setStatistics(const QStringList& sourceNames, const QVector<QVariantMap>& statistics)
+{
+    Q_ASSERT( sourceNames.size() == statistics.size() );
+
+    if (sourceNames.size() != m_rows.size()) {
+        beginResetModel();
+        m_rows.resize(sourceNames.size());
+        for(qsizetype i=0; i<m_rows.size(); i++) {
+            m_rows[i] = {sourceNames.at(i), statistics.at(i)};
+        }
+        endResetModel();
+    } else {
+        for(qsizetype i=0; i<m_rows.size(); i++) {
+            QList<int> roles;
+            if (m_rows.at(i).sourceName != sourceNames.at(i)) {
+                m_rows[i].sourceName = sourceNames.at(i);
+                roles.append(SourceNameRole);
+            }
+            if (m_rows.at(i).statistics != statistics.at(i)) {
+                m_rows[i].statistics = statistics.at(i);
+                roles.append(StatisticsRole);
+            }
+            if (!roles.isEmpty()) {
+                emit dataChanged(index(static_cast<int>(i)), index(static_cast<int>(i)), roles);
+            }
+        }
+    }
+
+    int receiving = 0;
+    foreach(const auto& row, m_rows) {
+        if (row.statistics.value(QStringLiteral("bytes")).toLongLong() > 0) {
+            receiving++;
+        }
+    }
+    if (receiving != m_receivingSources) {
+        m_receivingSources = receiving;
+        emit receivingSourcesChanged();
+    }
+}
@@ -0,0 +1,155 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QAbstractListModel>
+
+
+namespace Traffic {
+
+/*! \brief List model of ingestion statistics, for use in QML
+ *
+ *  This model holds one row per traffic data source, in order of
+ *  preference.  The role "statistics" is a map with the keys described in
+ *  IngestionStatistics::Snapshot::toJSON(), the role "sourceName" holds the
+ *  name of the data source.  Rows are updated in place, so that views keep
+ *  their delegates.
+ *
+ *  Sampling the statistics is only worthwhile while a view shows them.
+ *  Views set the property active while they are visible; the owner of the
+ *  model updates the model only while the property is set.
+ */
+
+class IngestionStatisticsModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    /*! \brief Roles provided by this model */
+    enum Roles {
+        SourceNameRole = Qt::UserRole + 1,
+        StatisticsRole
+    };
+    Q_ENUM(Roles)
+
+    /*! \brief Default constructor
+     *
+     *  @param parent The standard QObject parent pointer
+     */
+    explicit IngestionStatisticsModel(QObject* parent = nullptr);
+
+    // Standard destructor
+    ~IngestionStatisticsModel() override = default;
+
+
+    //
+    // Properties
+    //
+
+    /*! \brief Indicates if a view shows the statistics */
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+
+    /*! \brief Number of data sources that have received data */
+    Q_PROPERTY(int receivingSources READ receivingSources NOTIFY receivingSourcesChanged)
+
+
+    //
+    // Getter Methods
+    //
+
+    /*! \brief Getter function for the property with the same name
+     *
+     *  @returns Property active
+     */
+    [[nodiscard]] auto active() const -> bool
+    {
+        return m_active;
+    }
+
+    /*! \brief Getter function for the property with the same name
+     *
+     *  @returns Property receivingSources
+     */
+    [[nodiscard]] auto receivingSources() const -> int
+    {
+        return m_receivingSources;
+    }
+
+
+    //
+    // Setter Methods
+    //
+
+    /*! \brief Setter function for the property with the same name
+     *
+     *  @param newActive Property active
+     */
+    void setActive(bool newActive);
+
+
+    //
+    // Methods
+    //
+
+    /*! \brief Replace the statistics
+     *
+     *  If the number of data sources is unchanged, the rows are updated in
+     *  place and dataChanged() is emitted only for rows whose values have
+     *  changed.
+     *
+     *  @param sourceNames Names of the data sources
+     *
+     *  @param statistics Statistics of the data sources, as described in
+     *  IngestionStatistics::Snapshot::toJSON(). The list must have the same
+     *  length as sourceNames.
+     */
+    void setStatistics(const QStringList& sourceNames, const QVector<QVariantMap>& statistics);
+
+    // See documentation in base class
+    [[nodiscard]] auto data(const QModelIndex& index, int role = Qt::DisplayRole) const -> QVariant override;
+
+    // See documentation in base class
+    [[nodiscard]] auto roleNames() const -> QHash<int, QByteArray> override;
+
+    // See documentation in base class
+    [[nodiscard]] auto rowCount(const QModelIndex& parent = QModelIndex()) const -> int override;
+
+signals:
+    /*! \brief Notifier signal */
+    void activeChanged();
+
+    /*! \brief Notifier signal */
+    void receivingSourcesChanged();
+
+private:
+    Q_DISABLE_COPY_MOVE(IngestionStatisticsModel)
+
+    // Row of the model
+    struct Row {
+        QString sourceName;
+        QVariantMap statistics;
+    };
+
+    QVector<Row> m_rows;
+    bool m_active {false};
+    int m_receivingSources {0};
+};
+
+} // namespace Traffic
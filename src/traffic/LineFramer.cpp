@@ -0,0 +1,83 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <cstring>
+
+#include "traffic/LineFramer.h"
+
+
+// Member functions
+
+void Traffic::LineFramer::commit(qsizetype size)
+{
+    if (size > 0) {
+        m_tail += size;
+    }
+}
+
+
+auto Traffic::LineFramer::findNewline() -> qsizetype
+{
+    while (m_scanned < m_tail) {
+        auto offset = m_scanned % capacity;
+        auto length = qMin(m_tail-m_scanned, capacity-offset);
+        const auto* begin = m_buffer.data()+offset;
+        const auto* newline = static_cast<const char*>(memchr(begin, '\n', length));
+        if (newline != nullptr) {
+            auto result = m_scanned + (newline-begin);
+            m_scanned = result;
+            return result;
+        }
+        m_scanned += length;
+    }
+    return -1;
+}
+
+
+auto Traffic::LineFramer::lineView(qsizetype end) -> QByteArrayView
+{
+    auto offset = m_head % capacity;
+    auto length = end-m_head;
+    if (offset+length <= capacity) {
+        return {m_buffer.data()+offset, length};
+    }
+
+    auto firstPart = capacity-offset;
+    memcpy(m_scratch.data(), m_buffer.data()+offset, firstPart);
+    memcpy(m_scratch.data()+firstPart, m_buffer.data(), length-firstPart);
+    return {m_scratch.data(), length};
+}
+
+
+void Traffic::LineFramer::reset()
+{
+    m_head = 0;
+    m_scanned = 0;
+    m_tail = 0;
+    m_discarding = false;
+}
+
+
+auto Traffic::LineFramer::writeBuffer() -> std::span<char>
+{
+    auto offset = m_tail % capacity;
+    auto free = capacity - (m_tail-m_head);
+    return {m_buffer.data()+offset, static_cast<size_t>(qMin(free, capacity-offset))};
+}
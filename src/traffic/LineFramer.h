@@ -0,0 +1,133 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QByteArrayView>
+
+#include <array>
+#include <span>
+
+
+namespace Traffic {
+
+/*! \brief Splits a byte stream into lines
+ *
+ *  This class collects bytes in a fixed ring buffer and hands out complete
+ *  lines as views into that buffer, without decoding or copying them.  Lines
+ *  may be terminated by "\n" or "\r\n".  Newlines are located with memchr,
+ *  which the C library implements with vector instructions on all relevant
+ *  platforms.
+ *
+ *  Lines longer than maxLineLength are dropped, so that a misbehaving device
+ *  cannot make the buffer grow.
+ *
+ *  Typical use:
+ *
+ *  @code
+ *  auto buffer = framer.writeBuffer();
+ *  framer.commit( device.read(buffer.data(), buffer.size()) );
+ *  framer.takeLines([](QByteArrayView line) { ... });
+ *  @endcode
+ */
+class LineFramer {
+public:
+    /*! \brief Maximal length of a line, without line terminator */
+    static constexpr qsizetype maxLineLength = 1024;
+
+    /*! \brief Size of the ring buffer */
+    static constexpr qsizetype capacity = 4096;
+
+    /*! \brief Free space in the ring buffer
+     *
+     *  @returns Contiguous, writable part of the ring buffer.  If takeLines()
+     *  has been called after the last commit(), this is never empty.
+     */
+    [[nodiscard]] auto writeBuffer() -> std::span<char>;
+
+    /*! \brief Mark bytes as written
+     *
+     *  @param size Number of bytes written to the start of writeBuffer().
+     *  Negative values are ignored, so that the return value of
+     *  QIODevice::read can be passed on directly.
+     */
+    void commit(qsizetype size);
+
+    /*! \brief Hand out complete lines
+     *
+     *  @param onLine Callable with signature void(QByteArrayView), called for
+     *  each complete line, without line terminator. The view is valid only
+     *  during the call.
+     */
+    template<typename F> void takeLines(F&& onLine)
+    {
+        while (true) {
+            auto newline = findNewline();
+            if (newline < 0) {
+                // Drop incomplete lines that are already too long
+                if (m_tail-m_head > maxLineLength) {
+                    m_head = m_tail;
+                    m_scanned = m_tail;
+                    m_discarding = true;
+                }
+                return;
+            }
+
+            if (!m_discarding && (newline-m_head <= maxLineLength)) {
+                auto line = lineView(newline);
+                if (line.endsWith('\r')) {
+                    line.chop(1);
+                }
+                onLine(line);
+            }
+            m_head = newline+1;
+            m_scanned = m_head;
+            m_discarding = false;
+        }
+    }
+
+    /*! \brief Discard all data */
+    void reset();
+
+private:
+    // Absolute stream position of the next '\n' at or after m_scanned, or -1
+    // if there is none. Advances m_scanned.
+    auto findNewline() -> qsizetype;
+
+    // View to the bytes between m_head and end. If these bytes wrap around
+    // the end of the ring buffer, they are copied to m_scratch.
+    auto lineView(qsizetype end) -> QByteArrayView;
+
+    // Ring buffer. The members m_head, m_scanned and m_tail are absolute
+    // positions in the byte stream; the position p is stored at
+    // m_buffer[p % capacity].
+    std::array<char, capacity> m_buffer {};
+    qsizetype m_head {0};
+    qsizetype m_scanned {0};
+    qsizetype m_tail {0};
+
+    // Linear copy of lines that wrap around the end of the ring buffer
+    std::array<char, maxLineLength> m_scratch {};
+
+    // True if the remainder of an overlong line is being skipped
+    bool m_discarding {false};
+};
+
+} // namespace Traffic
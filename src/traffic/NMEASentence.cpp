@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtNumeric>
+#include <charconv>
+
+#include "traffic/NMEASentence.h"
+
+
+Traffic::NMEASentence::NMEASentence(QByteArrayView sentence)
+{
+    // Ignore trailing line breaks and white space
+    while (!sentence.isEmpty() && ((sentence.back() == '\n') || (sentence.back() == '\r') || (sentence.back() == ' '))) {
+        sentence.chop(1);
+    }
+
+    // Check that line starts with a dollar sign
+    if (sentence.isEmpty() || (sentence.front() != '$')) {
+        return;
+    }
+
+    // Go through the sentence once, computing the checksum and cutting the
+    // sentence into fields along the way. The first field is the message type.
+    bool messageTypeFound = false;
+    auto storeField = [&](QByteArrayView field) {
+        if (!messageTypeFound) {
+            m_tag = packTag(std::string_view(field.data(), field.size()));
+            messageTypeFound = true;
+            return;
+        }
+        if (m_numFields < maxFields) {
+            m_fields[m_numFields++] = field;
+        }
+    };
+
+    quint8 checksum = 0;
+    qsizetype fieldStart = 1;
+    qsizetype index = 1;
+    for(; index < sentence.size(); index++) {
+        auto character = sentence[index];
+        if (character == '*') {
+            break;
+        }
+        checksum ^= static_cast<quint8>(character);
+        if (character == ',') {
+            storeField(sentence.sliced(fieldStart, index-fieldStart));
+            fieldStart = index+1;
+        }
+    }
+    if (index == sentence.size()) {
+        m_tag = 0;
+        m_numFields = 0;
+        return;
+    }
+    storeField(sentence.sliced(fieldStart, index-fieldStart));
+
+    // Check the NMEA checksum
+    bool ok = false;
+    auto expectedChecksum = parseInt(sentence.sliced(index+1), &ok, 16);
+    if (!ok || (expectedChecksum != checksum)) {
+        m_tag = 0;
+        m_numFields = 0;
+        return;
+    }
+
+    m_isValid = true;
+}
+
+
+auto Traffic::NMEASentence::toDouble(qsizetype index, bool* ok) const -> double
+{
+    return parseDouble((*this)[index], ok);
+}
+
+
+auto Traffic::NMEASentence::toInt(qsizetype index, bool* ok, int base) const -> int
+{
+    return parseInt((*this)[index], ok, base);
+}
+
+
+auto Traffic::NMEASentence::toLatLong(qsizetype index, qsizetype degreeDigits) const -> double
+{
+    auto field = (*this)[index];
+    if (field.size() <= degreeDigits) {
+        return qQNaN();
+    }
+
+    bool ok1 = false;
+    bool ok2 = false;
+    auto result = parseDouble(field.first(degreeDigits), &ok1) + parseDouble(field.sliced(degreeDigits), &ok2)/60.0;
+    if (!ok1 || !ok2) {
+        return qQNaN();
+    }
+
+    if (fieldEquals(index+1, "S") || fieldEquals(index+1, "W")) {
+        result *= -1.0;
+    }
+    return result;
+}
+
+
+auto Traffic::NMEASentence::parseDouble(QByteArrayView data, bool* ok) -> double
+{
+    // std::from_chars does not accept a leading plus sign
+    if (data.startsWith('+')) {
+        data = data.sliced(1);
+    }
+
+    double result = qQNaN();
+    bool success = false;
+    if (!data.isEmpty()) {
+#if defined(__cpp_lib_to_chars)
+        const auto* end = data.data() + data.size();
+        auto [ptr, errorCode] = std::from_chars(data.data(), end, result);
+        success = (errorCode == std::errc()) && (ptr == end);
+#else
+        // Standard libraries without floating-point support in std::from_chars
+        result = data.toDouble(&success);
+#endif
+    }
+
+    if (ok != nullptr) {
+        *ok = success;
+    }
+    if (!success) {
+        return qQNaN();
+    }
+    return result;
+}
+
+
+auto Traffic::NMEASentence::parseInt(QByteArrayView data, bool* ok, int base) -> int
+{
+    if (data.startsWith('+')) {
+        data = data.sliced(1);
+    }
+
+    int result = 0;
+    bool success = false;
+    if (!data.isEmpty()) {
+        const auto* end = data.data() + data.size();
+        auto [ptr, errorCode] = std::from_chars(data.data(), end, result, base);
+        success = (errorCode == std::errc()) && (ptr == end);
+    }
+
+    if (ok != nullptr) {
+        *ok = success;
+    }
+    if (!success) {
+        return 0;
+    }
+    return result;
+}
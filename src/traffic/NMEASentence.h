@@ -0,0 +1,208 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QByteArrayView>
+#include <array>
+#include <string_view>
+
+namespace Traffic {
+
+/*! \brief Zero-copy tokenizer for NMEA/FLARM sentences
+ *
+ *  This class splits one NMEA sentence, such as
+ *  "$PFLAA,0,1587,1588,40,1,AA1237,225,,37,-1.6,1*7F", into its fields without
+ *  allocating memory.  The constructor verifies the leading dollar sign and the
+ *  checksum in a single pass over the data, recording the positions of the
+ *  field separators along the way.  The fields are then handed out as
+ *  QByteArrayViews into the original data, which must therefore outlive the
+ *  NMEASentence object.
+ *
+ *  The message type is packed into an integer, so that consumers can dispatch
+ *  with a switch statement.
+ *
+ *  @code
+ *  Traffic::NMEASentence sentence(data);
+ *  switch(sentence.tag()) {
+ *  case Traffic::NMEASentence::packTag("PGRMZ"):
+ *      …
+ *  }
+ *  @endcode
+ */
+
+class NMEASentence {
+
+public:
+    /*! \brief Maximal number of fields, excluding the message type
+     *
+     *  Fields beyond this number are silently dropped.
+     */
+    static constexpr qsizetype maxFields = 24;
+
+    /*! \brief Tokenize a sentence
+     *
+     *  @param sentence Data containing exactly one NMEA sentence.  Trailing
+     *  line breaks are ignored.
+     */
+    explicit NMEASentence(QByteArrayView sentence);
+
+    /*! \brief Pack a message type into an integer
+     *
+     *  @param messageType Message type, with at most eight characters
+     *
+     *  @returns Integer that identifies the message type uniquely
+     */
+    static constexpr auto packTag(std::string_view messageType) -> quint64
+    {
+        quint64 result = 0;
+        for(auto character : messageType.substr(0, 8)) {
+            result = (result << 8) | static_cast<quint8>(character);
+        }
+        return result;
+    }
+
+    /*! \brief Validity
+     *
+     *  @returns True if the sentence starts with a dollar sign and the
+     *  checksum is correct.
+     */
+    [[nodiscard]] auto isValid() const -> bool { return m_isValid; }
+
+    /*! \brief Packed message type
+     *
+     *  @returns Message type, packed with packTag(), or 0 if the sentence is
+     *  invalid
+     */
+    [[nodiscard]] auto tag() const -> quint64 { return m_tag; }
+
+    /*! \brief Number of fields, excluding the message type
+     *
+     *  @returns Number of fields
+     */
+    [[nodiscard]] auto size() const -> qsizetype { return m_numFields; }
+
+    /*! \brief Field
+     *
+     *  @param index Field index, where 0 is the first field after the message
+     *  type
+     *
+     *  @returns Field content, or an empty view if index is out of range
+     */
+    [[nodiscard]] auto operator[](qsizetype index) const -> QByteArrayView
+    {
+        if ((index < 0) || (index >= m_numFields)) {
+            return {};
+        }
+        return m_fields[index];
+    }
+
+    /*! \brief Compare field
+     *
+     *  @param index Field index
+     *
+     *  @param value String to compare with
+     *
+     *  @returns True if the field exists and equals value
+     */
+    [[nodiscard]] auto fieldEquals(qsizetype index, std::string_view value) const -> bool
+    {
+        auto field = (*this)[index];
+        return std::string_view(field.data(), field.size()) == value;
+    }
+
+    /*! \brief Interpret field as floating point number
+     *
+     *  @param index Field index
+     *
+     *  @param ok If not nullptr, set to true if the field contains a valid
+     *  number, and to false otherwise
+     *
+     *  @returns Number, or NaN if the field does not contain a valid number
+     */
+    [[nodiscard]] auto toDouble(qsizetype index, bool* ok=nullptr) const -> double;
+
+    /*! \brief Interpret field as integer
+     *
+     *  @param index Field index
+     *
+     *  @param ok If not nullptr, set to true if the field contains a valid
+     *  number, and to false otherwise
+     *
+     *  @param base Number base
+     *
+     *  @returns Number, or 0 if the field does not contain a valid number
+     */
+    [[nodiscard]] auto toInt(qsizetype index, bool* ok=nullptr, int base=10) const -> int;
+
+    /*! \brief Interpret field as NMEA latitude or longitude
+     *
+     *  NMEA encodes angles as (d)ddmm.mmmm, followed by a hemisphere field
+     *  "N", "S", "E" or "W".
+     *
+     *  @param index Index of the field that contains the angle.  The
+     *  hemisphere is read from the field that follows.
+     *
+     *  @param degreeDigits Number of digits used for the degrees: 2 for
+     *  latitudes, 3 for longitudes
+     *
+     *  @returns Angle in degrees, or NaN on error
+     */
+    [[nodiscard]] auto toLatLong(qsizetype index, qsizetype degreeDigits) const -> double;
+
+    /*! \brief Parse floating point number
+     *
+     *  @param data Number, as a string
+     *
+     *  @param ok If not nullptr, set to true if data contains a valid number,
+     *  and to false otherwise
+     *
+     *  @returns Number, or NaN if data does not contain a valid number
+     */
+    static auto parseDouble(QByteArrayView data, bool* ok=nullptr) -> double;
+
+    /*! \brief Parse integer
+     *
+     *  @param data Number, as a string
+     *
+     *  @param ok If not nullptr, set to true if data contains a valid number,
+     *  and to false otherwise
+     *
+     *  @param base Number base
+     *
+     *  @returns Number, or 0 if data does not contain a valid number
+     */
+    static auto parseInt(QByteArrayView data, bool* ok=nullptr, int base=10) -> int;
+
+private:
+    // Field views, pointing into the data passed to the constructor
+    std::array<QByteArrayView, maxFields> m_fields {};
+
+    // Number of valid entries in m_fields
+    qsizetype m_numFields {0};
+
+    // Packed message type
+    quint64 m_tag {0};
+
+    // Result of the syntax and checksum test
+    bool m_isValid {false};
+};
+
+} // namespace Traffic
@@ -0,0 +1,349 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QRandomGenerator>
+#include <QtMath>
+#include <QtNumeric>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "traffic/GDL90.h"
+#include "traffic/SyntheticTraffic.h"
+
+
+// Static Helper functions
+
+// Appends NMEA checksum and line break to a sentence of the given length in
+// buffer. Returns the new length, or 0 if the buffer is too small.
+auto finishSyntheticSentence(char* buffer, int length, int capacity) -> int
+{
+    if ((length <= 0) || (length >= capacity)) {
+        return 0;
+    }
+    quint8 checksum = 0;
+    for(int i=1; i<length; i++) {
+        checksum ^= static_cast<quint8>(buffer[i]);
+    }
+    auto written = std::snprintf(buffer+length, capacity-length, "*%02X\r\n", checksum);
+    if ((written <= 0) || (length+written >= capacity)) {
+        return 0;
+    }
+    return length+written;
+}
+
+
+// Member functions
+
+void Traffic::SyntheticTraffic::addTarget(const Traffic::SyntheticTraffic::Target& target)
+{
+    m_north.append(target.north.toM());
+    m_east.append(target.east.toM());
+    m_up.append(target.up.toM());
+    m_groundSpeed.append(target.groundSpeed.toMPS());
+    m_track.append(target.track.toDEG());
+    m_turnRate.append(target.turnRate.toDEG());
+    m_climbRate.append(target.climbRate.toMPS());
+}
+
+
+void Traffic::SyntheticTraffic::addRandomTargets(int count, quint32 seed, Units::Distance radius)
+{
+    QRandomGenerator generator(seed);
+    auto uniform = [&](double min, double max) {
+        return min + (max-min)*generator.generateDouble();
+    };
+
+    if (!m_radius.isFinite() || (radius > m_radius)) {
+        m_radius = radius;
+    }
+    for(int i=0; i<count; i++) {
+        // Uniform distribution over the disc
+        auto distance = radius.toM()*std::sqrt(generator.generateDouble());
+        auto bearing = qDegreesToRadians(uniform(0.0, 360.0));
+
+        Target target;
+        target.north = Units::Distance::fromM(distance*std::cos(bearing));
+        target.east = Units::Distance::fromM(distance*std::sin(bearing));
+        target.up = Units::Distance::fromM(uniform(-600.0, 600.0));
+        target.groundSpeed = Units::Speed::fromMPS(uniform(20.0, 70.0));
+        target.track = Units::Angle::fromDEG(uniform(0.0, 360.0));
+        if (generator.bounded(3) == 0) {
+            auto turnRate = uniform(6.0, 15.0);
+            target.turnRate = Units::Angle::fromDEG((generator.bounded(2) == 0) ? turnRate : -turnRate);
+            target.climbRate = Units::Speed::fromMPS(uniform(0.5, 3.0));
+        } else {
+            target.turnRate = Units::Angle::fromDEG(0.0);
+            target.climbRate = Units::Speed::fromMPS(uniform(-1.5, 1.5));
+        }
+        addTarget(target);
+    }
+}
+
+
+void Traffic::SyntheticTraffic::advance(std::chrono::milliseconds time)
+{
+    auto dt = std::chrono::duration<double>(time).count();
+
+    // Targets that leave the area turn towards ownship, so that the density
+    // of traffic stays roughly constant.
+    auto maxDistance = m_radius.isFinite() ? 1.5*m_radius.toM() : qInf();
+    auto size = m_north.size();
+    for(qsizetype i=0; i<size; i++) {
+        auto track = m_track[i] + m_turnRate[i]*dt;
+        auto north = m_north[i];
+        auto east = m_east[i];
+        if (north*north + east*east > maxDistance*maxDistance) {
+            track = qRadiansToDegrees(std::atan2(-east, -north));
+        }
+        track = std::fmod(track+360.0, 360.0);
+        m_track[i] = track;
+        m_north[i] = north + m_groundSpeed[i]*std::cos(qDegreesToRadians(track))*dt;
+        m_east[i] = east + m_groundSpeed[i]*std::sin(qDegreesToRadians(track))*dt;
+        m_up[i] += m_climbRate[i]*dt;
+    }
+}
+
+
+auto Traffic::SyntheticTraffic::alarmLevel(double horizontalDistance, double verticalDistance) -> int
+{
+    verticalDistance = qAbs(verticalDistance);
+    if ((horizontalDistance < 300.0) && (verticalDistance < 100.0)) {
+        return 3;
+    }
+    if ((horizontalDistance < 600.0) && (verticalDistance < 200.0)) {
+        return 2;
+    }
+    if ((horizontalDistance < 1200.0) && (verticalDistance < 300.0)) {
+        return 1;
+    }
+    return 0;
+}
+
+
+void Traffic::SyntheticTraffic::clear()
+{
+    m_north.clear();
+    m_east.clear();
+    m_up.clear();
+    m_groundSpeed.clear();
+    m_track.clear();
+    m_turnRate.clear();
+    m_climbRate.clear();
+    m_latitude.clear();
+    m_longitude.clear();
+    m_radius = {};
+}
+
+
+void Traffic::SyntheticTraffic::computeCoordinates(const Positioning::LocalTangentPlane& plane)
+{
+    auto size = m_north.size();
+    m_latitude.resize(size);
+    m_longitude.resize(size);
+    plane.toLatLon({m_north.constData(), static_cast<size_t>(size)},
+                   {m_east.constData(), static_cast<size_t>(size)},
+                   {m_latitude.data(), static_cast<size_t>(size)},
+                   {m_longitude.data(), static_cast<size_t>(size)});
+}
+
+
+void Traffic::SyntheticTraffic::encode(Protocol protocol, const QGeoPositionInfo& ownship, Units::Distance pressureAltitude, const std::function<void(QByteArrayView)>& onMessage)
+{
+    switch (protocol) {
+    case Protocol::FLARM:
+        encodeFLARM(ownship, onMessage);
+        break;
+    case Protocol::GDL90:
+        encodeGDL90(ownship, pressureAltitude, onMessage);
+        break;
+    case Protocol::XGPS: {
+        auto altitude = ownship.coordinate().altitude();
+        encodeXGPS(ownship, qIsFinite(altitude) ? Units::Distance::fromM(altitude) : pressureAltitude, onMessage);
+        break;
+    }
+    }
+}
+
+
+void Traffic::SyntheticTraffic::encodeFLARM(const QGeoPositionInfo& ownship, const std::function<void(QByteArrayView)>& onSentence)
+{
+    std::array<char, 128> buffer {};
+    auto size = m_north.size();
+
+    // Targets
+    int alarmTarget = -1;
+    int maxAlarmLevel = 0;
+    double minDistance = qInf();
+    for(qsizetype i=0; i<size; i++) {
+        auto hDist = std::hypot(m_north[i], m_east[i]);
+        auto level = alarmLevel(hDist, m_up[i]);
+        if ((level > maxAlarmLevel) || ((level > 0) && (level == maxAlarmLevel) && (hDist < minDistance))) {
+            alarmTarget = static_cast<int>(i);
+            maxAlarmLevel = level;
+            minDistance = hDist;
+        }
+
+        auto length = std::snprintf(buffer.data(), buffer.size(), "$PFLAA,%d,%d,%d,%d,2,%06X,%d,,%d,%.1f,1",
+                                    level,
+                                    qRound(m_north[i]),
+                                    qRound(m_east[i]),
+                                    qRound(m_up[i]),
+                                    static_cast<unsigned int>(0x100000+i) & 0xFFFFFFU,
+                                    qRound(m_track[i]) % 360,
+                                    qRound(m_groundSpeed[i]),
+                                    m_climbRate[i]);
+        length = finishSyntheticSentence(buffer.data(), length, static_cast<int>(buffer.size()));
+        onSentence(QByteArrayView(buffer.data(), length));
+    }
+
+    // Heartbeat and most important alarm
+    int length = 0;
+    if (alarmTarget < 0) {
+        length = std::snprintf(buffer.data(), buffer.size(), "$PFLAU,%d,1,2,1,0,,0,,", static_cast<int>(qMin(size, qsizetype(99))));
+    } else {
+        auto ownshipTrack = ownship.hasAttribute(QGeoPositionInfo::Direction) ? ownship.attribute(QGeoPositionInfo::Direction) : 0.0;
+        auto bearing = qRadiansToDegrees(std::atan2(m_east[alarmTarget], m_north[alarmTarget])) - ownshipTrack;
+        bearing = std::fmod(bearing+540.0, 360.0) - 180.0;
+        length = std::snprintf(buffer.data(), buffer.size(), "$PFLAU,%d,1,2,1,%d,%d,2,%d,%d",
+                               static_cast<int>(qMin(size, qsizetype(99))),
+                               maxAlarmLevel,
+                               qRound(bearing),
+                               qRound(m_up[alarmTarget]),
+                               qRound(minDistance));
+    }
+    length = finishSyntheticSentence(buffer.data(), length, static_cast<int>(buffer.size()));
+    onSentence(QByteArrayView(buffer.data(), length));
+}
+
+
+void Traffic::SyntheticTraffic::encodeGDL90(const QGeoPositionInfo& ownship, Units::Distance pressureAltitude, const std::function<void(QByteArrayView)>& onDatagram)
+{
+    // Messages are packed into datagrams of typical UDP payload size
+    std::array<quint8, 1472> datagram {};
+    qsizetype datagramSize = 0;
+    std::array<quint8, Traffic::GDL90::TargetReport::encodedSize> payload {};
+
+    auto append = [&](quint8 messageID, qsizetype payloadSize) {
+        auto length = Traffic::GDL90::writeFrame(messageID, payload.data(), payloadSize, datagram.data()+datagramSize, static_cast<qsizetype>(datagram.size())-datagramSize);
+        if (length == 0) {
+            onDatagram(QByteArrayView(datagram.data(), datagramSize));
+            datagramSize = 0;
+            length = Traffic::GDL90::writeFrame(messageID, payload.data(), payloadSize, datagram.data(), static_cast<qsizetype>(datagram.size()));
+        }
+        datagramSize += length;
+    };
+
+    // Heartbeat: GPS position valid, UAT initialized
+    Traffic::GDL90::Heartbeat heartbeat;
+    heartbeat.status1 = 0x81;
+    heartbeat.encode(payload.data());
+    append(0, Traffic::GDL90::Heartbeat::encodedSize);
+
+    const Positioning::LocalTangentPlane plane(ownship.coordinate());
+    if (!plane.isValid()) {
+        onDatagram(QByteArrayView(datagram.data(), datagramSize));
+        return;
+    }
+
+    // Ownship report, with pressure altitude
+    Traffic::GDL90::TargetReport report;
+    report.address = 0xF00000;
+    report.latitude = plane.origin().latitude();
+    report.longitude = plane.origin().longitude();
+    report.hasPressureAltitude = pressureAltitude.isFinite();
+    report.pressureAltitudeFT = pressureAltitude.toFeet();
+    report.miscIndicators = 0x08;
+    report.NACp = 10;
+    report.hasHorizontalVelocity = ownship.hasAttribute(QGeoPositionInfo::GroundSpeed);
+    report.horizontalVelocityKN = Units::Speed::fromMPS(ownship.attribute(QGeoPositionInfo::GroundSpeed)).toKN();
+    report.hasVerticalVelocity = false;
+    report.hasTrack = ownship.hasAttribute(QGeoPositionInfo::Direction);
+    report.trackDEG = ownship.attribute(QGeoPositionInfo::Direction);
+    report.encode(payload.data());
+    append(10, Traffic::GDL90::TargetReport::encodedSize);
+
+    // Targets
+    computeCoordinates(plane);
+    report.hasHorizontalVelocity = true;
+    report.hasVerticalVelocity = true;
+    report.hasTrack = true;
+    report.NACp = 9;
+    report.emitterCategory = 9;
+    std::array<char, 9> callSign {};
+    auto size = m_north.size();
+    for(qsizetype i=0; i<size; i++) {
+        auto level = alarmLevel(std::hypot(m_north[i], m_east[i]), m_up[i]);
+        report.alertStatus = (level > 0) ? 1 : 0;
+        report.address = static_cast<quint32>(0x100000+i) & 0xFFFFFFU;
+        report.latitude = m_latitude[i];
+        report.longitude = m_longitude[i];
+        report.pressureAltitudeFT = (pressureAltitude + Units::Distance::fromM(m_up[i])).toFeet();
+        report.horizontalVelocityKN = Units::Speed::fromMPS(m_groundSpeed[i]).toKN();
+        report.verticalVelocityFPM = Units::Speed::fromMPS(m_climbRate[i]).toFPM();
+        report.trackDEG = m_track[i];
+        std::snprintf(callSign.data(), callSign.size(), "SIM%05d", static_cast<int>(i % 100000));
+        memcpy(report.callSign.data(), callSign.data(), report.callSign.size());
+        report.encode(payload.data());
+        append(20, Traffic::GDL90::TargetReport::encodedSize);
+    }
+    onDatagram(QByteArrayView(datagram.data(), datagramSize));
+}
+
+
+void Traffic::SyntheticTraffic::encodeXGPS(const QGeoPositionInfo& ownship, Units::Distance altitude, const std::function<void(QByteArrayView)>& onDatagram)
+{
+    const Positioning::LocalTangentPlane plane(ownship.coordinate());
+    if (!plane.isValid()) {
+        return;
+    }
+    std::array<char, 160> buffer {};
+
+    // Ownship, serves also as heartbeat
+    auto ownshipAltitude = altitude.toM();
+    auto length = std::snprintf(buffer.data(), buffer.size(), "XGPSSynthetic,%.6f,%.6f,%.1f,%.1f,%.1f",
+                                plane.origin().longitude(),
+                                plane.origin().latitude(),
+                                ownshipAltitude,
+                                ownship.hasAttribute(QGeoPositionInfo::Direction) ? ownship.attribute(QGeoPositionInfo::Direction) : 0.0,
+                                ownship.hasAttribute(QGeoPositionInfo::GroundSpeed) ? ownship.attribute(QGeoPositionInfo::GroundSpeed) : 0.0);
+    if ((length > 0) && (length < static_cast<int>(buffer.size()))) {
+        onDatagram(QByteArrayView(buffer.data(), length));
+    }
+
+    // Targets, one datagram each
+    computeCoordinates(plane);
+    auto size = m_north.size();
+    for(qsizetype i=0; i<size; i++) {
+        length = std::snprintf(buffer.data(), buffer.size(), "XTRAFFICSynthetic,%d,%.6f,%.6f,%d,%d,1,%.1f,%d,SIM%05d",
+                               static_cast<int>(0x100000+i),
+                               m_latitude[i],
+                               m_longitude[i],
+                               qRound(Units::Distance::fromM(ownshipAltitude+m_up[i]).toFeet()),
+                               qRound(Units::Speed::fromMPS(m_climbRate[i]).toFPM()),
+                               m_track[i],
+                               qRound(Units::Speed::fromMPS(m_groundSpeed[i]).toKN()),
+                               static_cast<int>(i % 100000));
+        if ((length > 0) && (length < static_cast<int>(buffer.size()))) {
+            onDatagram(QByteArrayView(buffer.data(), length));
+        }
+    }
+}
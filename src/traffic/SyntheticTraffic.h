@@ -0,0 +1,172 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QByteArrayView>
+#include <QGeoPositionInfo>
+#include <QVector>
+#include <chrono>
+#include <functional>
+
+#include "positioning/LocalTangentPlane.h"
+#include "units/Angle.h"
+#include "units/Distance.h"
+#include "units/Speed.h"
+
+
+namespace Traffic {
+
+/*! \brief Moving synthetic traffic, encoded as a traffic receiver would
+ *
+ *  This class moves a large number of synthetic targets around ownship and
+ *  encodes them as FLARM NMEA sentences, GDL90 messages or XGPS strings.  It
+ *  generates the synthetic load of TrafficDataSource_Simulate and the
+ *  synthetic corpora of the traffic benchmark, so that both exercise the
+ *  parsers with the same data.
+ *
+ *  Kinematic state is kept in parallel arrays, in SI units, so that moving
+ *  thousands of targets is cheap.  Encoding does not allocate memory once
+ *  the arrays have reached their size.
+ */
+
+class SyntheticTraffic {
+
+public:
+    /*! \brief Data format */
+    enum class Protocol {
+        FLARM, /*!< FLARM NMEA sentences PFLAU and PFLAA */
+        GDL90, /*!< GDL90 heartbeat, ownship and traffic reports */
+        XGPS   /*!< XGPS ownship and XTRAFFIC strings */
+    };
+
+    /*! \brief Trajectory of a synthetic target
+     *
+     *  Positions are relative to ownship.
+     */
+    struct Target {
+        /*! \brief Offset towards true north */
+        Units::Distance north;
+
+        /*! \brief Offset towards east */
+        Units::Distance east;
+
+        /*! \brief Vertical offset, positive if the target is above ownship */
+        Units::Distance up;
+
+        /*! \brief Ground speed */
+        Units::Speed groundSpeed;
+
+        /*! \brief True track */
+        Units::Angle track;
+
+        /*! \brief Change of track per second, positive for right turns */
+        Units::Angle turnRate;
+
+        /*! \brief Climb rate */
+        Units::Speed climbRate;
+    };
+
+    /*! \brief Add a target
+     *
+     *  @param target Initial position and motion of the target
+     */
+    void addTarget(const Traffic::SyntheticTraffic::Target& target);
+
+    /*! \brief Add targets at random
+     *
+     *  This method adds targets with random positions, altitudes and motion
+     *  around ownship. About one third of the targets circle, as gliders do in
+     *  thermals. Targets that leave the area turn around.
+     *
+     *  @param count Number of targets to add
+     *
+     *  @param seed Seed for the random number generator. The same seed yields
+     *  the same targets.
+     *
+     *  @param radius Radius of the area around ownship
+     */
+    void addRandomTargets(int count, quint32 seed = 1, Units::Distance radius = Units::Distance::fromNM(10));
+
+    /*! \brief Remove all targets */
+    void clear();
+
+    /*! \brief Check if there are targets
+     *
+     *  @returns True if there are no targets
+     */
+    [[nodiscard]] auto isEmpty() const -> bool
+    {
+        return m_north.isEmpty();
+    }
+
+    /*! \brief Move all targets
+     *
+     *  @param time Time span
+     */
+    void advance(std::chrono::milliseconds time);
+
+    /*! \brief Encode ownship and all targets
+     *
+     *  @param protocol Data format
+     *
+     *  @param ownship Position, ground speed and true track of ownship
+     *
+     *  @param pressureAltitude Pressure altitude of ownship. GDL90 reports
+     *  pressure altitudes for ownship and targets. XGPS reports geometric
+     *  altitudes and uses this value only if the ownship coordinate has no
+     *  altitude.
+     *
+     *  @param onMessage Called for every FLARM sentence, GDL90 datagram or
+     *  XGPS string. The data is valid only for the duration of the call.
+     */
+    void encode(Protocol protocol, const QGeoPositionInfo& ownship, Units::Distance pressureAltitude, const std::function<void(QByteArrayView)>& onMessage);
+
+private:
+    // Encoders for the individual data formats
+    void encodeFLARM(const QGeoPositionInfo& ownship, const std::function<void(QByteArrayView)>& onSentence);
+    void encodeGDL90(const QGeoPositionInfo& ownship, Units::Distance pressureAltitude, const std::function<void(QByteArrayView)>& onDatagram);
+    void encodeXGPS(const QGeoPositionInfo& ownship, Units::Distance altitude, const std::function<void(QByteArrayView)>& onDatagram);
+
+    // Computes m_latitude and m_longitude in the given tangent plane
+    void computeCoordinates(const Positioning::LocalTangentPlane& plane);
+
+    // Alarm level for a target, estimated from its distance
+    [[nodiscard]] static auto alarmLevel(double horizontalDistance, double verticalDistance) -> int;
+
+    // Radius of the area that targets stay in, or NaN if targets move freely
+    Units::Distance m_radius;
+
+    // Kinematic state. Distances in meters, speeds in meters per second,
+    // angles in degrees.
+    QVector<double> m_north;
+    QVector<double> m_east;
+    QVector<double> m_up;
+    QVector<double> m_groundSpeed;
+    QVector<double> m_track;
+    QVector<double> m_turnRate;
+    QVector<double> m_climbRate;
+
+    // Scratch arrays for the conversion to geographic coordinates
+    QVector<double> m_latitude;
+    QVector<double> m_longitude;
+};
+
+} // namespace Traffic
@@ -0,0 +1,184 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QThread>
+#include <QThreadStorage>
+
+#include "traffic/TimingWheel.h"
+
+
+// One timing wheel per thread. QThreadStorage deletes the wheel when the
+// thread exits.
+QThreadStorage<Traffic::TimingWheel*> wheels;
+
+
+// Member functions of TimingWheel::Timer
+
+void Traffic::TimingWheel::Timer::start()
+{
+    // Timers must always be used from the same thread. A running timer must
+    // therefore belong to the wheel of the current thread.
+    Q_ASSERT( (m_wheel == nullptr) || (m_wheel->thread() == QThread::currentThread()) );
+
+    stop();
+    TimingWheel::forCurrentThread()->insert(this, m_interval);
+}
+
+
+void Traffic::TimingWheel::Timer::stop()
+{
+    if (m_wheel != nullptr) {
+        m_wheel->remove(this);
+    }
+}
+
+
+// Member functions of TimingWheel
+
+Traffic::TimingWheel::TimingWheel(QObject* parent)
+    : QObject(parent)
+{
+    m_tickTimer.setInterval(tickInterval);
+    connect(&m_tickTimer, &QTimer::timeout, this, &Traffic::TimingWheel::onTick);
+}
+
+
+Traffic::TimingWheel::~TimingWheel()
+{
+    auto deactivateAll = [](Link& list) {
+        while (!list.isEmpty()) {
+            auto* timer = static_cast<Timer*>(list.next);
+            timer->unlink();
+            timer->m_wheel = nullptr;
+        }
+    };
+    for(auto& level : m_slots) {
+        for(auto& slot : level) {
+            deactivateAll(slot);
+        }
+    }
+    deactivateAll(m_overflow);
+}
+
+
+void Traffic::TimingWheel::advance()
+{
+    m_now++;
+
+    // Timers of higher levels whose slot becomes current move down. Higher
+    // levels go first, because their timers might land in a slot of a lower
+    // level that also becomes current now.
+    if ((m_now & ((quint64(1) << (slotBits*numLevels))-1)) == 0) {
+        cascade(m_overflow);
+    }
+    for(int level = numLevels-1; level >= 1; level--) {
+        if ((m_now & ((quint64(1) << (slotBits*level))-1)) == 0) {
+            cascade(m_slots[level][(m_now >> (slotBits*level)) & (numSlots-1)]);
+        }
+    }
+
+    // Expire all timers in the current slot. The list is moved aside first,
+    // so that callbacks may freely start, stop or delete timers.
+    Link expired;
+    m_slots[0][m_now & (numSlots-1)].moveAllTo(expired);
+    while (!expired.isEmpty()) {
+        auto* timer = static_cast<Timer*>(expired.next);
+        timer->unlink();
+        timer->m_wheel = nullptr;
+        m_size--;
+        if (timer->m_callback) {
+            timer->m_callback();
+        }
+    }
+}
+
+
+void Traffic::TimingWheel::cascade(Link& list)
+{
+    Link pending;
+    list.moveAllTo(pending);
+    while (!pending.isEmpty()) {
+        auto* timer = static_cast<Timer*>(pending.next);
+        timer->unlink();
+        place(timer);
+    }
+}
+
+
+auto Traffic::TimingWheel::forCurrentThread() -> Traffic::TimingWheel*
+{
+    if (!wheels.hasLocalData()) {
+        wheels.setLocalData(new TimingWheel());
+    }
+    return wheels.localData();
+}
+
+
+void Traffic::TimingWheel::insert(Timer* timer, std::chrono::milliseconds interval)
+{
+    // Start the clock if the wheel has been idle
+    if (m_size == 0) {
+        m_clockBase = m_now;
+        m_clock.start();
+        m_tickTimer.start();
+    }
+
+    // Round up to full ticks, so that timers never expire early
+    auto ticks = (interval.count() + tickInterval.count() - 1)/tickInterval.count();
+    timer->m_deadline = m_now + static_cast<quint64>(qMax(ticks, qint64(1)));
+    timer->m_wheel = this;
+    m_size++;
+    place(timer);
+}
+
+
+void Traffic::TimingWheel::onTick()
+{
+    auto target = m_clockBase + static_cast<quint64>(m_clock.elapsed()/tickInterval.count());
+    while ((m_now < target) && (m_size > 0)) {
+        advance();
+    }
+    if (m_size == 0) {
+        m_tickTimer.stop();
+    }
+}
+
+
+void Traffic::TimingWheel::place(Timer* timer)
+{
+    // Find the lowest level whose current block contains the deadline
+    for(int level = 0; level < numLevels; level++) {
+        auto blockShift = slotBits*(level+1);
+        if ((timer->m_deadline >> blockShift) == (m_now >> blockShift)) {
+            auto slot = (timer->m_deadline >> (slotBits*level)) & (numSlots-1);
+            timer->linkBefore(&m_slots[level][slot]);
+            return;
+        }
+    }
+    timer->linkBefore(&m_overflow);
+}
+
+
+void Traffic::TimingWheel::remove(Timer* timer)
+{
+    timer->unlink();
+    timer->m_wheel = nullptr;
+    m_size--;
+}
@@ -0,0 +1,254 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <array>
+#include <chrono>
+#include <functional>
+
+
+namespace Traffic {
+
+/*! \brief Hierarchical timing wheel for coarse timeouts
+ *
+ *  Traffic data comes with many timeouts: every traffic factor has a
+ *  lifetime, every data source watches heartbeat and altitude messages.  These
+ *  timeouts are restarted with every message received, but they rarely
+ *  expire, and a resolution of a tenth of a second is more than sufficient.
+ *  Implementing them with QTimer means that every restart goes through the
+ *  event dispatcher.
+ *
+ *  This class implements the timeouts in a hierarchical timing wheel instead.
+ *  The wheel has three levels of 64 slots each.  A slot of the lowest level
+ *  spans one tick of tickInterval; a slot of the next level spans 64 ticks,
+ *  and so on.  Every timer sits in a doubly-linked list attached to a slot, so
+ *  that starting, restarting and stopping a timer take constant time and do
+ *  not involve the event loop.  At every tick, all timers in the current slot
+ *  expire in one batch, and timers of higher levels cascade down when their
+ *  slot becomes current.  The wheel uses one QTimer, which runs only while
+ *  timers are active.
+ *
+ *  There is one wheel per thread, which is created on first use and deleted
+ *  when the thread exits.  Timers are represented by instances of the class
+ *  TimingWheel::Timer, which must always be used from the same thread.
+ */
+
+class TimingWheel : public QObject {
+    Q_OBJECT
+
+    // Node of an intrusive, circular, doubly-linked list. A node that is
+    // not linked points to itself. The slots of the wheel are sentinel
+    // nodes.
+    struct Link {
+        Link() = default;
+        Link(const Link&) = delete;
+        Link(Link&&) = delete;
+        auto operator=(const Link&) -> Link& = delete;
+        auto operator=(Link&&) -> Link& = delete;
+        ~Link() = default;
+
+        // Checks if the list that starts at this sentinel is empty
+        [[nodiscard]] auto isEmpty() const -> bool { return next == this; }
+
+        // Inserts this node before the node "position"
+        void linkBefore(Link* position)
+        {
+            prev = position->prev;
+            next = position;
+            prev->next = this;
+            next->prev = this;
+        }
+
+        // Removes this node from the list it is in
+        void unlink()
+        {
+            prev->next = next;
+            next->prev = prev;
+            prev = this;
+            next = this;
+        }
+
+        // Moves all nodes of the list that starts at this sentinel to the
+        // (empty) list that starts at the sentinel "target"
+        void moveAllTo(Link& target)
+        {
+            if (isEmpty()) {
+                return;
+            }
+            target.next = next;
+            target.prev = prev;
+            target.next->prev = &target;
+            target.prev->next = &target;
+            prev = this;
+            next = this;
+        }
+
+        Link* prev {this};
+        Link* next {this};
+    };
+
+public:
+    /*! \brief Resolution of the wheel */
+    static constexpr std::chrono::milliseconds tickInterval {100};
+
+    /*! \brief Number of levels */
+    static constexpr int numLevels = 3;
+
+    /*! \brief Binary logarithm of the number of slots per level */
+    static constexpr int slotBits = 6;
+
+    /*! \brief Number of slots per level */
+    static constexpr int numSlots = 1 << slotBits;
+
+    /*! \brief Single-shot timer in a timing wheel
+     *
+     *  The interface of this class resembles that of a single-shot QTimer.
+     *  The timer expires no earlier than interval() after the last call to
+     *  start(), and typically less than one tickInterval later.  It is
+     *  legitimate to start, stop or delete any timer from within a timeout
+     *  callback.
+     */
+    class Timer : private Link {
+        friend class TimingWheel;
+
+    public:
+        /*! \brief Constructs an inactive timer */
+        Timer() = default;
+
+        /*! \brief Destructor, stops the timer */
+        ~Timer() { stop(); }
+
+        Timer(const Timer&) = delete;
+        Timer(Timer&&) = delete;
+        auto operator=(const Timer&) -> Timer& = delete;
+        auto operator=(Timer&&) -> Timer& = delete;
+
+        /*! \brief Set function that is called when the timer expires
+         *
+         *  @param callback Function to be called
+         */
+        void callOnTimeout(std::function<void()> callback) { m_callback = std::move(callback); }
+
+        /*! \brief Timeout interval
+         *
+         *  @returns Interval
+         */
+        [[nodiscard]] auto interval() const -> std::chrono::milliseconds { return m_interval; }
+
+        /*! \brief Set timeout interval
+         *
+         *  The new interval takes effect on the next call to start().
+         *
+         *  @param newInterval Interval
+         */
+        void setInterval(std::chrono::milliseconds newInterval) { m_interval = newInterval; }
+
+        /*! \brief Check if the timer is running
+         *
+         *  @returns True if the timer has been started and has neither expired nor been stopped
+         */
+        [[nodiscard]] auto isActive() const -> bool { return m_wheel != nullptr; }
+
+        /*! \brief Start or restart the timer */
+        void start();
+
+        /*! \brief Stop the timer
+         *
+         *  If the timer is not active, nothing happens.
+         */
+        void stop();
+
+    private:
+        // Function called on expiry
+        std::function<void()> m_callback;
+
+        // Interval set by setInterval()
+        std::chrono::milliseconds m_interval {0};
+
+        // Tick at which the timer expires
+        quint64 m_deadline {0};
+
+        // Wheel that the timer is linked into, or nullptr if inactive
+        TimingWheel* m_wheel {nullptr};
+    };
+
+    /*! \brief Timing wheel of the current thread
+     *
+     *  @returns Pointer to the wheel of the current thread. The wheel is
+     *  created on first use and owned by the thread.
+     */
+    static auto forCurrentThread() -> TimingWheel*;
+
+    /*! \brief Number of active timers
+     *
+     *  @returns Number of timers that are linked into the wheel
+     */
+    [[nodiscard]] auto size() const -> qsizetype { return m_size; }
+
+    // Destructor, deactivates all timers that are still linked into the wheel
+    ~TimingWheel() override;
+
+private slots:
+    // Advances the wheel to the current time and expires timers
+    void onTick();
+
+private:
+    Q_DISABLE_COPY_MOVE(TimingWheel)
+
+    // Constructor, private. Use forCurrentThread().
+    explicit TimingWheel(QObject* parent = nullptr);
+
+    // Advances the wheel by one tick
+    void advance();
+
+    // Moves all timers in the list to the slots that match their deadlines
+    void cascade(Link& list);
+
+    // Links an active timer into the slot that matches its deadline
+    void place(Timer* timer);
+
+    // Adds a timer to the wheel
+    void insert(Timer* timer, std::chrono::milliseconds interval);
+
+    // Removes a timer from the wheel
+    void remove(Timer* timer);
+
+    // Slots of the wheel, and list of timers whose deadline is beyond the
+    // range of the highest level
+    std::array<std::array<Link, numSlots>, numLevels> m_slots;
+    Link m_overflow;
+
+    // Current tick, and number of active timers
+    quint64 m_now {0};
+    qsizetype m_size {0};
+
+    // Drives the wheel while timers are active. The clock measures time since
+    // the tick m_clockBase, so that ticks lost to a busy event loop are caught
+    // up with.
+    QTimer m_tickTimer;
+    QElapsedTimer m_clock;
+    quint64 m_clockBase {0};
+};
+
+} // namespace Traffic
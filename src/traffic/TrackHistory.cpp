@@ -0,0 +1,299 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtMath>
+
+#include "positioning/LocalTangentPlane.h"
+#include "traffic/TrackHistory.h"
+
+
+// Member functions
+
+Traffic::TrackHistory::TrackHistory()
+    : m_samples(maxTargets*samplesPerTarget)
+{
+    m_slotOfID.reserve(maxTargets);
+}
+
+
+auto Traffic::TrackHistory::allocate(const Traffic::TrafficTargetTable::Entry& entry) -> qsizetype
+{
+    // Use a free slot, if there is one. Otherwise, find the least relevant
+    // target.
+    qsizetype leastRelevant = -1;
+    for(qsizetype i=0; i<maxTargets; i++) {
+        const auto& slot = m_slots[i];
+        if (slot.ID.isEmpty()) {
+            leastRelevant = i;
+            break;
+        }
+        if (leastRelevant < 0) {
+            leastRelevant = i;
+            continue;
+        }
+        const auto& least = m_slots[leastRelevant];
+        if ((slot.alarmLevel < least.alarmLevel)
+            || ((slot.alarmLevel == least.alarmLevel) && !(slot.predictedSeparation <= least.predictedSeparation))) {
+            leastRelevant = i;
+        }
+    }
+
+    // Evict the least relevant target, if the new one is more relevant
+    auto& slot = m_slots[leastRelevant];
+    if (!slot.ID.isEmpty()) {
+        auto alarmLevel = entry.report.alarmLevel;
+        auto separation = entry.report.predictedSeparation();
+        if ((alarmLevel < slot.alarmLevel)
+            || ((alarmLevel == slot.alarmLevel) && !(separation < slot.predictedSeparation))) {
+            return -1;
+        }
+        release(leastRelevant);
+    }
+
+    slot.ID = entry.report.ID;
+    m_slotOfID.insert(slot.ID, leastRelevant);
+    return leastRelevant;
+}
+
+
+void Traffic::TrackHistory::append(qsizetype slot, const Sample& sample)
+{
+    auto& s = m_slots[slot];
+    if (s.size < samplesPerTarget) {
+        m_samples[slot*samplesPerTarget + (s.first+s.size)%samplesPerTarget] = sample;
+        s.size++;
+    } else {
+        m_samples[slot*samplesPerTarget + s.first] = sample;
+        s.first = (s.first+1)%samplesPerTarget;
+    }
+
+    s.climbRate = estimateClimbRate(slot);
+    s.turnRate = estimateTurnRate(slot);
+}
+
+
+void Traffic::TrackHistory::clear()
+{
+    for(qsizetype i=0; i<maxTargets; i++) {
+        release(i);
+    }
+}
+
+
+auto Traffic::TrackHistory::estimateClimbRate(qsizetype slot) const -> Units::Speed
+{
+    const auto& s = m_slots[slot];
+    if (s.size < 3) {
+        return {};
+    }
+
+    // Linear regression of altitude over time, with times in seconds
+    // relative to the most recent sample
+    auto newest = sample(slot, s.size-1).timestamp;
+    auto windowMS = std::chrono::duration_cast<std::chrono::milliseconds>(estimationWindow).count();
+    double n = 0.0;
+    double sumT = 0.0;
+    double sumA = 0.0;
+    double sumTT = 0.0;
+    double sumTA = 0.0;
+    double minT = 0.0;
+    for(auto i=s.size-1; i>=0; i--) {
+        const auto& smp = sample(slot, i);
+        if (newest-smp.timestamp > windowMS) {
+            break;
+        }
+        if (!qIsFinite(smp.altitude)) {
+            continue;
+        }
+        auto t = static_cast<double>(smp.timestamp-newest)/1000.0;
+        n += 1.0;
+        sumT += t;
+        sumA += smp.altitude;
+        sumTT += t*t;
+        sumTA += t*smp.altitude;
+        minT = qMin(minT, t);
+    }
+    if ((n < 3.0) || (minT > -2.0)) {
+        return {};
+    }
+    auto denominator = n*sumTT - sumT*sumT;
+    if (denominator <= 0.0) {
+        return {};
+    }
+    return Units::Speed::fromMPS((n*sumTA - sumT*sumA)/denominator);
+}
+
+
+auto Traffic::TrackHistory::estimateTurnRate(qsizetype slot) const -> Units::Angle
+{
+    // Segments shorter than this are dominated by position noise. They are
+    // merged with the following segment.
+    constexpr double minSegmentM = 10.0;
+
+    const auto& s = m_slots[slot];
+    if (s.size < 4) {
+        return {};
+    }
+
+    // Find the oldest sample within estimationWindow
+    auto newest = sample(slot, s.size-1).timestamp;
+    auto windowMS = std::chrono::duration_cast<std::chrono::milliseconds>(estimationWindow).count();
+    auto begin = s.size-1;
+    while ((begin > 0) && (newest-sample(slot, begin-1).timestamp <= windowMS)) {
+        begin--;
+    }
+
+    // Linear regression of the unwrapped track of the segments over the time
+    // at the middle of the segments. Segments are measured in a tangent plane
+    // at the newest sample.
+    const auto& newestSample = sample(slot, s.size-1);
+    Positioning::LocalTangentPlane tangentPlane(QGeoCoordinate(newestSample.latitude, newestSample.longitude));
+    double n = 0.0;
+    double sumT = 0.0;
+    double sumA = 0.0;
+    double sumTT = 0.0;
+    double sumTA = 0.0;
+    double minT = 0.0;
+    double previousTrack = qQNaN();
+    const auto* anchor = &sample(slot, begin);
+    auto anchorOffset = tangentPlane.toOffset(QGeoCoordinate(anchor->latitude, anchor->longitude));
+    for(auto i=begin+1; i<s.size; i++) {
+        const auto& smp = sample(slot, i);
+        auto offset = tangentPlane.toOffset(QGeoCoordinate(smp.latitude, smp.longitude));
+        auto north = offset.north - anchorOffset.north;
+        auto east = offset.east - anchorOffset.east;
+        if (north*north + east*east < minSegmentM*minSegmentM) {
+            continue;
+        }
+
+        auto track = qAtan2(east, north);
+        if (qIsFinite(previousTrack)) {
+            track = previousTrack + std::remainder(track-previousTrack, qDegreesToRadians(360.0));
+        }
+        previousTrack = track;
+
+        auto t = 0.5*static_cast<double>(anchor->timestamp+smp.timestamp-2*newest)/1000.0;
+        n += 1.0;
+        sumT += t;
+        sumA += track;
+        sumTT += t*t;
+        sumTA += t*track;
+        minT = qMin(minT, t);
+        anchor = &smp;
+        anchorOffset = offset;
+    }
+    if ((n < 3.0) || (minT > -2.0)) {
+        return {};
+    }
+    auto denominator = n*sumTT - sumT*sumT;
+    if (denominator <= 0.0) {
+        return {};
+    }
+    return Units::Angle::fromRAD((n*sumTA - sumT*sumA)/denominator);
+}
+
+
+auto Traffic::TrackHistory::polyline(const QString& ID) const -> QVariantList
+{
+    QVariantList result;
+    auto slot = m_slotOfID.value(ID, -1);
+    if (slot < 0) {
+        return result;
+    }
+
+    const auto& s = m_slots[slot];
+    if (s.size == 0) {
+        return result;
+    }
+    const auto& newest = sample(slot, s.size-1);
+    Positioning::LocalTangentPlane tangentPlane(QGeoCoordinate(newest.latitude, newest.longitude));
+    Positioning::LocalTangentPlane::Offset last;
+    for(qsizetype i=0; i<s.size; i++) {
+        const auto& smp = sample(slot, i);
+        QGeoCoordinate coordinate(smp.latitude, smp.longitude);
+        auto offset = tangentPlane.toOffset(coordinate);
+        if (!result.isEmpty() && (i < s.size-1)) {
+            auto north = offset.north - last.north;
+            auto east = offset.east - last.east;
+            if (north*north + east*east < minPolylineSpacingM*minPolylineSpacingM) {
+                continue;
+            }
+        }
+        result.append(QVariant::fromValue(coordinate));
+        last = offset;
+    }
+    return result;
+}
+
+
+void Traffic::TrackHistory::record(std::span<Traffic::TrafficTargetTable::Entry> entries)
+{
+    for(auto& slot : m_slots) {
+        slot.seen = false;
+    }
+
+    for(auto& entry : entries) {
+        auto& report = entry.report;
+        auto index = m_slotOfID.value(report.ID, -1);
+        if (index < 0) {
+            index = allocate(entry);
+        }
+        if (index < 0) {
+            report.climbRate = {};
+            report.turnRate = {};
+            continue;
+        }
+
+        auto& slot = m_slots[index];
+        slot.seen = true;
+        slot.alarmLevel = report.alarmLevel;
+        slot.predictedSeparation = report.predictedSeparation();
+
+        auto coordinate = report.positionInfo.coordinate();
+        auto dateTime = report.positionInfo.timestamp();
+        if (coordinate.isValid() && dateTime.isValid()) {
+            auto timestamp = dateTime.toMSecsSinceEpoch();
+            if ((slot.size == 0) || (timestamp > sample(index, slot.size-1).timestamp)) {
+                append(index, {timestamp, coordinate.latitude(), coordinate.longitude(), coordinate.altitude()});
+            }
+        }
+
+        report.climbRate = slot.climbRate;
+        report.turnRate = slot.turnRate;
+    }
+
+    // Forget targets that have left the table
+    for(qsizetype i=0; i<maxTargets; i++) {
+        if (!m_slots[i].seen) {
+            release(i);
+        }
+    }
+}
+
+
+void Traffic::TrackHistory::release(qsizetype slot)
+{
+    auto& s = m_slots[slot];
+    if (s.ID.isEmpty()) {
+        return;
+    }
+    m_slotOfID.remove(s.ID);
+    s = Slot();
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QVariantList>
+#include <QVector>
+
+#include <array>
+#include <chrono>
+#include <span>
+
+#include "traffic/TrafficTargetTable.h"
+#include "units/Angle.h"
+#include "units/Speed.h"
+
+using namespace std::chrono_literals;
+
+
+namespace Traffic {
+
+/*! \brief Recent positions of traffic targets
+ *
+ *  This class keeps a ring buffer of the most recent positions for each of up
+ *  to maxTargets targets.  All buffers are allocated in the constructor, so
+ *  that recording positions does not allocate memory.  If more targets are
+ *  tracked than there are buffers, the least relevant targets have no
+ *  history.
+ *
+ *  The history is used to estimate climb and turn rates by linear regression
+ *  over the last estimationWindow.  This is less sensitive to noise than
+ *  estimates derived from single reports.
+ */
+
+class TrackHistory {
+
+public:
+    /*! \brief Maximal number of targets with history */
+    static constexpr qsizetype maxTargets = 64;
+
+    /*! \brief Number of positions kept per target */
+    static constexpr qsizetype samplesPerTarget = 60;
+
+    /*! \brief Time span used to estimate climb and turn rates */
+    static constexpr auto estimationWindow = 10s;
+
+    /*! \brief Minimal spacing of points in polyline() */
+    static constexpr double minPolylineSpacingM = 20.0;
+
+    /*! \brief Constructor */
+    TrackHistory();
+
+    /*! \brief Record positions and estimate rates
+     *
+     *  This method adds the positions of the entries to the history, unless
+     *  they are not newer than the last recorded position of the target.  It
+     *  then sets the fields climbRate and turnRate of the reports, using the
+     *  history.  Buffers of targets that are not among the entries are
+     *  released.
+     *
+     *  @param entries Entries of a TrafficTargetTable, typically passed in
+     *  from TrafficTargetTable::updateAll()
+     */
+    void record(std::span<Traffic::TrafficTargetTable::Entry> entries);
+
+    /*! \brief Remove all history */
+    void clear();
+
+    /*! \brief Recent track of a target
+     *
+     *  To keep the result small, points that are closer than
+     *  minPolylineSpacingM to the previous point are omitted.  The most recent
+     *  position is always included.
+     *
+     *  @param ID Target ID
+     *
+     *  @returns List of QGeoCoordinate, oldest first, suitable for the
+     *  property "path" of a MapPolyline.  The list is empty if the ID has no
+     *  history.
+     */
+    [[nodiscard]] auto polyline(const QString& ID) const -> QVariantList;
+
+private:
+    // Recorded position
+    struct Sample {
+        // Time of the position, in milliseconds since the epoch
+        qint64 timestamp {0};
+
+        // Coordinate in degrees and altitude in meters, altitude might be NaN
+        double latitude {0.0};
+        double longitude {0.0};
+        double altitude {0.0};
+    };
+
+    // Ring buffer for one target. The samples are stored in m_samples,
+    // starting at index*samplesPerTarget.
+    struct Slot {
+        QString ID;
+
+        // Index of the oldest sample and number of samples
+        qsizetype first {0};
+        qsizetype size {0};
+
+        // Relevance of the target at the last call to record(), as in
+        // TrafficTargetTable::isMoreRelevant
+        int alarmLevel {0};
+        Units::Distance predictedSeparation;
+
+        // Estimates, updated whenever a sample is added
+        Units::Speed climbRate;
+        Units::Angle turnRate;
+
+        // True if the target was among the entries of the current call to
+        // record()
+        bool seen {false};
+    };
+
+    // Adds a sample to the slot and updates the estimates
+    void append(qsizetype slot, const Sample& sample);
+
+    // Finds a slot for a new target, possibly by evicting a less relevant
+    // target. Returns -1 if the target is less relevant than all targets
+    // with history.
+    auto allocate(const Traffic::TrafficTargetTable::Entry& entry) -> qsizetype;
+
+    // Estimates from the samples of a slot. Return NaN if there are not
+    // enough samples within estimationWindow.
+    [[nodiscard]] auto estimateClimbRate(qsizetype slot) const -> Units::Speed;
+    [[nodiscard]] auto estimateTurnRate(qsizetype slot) const -> Units::Angle;
+
+    // Releases a slot
+    void release(qsizetype slot);
+
+    // Sample number i of a slot, 0 is the oldest
+    [[nodiscard]] auto sample(qsizetype slot, qsizetype i) const -> const Sample&
+    {
+        const auto& s = m_slots[slot];
+        return m_samples[slot*samplesPerTarget + (s.first+i)%samplesPerTarget];
+    }
+
+    std::array<Slot, maxTargets> m_slots;
+    QVector<Sample> m_samples;
+
+    // Maps target ID to index in m_slots
+    QHash<QString, qsizetype> m_slotOfID;
+};
+
+} // namespace Traffic
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <array>
+#include <cstring>
+
+#include "traffic/TrafficCapture.h"
+
+
+// Member functions
+
+auto Traffic::TrafficCapture::Writer::open(const QString& fileName) -> bool
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    std::array<char, headerSize> header {};
+    memcpy(header.data(), magic.data(), magic.size());
+    qToLittleEndian<quint32>(version, header.data()+8);
+    qToLittleEndian<quint64>(QDateTime::currentMSecsSinceEpoch()*1000, header.data()+12);
+    if (m_file.write(header.data(), header.size()) != headerSize) {
+        m_file.close();
+        return false;
+    }
+
+    m_clock.start();
+    return true;
+}
+
+
+void Traffic::TrafficCapture::Writer::close()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+
+void Traffic::TrafficCapture::Writer::write(Traffic::TrafficCapture::Channel channel, QByteArrayView data)
+{
+    if (!m_file.isOpen() || (data.size() > maxPayloadSize)) {
+        return;
+    }
+
+    std::array<char, recordHeaderSize> header {};
+    qToLittleEndian<quint64>(m_clock.nsecsElapsed()/1000, header.data());
+    header[8] = static_cast<char>(channel);
+    qToLittleEndian<quint32>(data.size(), header.data()+9);
+    if ((m_file.write(header.data(), header.size()) != recordHeaderSize) ||
+        (m_file.write(data.data(), data.size()) != data.size())) {
+        m_file.close();
+    }
+}
+
+
+auto Traffic::TrafficCapture::Reader::isCaptureFile(const QString& fileName) -> bool
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    Reader reader;
+    return reader.setDevice(&file);
+}
+
+
+auto Traffic::TrafficCapture::Reader::setDevice(QIODevice* device) -> bool
+{
+    m_device = nullptr;
+    m_startTime = 0;
+    if (device == nullptr) {
+        return false;
+    }
+
+    std::array<char, headerSize> header {};
+    if ((device->read(header.data(), header.size()) != headerSize) ||
+        (memcmp(header.data(), magic.data(), magic.size()) != 0) ||
+        (qFromLittleEndian<quint32>(header.data()+8) != version)) {
+        return false;
+    }
+    m_device = device;
+    m_startTime = static_cast<qint64>(qFromLittleEndian<quint64>(header.data()+12));
+    return true;
+}
+
+
+auto Traffic::TrafficCapture::Reader::read(Traffic::TrafficCapture::Record& record) -> bool
+{
+    if (m_device == nullptr) {
+        return false;
+    }
+
+    std::array<char, recordHeaderSize> header {};
+    if (m_device->read(header.data(), header.size()) != recordHeaderSize) {
+        return false;
+    }
+    auto size = static_cast<qsizetype>(qFromLittleEndian<quint32>(header.data()+9));
+    if ((size > maxPayloadSize) || (static_cast<quint8>(header[8]) > static_cast<quint8>(Channel::Sentence))) {
+        return false;
+    }
+    if (m_payload.size() < size) {
+        m_payload.resize(size);
+    }
+    if (m_device->read(m_payload.data(), size) != size) {
+        return false;
+    }
+
+    record.timestamp = static_cast<qint64>(qFromLittleEndian<quint64>(header.data()));
+    record.channel = static_cast<Channel>(header[8]);
+    record.data = QByteArrayView(m_payload.constData(), size);
+    return true;
+}
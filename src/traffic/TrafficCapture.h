@@ -0,0 +1,226 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QElapsedTimer>
+#include <QFile>
+
+
+/*! \brief Binary capture of raw traffic receiver data
+ *
+ *  A capture file records the payloads that traffic data sources receive
+ *  from the network, exactly as received, together with microsecond
+ *  timestamps.  Captures can be replayed through the regular parsers with
+ *  TrafficDataSource_File, which makes it possible to reproduce field issues
+ *  and to benchmark the traffic pipeline deterministically.
+ *
+ *  All numbers are little endian.  The file starts with a header
+ *
+ *  - 8 bytes magic "ENRTRCAP"
+ *  - quint32 format version, currently 1
+ *  - quint64 start of the capture, in microseconds since the epoch
+ *
+ *  followed by any number of records
+ *
+ *  - quint64 time since start of the capture, in microseconds
+ *  - quint8 channel, as in Channel
+ *  - quint32 size of the payload
+ *  - payload
+ */
+
+namespace Traffic::TrafficCapture {
+
+/*! \brief Kind of payload */
+enum class Channel : quint8 {
+    TCP = 0,    /*!< Bytes read from a TCP stream, not aligned with lines */
+    UDP = 1,    /*!< One UDP datagram */
+    Sentence = 2 /*!< One complete FLARM/NMEA sentence */
+};
+
+/*! \brief Magic bytes at the beginning of a capture file */
+constexpr QByteArrayView magic {"ENRTRCAP"};
+
+/*! \brief Format version written by this implementation */
+constexpr quint32 version = 1;
+
+/*! \brief Size of the file header, in bytes */
+constexpr qsizetype headerSize = 8+4+8;
+
+/*! \brief Size of a record header, in bytes */
+constexpr qsizetype recordHeaderSize = 8+1+4;
+
+/*! \brief Maximal size of a payload
+ *
+ *  Records with larger payloads are considered corrupt.
+ */
+constexpr quint32 maxPayloadSize = 65536;
+
+
+/*! \brief One record of a capture file */
+struct Record {
+    /*! \brief Time since start of the capture, in microseconds */
+    qint64 timestamp {0};
+
+    /*! \brief Kind of payload */
+    Channel channel {Channel::TCP};
+
+    /*! \brief Payload
+     *
+     *  This is a view into the reader's buffer, valid until the next record
+     *  is read.
+     */
+    QByteArrayView data;
+};
+
+
+/*! \brief Writes capture files
+ *
+ *  Writes are buffered by QFile.  The class is not thread-safe; it must be
+ *  used in the thread of the data source that owns it.
+ */
+class Writer
+{
+public:
+    /*! \brief Constructs a closed writer */
+    Writer() = default;
+
+    /*! \brief Destructor, closes the file */
+    ~Writer() = default;
+
+    /*! \brief Create file and write header
+     *
+     *  If the writer is already open, the current file is closed first.
+     *
+     *  @param fileName Name of the file. Existing files are overwritten.
+     *
+     *  @returns True on success
+     */
+    auto open(const QString& fileName) -> bool;
+
+    /*! \brief Flush and close file */
+    void close();
+
+    /*! \brief Check if the writer is open
+     *
+     *  @returns True if a file is open for writing
+     */
+    [[nodiscard]] auto isOpen() const -> bool
+    {
+        return m_file.isOpen();
+    }
+
+    /*! \brief Error message
+     *
+     *  @returns Human-readable description of the last error
+     */
+    [[nodiscard]] auto errorString() const -> QString
+    {
+        return m_file.errorString();
+    }
+
+    /*! \brief Append record
+     *
+     *  The timestamp is taken from a monotonic clock.  Nothing happens if the
+     *  writer is not open.  If writing fails, the file is closed.
+     *
+     *  @param channel Kind of payload
+     *
+     *  @param data Payload
+     */
+    void write(Traffic::TrafficCapture::Channel channel, QByteArrayView data);
+
+private:
+    Q_DISABLE_COPY_MOVE(Writer)
+
+    QFile m_file;
+
+    // Measures the time since the start of the capture
+    QElapsedTimer m_clock;
+};
+
+
+/*! \brief Reads capture files
+ *
+ *  The reader does not own the device it reads from.
+ */
+class Reader
+{
+public:
+    /*! \brief Constructs a reader without device */
+    Reader() = default;
+
+    /*! \brief Standard destructor */
+    ~Reader() = default;
+
+    /*! \brief Check if a file is a capture file
+     *
+     *  @param fileName Name of the file to be checked
+     *
+     *  @returns True if the file starts with a valid header
+     */
+    static auto isCaptureFile(const QString& fileName) -> bool;
+
+    /*! \brief Set device and read header
+     *
+     *  @param device Device, opened for reading and positioned at the
+     *  beginning of the capture. The device must outlive the reader, or
+     *  setDevice() must be called again before the device is destroyed.
+     *
+     *  @returns True if the device starts with a valid header. Otherwise, the
+     *  reader has no device.
+     */
+    auto setDevice(QIODevice* device) -> bool;
+
+    /*! \brief Start of the capture
+     *
+     *  @returns Start of the capture, in microseconds since the epoch, or 0
+     *  if there is no device
+     */
+    [[nodiscard]] auto startTime() const -> qint64
+    {
+        return m_startTime;
+    }
+
+    /*! \brief Read next record
+     *
+     *  @param record Record to be filled. The payload view stays valid until
+     *  the next call of this method.
+     *
+     *  @returns False at the end of the data, if there is no device, or if
+     *  the data is truncated or corrupt
+     */
+    auto read(Traffic::TrafficCapture::Record& record) -> bool;
+
+private:
+    Q_DISABLE_COPY_MOVE(Reader)
+
+    QIODevice* m_device {nullptr};
+    qint64 m_startTime {0};
+
+    // Payload of the current record. The buffer only grows, so that reading
+    // records does not allocate once it has reached the size of the largest
+    // payload.
+    QByteArray m_payload;
+};
+
+} // namespace Traffic::TrafficCapture
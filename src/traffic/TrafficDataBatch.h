@@ -0,0 +1,221 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QGeoCoordinate>
+#include <QVector>
+
+#include "positioning/PositionInfo.h"
+#include "traffic/TrafficFactor_DistanceOnly.h"
+#include "traffic/TrafficFactor_WithPosition.h"
+#include "units/Angle.h"
+#include "units/Speed.h"
+#include "units/Time.h"
+
+
+namespace Traffic {
+
+/*! \brief Traffic report
+ *
+ *  This is a plain value type that holds the data of one traffic report, as
+ *  decoded by a traffic data source.  Unlike the QObject-based
+ *  TrafficFactor_* classes, it can be copied freely and passed between
+ *  threads.
+ */
+struct TrafficReport {
+    /*! \brief Construct report from traffic factor
+     *
+     *  @param factor Traffic factor whose data is copied
+     *
+     *  @returns Traffic report
+     */
+    static auto fromFactor(const Traffic::TrafficFactor_WithPosition& factor) -> TrafficReport
+    {
+        TrafficReport result;
+        result.alarmLevel = factor.alarmLevel();
+        result.callSign = factor.callSign();
+        result.hDist = factor.hDist();
+        result.ID = factor.ID();
+        result.positionInfo = factor.positionInfo();
+        result.type = factor.type();
+        result.vDist = factor.vDist();
+        return result;
+    }
+
+    /*! \brief Construct report from traffic factor
+     *
+     *  @param factor Traffic factor whose data is copied
+     *
+     *  @returns Traffic report
+     */
+    static auto fromFactor(const Traffic::TrafficFactor_DistanceOnly& factor) -> TrafficReport
+    {
+        TrafficReport result;
+        result.alarmLevel = factor.alarmLevel();
+        result.callSign = factor.callSign();
+        result.coordinate = factor.coordinate();
+        result.hDist = factor.hDist();
+        result.ID = factor.ID();
+        result.type = factor.type();
+        result.vDist = factor.vDist();
+        return result;
+    }
+
+    /*! \brief Copy data into traffic factor
+     *
+     *  This method sets the properties of the factor and starts its lifetime.
+     *
+     *  @param factor Traffic factor whose properties are set
+     */
+    void copyTo(Traffic::TrafficFactor_WithPosition& factor) const
+    {
+        factor.setAlarmLevel(alarmLevel);
+        factor.setCallSign(callSign);
+        factor.setHDist(hDist);
+        factor.setID(ID);
+        factor.setPositionInfo(positionInfo);
+        factor.setType(type);
+        factor.setVDist(vDist);
+        factor.startLiveTime();
+    }
+
+    /*! \brief Copy data into traffic factor
+     *
+     *  This method sets the properties of the factor and starts its lifetime.
+     *
+     *  @param factor Traffic factor whose properties are set
+     */
+    void copyTo(Traffic::TrafficFactor_DistanceOnly& factor) const
+    {
+        factor.setAlarmLevel(alarmLevel);
+        factor.setCallSign(callSign);
+        factor.setCoordinate(coordinate);
+        factor.setHDist(hDist);
+        factor.setID(ID);
+        factor.setType(type);
+        factor.setVDist(vDist);
+        factor.startLiveTime();
+    }
+
+    /*! \brief Predicted separation
+     *
+     *  @returns Horizontal distance at the closest point of approach if it is
+     *  known and smaller than hDist, and hDist otherwise
+     */
+    [[nodiscard]] auto predictedSeparation() const -> Units::Distance
+    {
+        if (cpaDist.isFinite() && (cpaDist < hDist)) {
+            return cpaDist;
+        }
+        return hDist;
+    }
+
+    /*! \brief Alarm level, in the range 0, …, 3 */
+    int alarmLevel {0};
+
+    /*! \brief Call sign, or empty string */
+    QString callSign;
+
+    /*! \brief Climb rate, estimated from the recent track, might be NaN
+     *
+     *  This is computed by the TrafficDataProvider, see TrackHistory.
+     */
+    Units::Speed climbRate;
+
+    /*! \brief Center coordinate, for reports without position */
+    QGeoCoordinate coordinate;
+
+    /*! \brief Predicted horizontal distance at the closest point of approach
+     *
+     *  This is computed by the TrafficDataProvider, not by the traffic data
+     *  sources, and might be NaN.
+     */
+    Units::Distance cpaDist;
+
+    /*! \brief Horizontal distance to own aircraft, might be NaN */
+    Units::Distance hDist;
+
+    /*! \brief Identifier, typically the FLARM ID or ICAO address */
+    QString ID;
+
+    /*! \brief Position, for reports with position */
+    Positioning::PositionInfo positionInfo;
+
+    /*! \brief Time at which the report was read from the socket
+     *
+     *  This is set by the traffic data source, in nanoseconds on the clock of
+     *  IngestionStatistics::now(), or 0 if unknown.  See TrafficLatency.
+     */
+    qint64 receiveTime {0};
+
+    /*! \brief Time to the closest point of approach, might be NaN
+     *
+     *  See cpaDist.
+     */
+    Units::Time tcpa;
+
+    /*! \brief Change of track per second, positive for right turns
+     *
+     *  This is estimated from the recent track by the TrafficDataProvider,
+     *  see TrackHistory, and might be NaN.
+     */
+    Units::Angle turnRate;
+
+    /*! \brief Aircraft type */
+    Traffic::TrafficFactor_Abstract::AircraftType type {Traffic::TrafficFactor_Abstract::unknown};
+
+    /*! \brief Vertical distance to own aircraft, might be NaN */
+    Units::Distance vDist;
+};
+
+
+/*! \brief Batch of data decoded by a traffic data source
+ *
+ *  Traffic data sources collect decoded data in instances of this class and
+ *  hand them to the TrafficDataProvider at most once per display frame.
+ *  Position and pressure altitude of the own aircraft are superseded by newer
+ *  values, so only the most recent ones are kept.  Traffic reports are kept in
+ *  the order of arrival.
+ */
+struct TrafficDataBatch {
+    /*! \brief Check if the batch contains data
+     *
+     *  @returns True if the batch contains neither ownship data nor traffic
+     */
+    [[nodiscard]] auto isEmpty() const -> bool
+    {
+        return !positionInfo.isValid() && !pressureAltitude.isFinite() && factorsWithPosition.isEmpty() && factorsWithoutPosition.isEmpty();
+    }
+
+    /*! \brief Most recent position of own aircraft, or invalid */
+    Positioning::PositionInfo positionInfo;
+
+    /*! \brief Most recent pressure altitude of own aircraft, or NaN */
+    Units::Distance pressureAltitude;
+
+    /*! \brief Traffic reports with position, in order of arrival */
+    QVector<Traffic::TrafficReport> factorsWithPosition;
+
+    /*! \brief Traffic reports without position, in order of arrival */
+    QVector<Traffic::TrafficReport> factorsWithoutPosition;
+};
+
+} // namespace Traffic
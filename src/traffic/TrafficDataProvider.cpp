@@ -19,11 +19,17 @@
  ***************************************************************************/
 
 #include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
 #include <QQmlEngine>
+#include <QQuickWindow>
 #include <chrono>
 
 #include "GlobalObject.h"
 #include "platform/PlatformAdaptor_Abstract.h"
+#include "positioning/PositionProvider.h"
+#include "traffic/PasswordDB.h"
 #include "traffic/TrafficDataProvider.h"
 #include "traffic/TrafficDataSource_Tcp.h"
 #include "traffic/TrafficDataSource_Udp.h"
@@ -31,18 +37,33 @@
 using namespace std::chrono_literals;
 
 
+// Static Helper functions
+
+// Constructs an object of type T in the given thread, so that the object and
+// all of its members have affinity to that thread. The thread must be running.
+template<typename T, typename... Args> auto constructInThread(QThread* thread, Args... args) -> T*
+{
+    T* result = nullptr;
+    auto* context = new QObject();
+    context->moveToThread(thread);
+    QMetaObject::invokeMethod(context, [&result, args...]() { result = new T(args...); }, Qt::BlockingQueuedConnection);
+    context->deleteLater();
+    return result;
+}
+
+
 // Member functions
 
 Traffic::TrafficDataProvider::TrafficDataProvider(QObject *parent) : Positioning::PositionInfoSource_Abstract(parent) {
 
     // Create traffic objects
-    int numTrafficObjects = 20;
-    m_trafficObjects.reserve(numTrafficObjects);
-    for(int i = 0; i<numTrafficObjects; i++) {
-        auto *trafficObject = new Traffic::TrafficFactor_WithPosition(this);
-        QQmlEngine::setObjectOwnership(trafficObject, QQmlEngine::CppOwnership);
-        m_trafficObjects.append( trafficObject );
-    }
+    m_trafficTargets = new Traffic::TrafficTargetModel(this);
+    QQmlEngine::setObjectOwnership(m_trafficTargets, QQmlEngine::CppOwnership);
+    m_targetClock.start();
+    m_targetExpiryTimer.setInterval(1s);
+    m_targetExpiryTimer.callOnTimeout([this]() { publishTargets(); });
+    m_deadReckoning = new Traffic::DeadReckoning(this);
+    QQmlEngine::setObjectOwnership(m_deadReckoning, QQmlEngine::CppOwnership);
     m_trafficObjectWithoutPosition = new Traffic::TrafficFactor_DistanceOnly(this);
     QQmlEngine::setObjectOwnership(m_trafficObjectWithoutPosition, QQmlEngine::CppOwnership);
 
@@ -50,19 +71,30 @@ Traffic::TrafficDataProvider::TrafficDataProvider(QObject *parent) : Positioning
 
     // Setup FLARM warning
     m_WarningTimer.setInterval( Positioning::PositionInfo::lifetime );
-    m_WarningTimer.setSingleShot(true);
-    connect(&m_WarningTimer, &QTimer::timeout, this, &Traffic::TrafficDataProvider::resetWarning);
+    m_WarningTimer.callOnTimeout([this]() { resetWarning(); });
 
     // Setup ForeFlight Broadcases
     foreFlightBroadcastTimer.setInterval(5s);
     connect(&foreFlightBroadcastTimer, &QTimer::timeout, this, &Traffic::TrafficDataProvider::foreFlightBroadcast);
     foreFlightBroadcastTimer.start();
 
-    // Real data sources in order of preference, preferred sources first
-    addDataSource( new Traffic::TrafficDataSource_Tcp(QStringLiteral("192.168.1.1"), 2000, this));
-    addDataSource( new Traffic::TrafficDataSource_Tcp(QStringLiteral("192.168.10.1"), 2000, this) );
-    addDataSource( new Traffic::TrafficDataSource_Udp(4000, this) );
-    addDataSource( new Traffic::TrafficDataSource_Udp(49002, this));
+    // Setup ingestion statistics. The statistics are sampled only while a
+    // view shows them.
+    m_ingestionStatistics = new Traffic::IngestionStatisticsModel(this);
+    QQmlEngine::setObjectOwnership(m_ingestionStatistics, QQmlEngine::CppOwnership);
+    m_ingestionStatisticsTimer.setInterval(1s);
+    connect(&m_ingestionStatisticsTimer, &QTimer::timeout, this, &Traffic::TrafficDataProvider::updateIngestionStatistics);
+    connect(m_ingestionStatistics, &Traffic::IngestionStatisticsModel::activeChanged, this, &Traffic::TrafficDataProvider::onIngestionStatisticsActiveChanged);
+
+    // Real data sources in order of preference, preferred sources first. The
+    // sources are constructed in the traffic I/O thread, where they read from
+    // the network and decode data.
+    m_ioThread.setObjectName(QStringLiteral("Traffic I/O"));
+    m_ioThread.start();
+    addDataSource( constructInThread<Traffic::TrafficDataSource_Tcp>(&m_ioThread, QStringLiteral("192.168.1.1"), quint16(2000)) );
+    addDataSource( constructInThread<Traffic::TrafficDataSource_Tcp>(&m_ioThread, QStringLiteral("192.168.10.1"), quint16(2000)) );
+    addDataSource( constructInThread<Traffic::TrafficDataSource_Udp>(&m_ioThread, quint16(4000)) );
+    addDataSource( constructInThread<Traffic::TrafficDataSource_Udp>(&m_ioThread, quint16(49002)) );
 
     // Bindings for status string
     connect(this, &Traffic::TrafficDataProvider::positionInfoChanged, this, &Traffic::TrafficDataProvider::updateStatusString);
@@ -84,6 +116,16 @@ Traffic::TrafficDataProvider::TrafficDataProvider(QObject *parent) : Positioning
 }
 
 
+Traffic::TrafficDataProvider::~TrafficDataProvider()
+{
+    clearDataSources();
+
+    // Sources in the traffic I/O thread are deleted when the thread finishes
+    m_ioThread.quit();
+    m_ioThread.wait();
+}
+
+
 void Traffic::TrafficDataProvider::clearDataSources()
 {
     foreach(auto dataSource, m_dataSources) {
@@ -91,9 +133,41 @@ void Traffic::TrafficDataProvider::clearDataSources()
             continue;
         }
         dataSource->disconnect();
-        delete dataSource;
+        if (dataSource->thread() == thread()) {
+            delete dataSource;
+        } else {
+            dataSource->deleteLater();
+        }
     }
     m_dataSources.clear();
+    m_ingestionSnapshots.clear();
+    m_currentSource = nullptr;
+}
+
+
+void Traffic::TrafficDataProvider::startCapture(const QString& directory)
+{
+    QDir().mkpath(directory);
+    auto prefix = QStringLiteral("%1/traffic-%2").arg(directory, QDateTime::currentDateTimeUtc().toString(QStringLiteral("yyyyMMdd-hhmmss")));
+    for(qsizetype i=0; i<m_dataSources.size(); i++) {
+        auto dataSource = m_dataSources.at(i);
+        if (dataSource.isNull()) {
+            continue;
+        }
+        auto fileName = QStringLiteral("%1-%2.capture").arg(prefix).arg(i);
+        QMetaObject::invokeMethod(dataSource, [dataSource, fileName]() { dataSource->startCapture(fileName); });
+    }
+}
+
+
+void Traffic::TrafficDataProvider::stopCapture()
+{
+    foreach(auto dataSource, m_dataSources) {
+        if (dataSource.isNull()) {
+            continue;
+        }
+        QMetaObject::invokeMethod(dataSource, [dataSource]() { dataSource->stopCapture(); });
+    }
 }
 
 
@@ -102,17 +176,26 @@ void Traffic::TrafficDataProvider::addDataSource(Traffic::TrafficDataSource_Abst
 
     Q_ASSERT( source != nullptr );
 
-    source->setParent(this);
+    // Sources in the traffic I/O thread are deleted in clearDataSources()
+    if (source->thread() == thread()) {
+        source->setParent(this);
+    }
     m_dataSources << source;
+    connect(source, &Traffic::TrafficDataSource_Abstract::dataBatchReady, this, [this, source](const Traffic::TrafficDataBatch& batch) { onDataBatch(source, batch); });
     connect(source, &Traffic::TrafficDataSource_Abstract::connectivityStatusChanged, this, &Traffic::TrafficDataProvider::updateStatusString);
     connect(source, &Traffic::TrafficDataSource_Abstract::errorStringChanged, this, &Traffic::TrafficDataProvider::updateStatusString);
+    connect(source, &Traffic::TrafficDataSource_Abstract::passwordLookupRequest, this, [this, source]() { onPasswordLookupRequest(source); });
+    connect(source, &Traffic::TrafficDataSource_Abstract::passwordRejected, this, &Traffic::TrafficDataProvider::onPasswordRejected);
     connect(source, &Traffic::TrafficDataSource_Abstract::passwordRequest, this, &Traffic::TrafficDataProvider::passwordRequest);
-    connect(source, &Traffic::TrafficDataSource_Abstract::passwordStorageRequest, this, &Traffic::TrafficDataProvider::passwordStorageRequest);
+    connect(source, &Traffic::TrafficDataSource_Abstract::passwordStorageRequest, this, &Traffic::TrafficDataProvider::onPasswordStorageRequest);
     connect(source, &Traffic::TrafficDataSource_Abstract::receivingHeartbeatChanged, this, &Traffic::TrafficDataProvider::updateStatusString);
     connect(source, &Traffic::TrafficDataSource_Abstract::receivingHeartbeatChanged, this, &Traffic::TrafficDataProvider::onSourceHeartbeatChanged);
     connect(source, &Traffic::TrafficDataSource_Abstract::trafficReceiverRuntimeErrorChanged, this, &Traffic::TrafficDataProvider::onTrafficReceiverRuntimeError);
     connect(source, &Traffic::TrafficDataSource_Abstract::trafficReceiverSelfTestErrorChanged, this, &Traffic::TrafficDataProvider::onTrafficReceiverSelfTestError);
 
+    // Tell the source where we are. This is deferred, in order to avoid
+    // nested uses of constructors in Global.
+    QTimer::singleShot(0, this, &Traffic::TrafficDataProvider::updateOwnshipPosition);
 }
 
 
@@ -122,15 +205,25 @@ void Traffic::TrafficDataProvider::connectToTrafficReceiver()
         if (dataSource.isNull()) {
             continue;
         }
-        dataSource->connectToTrafficReceiver();
+        QMetaObject::invokeMethod(dataSource, &Traffic::TrafficDataSource_Abstract::connectToTrafficReceiver);
     }
 }
 
 
-void Traffic::TrafficDataProvider::deferredInitialization() const
+void Traffic::TrafficDataProvider::deferredInitialization()
 {
     // Try to (re)connect whenever the network situation changes
     connect(GlobalObject::platformAdaptor(), &Platform::PlatformAdaptor_Abstract::wifiConnected, this, &Traffic::TrafficDataProvider::connectToTrafficReceiver);
+
+    // The sources in the traffic I/O thread use this global object.  Make
+    // sure it is constructed here, in the main thread.
+    GlobalObject::flarmnetDB();
+
+    // Keep the sources informed about the position of the own aircraft
+    auto* positionProvider = GlobalObject::positionProvider();
+    connect(positionProvider, &Positioning::PositionProvider::positionInfoChanged, this, &Traffic::TrafficDataProvider::updateOwnshipPosition);
+    connect(positionProvider, &Positioning::PositionProvider::lastValidCoordinateChanged, this, &Traffic::TrafficDataProvider::updateOwnshipPosition);
+    updateOwnshipPosition();
 }
 
 
@@ -140,7 +233,7 @@ void Traffic::TrafficDataProvider::disconnectFromTrafficReceiver()
         if (dataSource.isNull()) {
             continue;
         }
-        dataSource->disconnectFromTrafficReceiver();
+        QMetaObject::invokeMethod(dataSource, &Traffic::TrafficDataSource_Abstract::disconnectFromTrafficReceiver);
     }
 }
 
@@ -151,6 +244,99 @@ void Traffic::TrafficDataProvider::foreFlightBroadcast()
 }
 
 
+auto Traffic::TrafficDataProvider::latencyStatisticsJSON() const -> QByteArray
+{
+    return QJsonDocument(m_latency.toJSON()).toJson();
+}
+
+
+void Traffic::TrafficDataProvider::onDataBatch(Traffic::TrafficDataSource_Abstract* source, const Traffic::TrafficDataBatch& batch)
+{
+    // Data about the own aircraft is taken from the current source only
+    if (source == m_currentSource) {
+        if (batch.pressureAltitude.isFinite()) {
+            setPressureAltitude(batch.pressureAltitude);
+        }
+        if (batch.positionInfo.isValid()) {
+            setPositionInfo(batch.positionInfo);
+        }
+    }
+
+    for(const auto& report : batch.factorsWithoutPosition) {
+        m_latency.addReport(report.receiveTime);
+        report.copyTo(m_incomingFactorDistanceOnly);
+        onTrafficFactorWithoutPosition(m_incomingFactorDistanceOnly);
+    }
+    // Update the target table. Reports are correlated with the targets that
+    // other sources have reported, and data from preferred sources takes
+    // precedence. Traffic that is too far away is removed.
+    auto now = m_targetClock.elapsed();
+    auto priority = static_cast<int>(m_dataSources.indexOf(source));
+    for(const auto& report : batch.factorsWithPosition) {
+        m_latency.addReport(report.receiveTime);
+        bool farAway = false;
+        if (report.vDist.isFinite() && (report.vDist > maxVerticalDistance)) {
+            farAway = true;
+        }
+        if (report.hDist.isFinite() && (report.hDist > maxHorizontalDistance)) {
+            farAway = true;
+        }
+
+        auto ID = m_fusion.correlate(m_targets, report, priority);
+        const auto* entry = m_targets.find(ID);
+        if ((entry != nullptr) && !Traffic::TrafficFusion::mayUpdate(*entry, priority, now)) {
+            continue;
+        }
+        if (farAway) {
+            m_targets.remove(ID);
+            continue;
+        }
+        if (ID == report.ID) {
+            m_targets.update(report, now, priority);
+        } else {
+            auto fusedReport = report;
+            fusedReport.ID = ID;
+            m_targets.update(fusedReport, now, priority);
+        }
+    }
+    // Only data that changes the screen is waiting for a frame
+    auto targetsChanged = publishTargets();
+    if (targetsChanged || !batch.factorsWithoutPosition.isEmpty()) {
+        m_latency.markRenderPending();
+    }
+}
+
+
+void Traffic::TrafficDataProvider::onPasswordLookupRequest(Traffic::TrafficDataSource_Abstract* source)
+{
+    auto SSID = GlobalObject::platformAdaptor()->currentSSID();
+    auto* passwordDB = GlobalObject::passwordDB();
+    QString storedPassword;
+    if (passwordDB->contains(SSID)) {
+        storedPassword = passwordDB->getPassword(SSID);
+    }
+
+    // The source lives in the traffic I/O thread. If it is deleted before the
+    // call is delivered, the call is dropped.
+    QMetaObject::invokeMethod(source, [source, SSID, storedPassword]() { source->answerPasswordLookup(SSID, storedPassword); });
+}
+
+
+void Traffic::TrafficDataProvider::onPasswordRejected(const QString& SSID)
+{
+    GlobalObject::passwordDB()->removePassword(SSID);
+}
+
+
+void Traffic::TrafficDataProvider::onPasswordStorageRequest(const QString& SSID, const QString& password)
+{
+    auto* passwordDB = GlobalObject::passwordDB();
+    if (!passwordDB->contains(SSID) || (passwordDB->getPassword(SSID) != password)) {
+        emit passwordStorageRequest(SSID, password);
+    }
+}
+
+
 void Traffic::TrafficDataProvider::onSourceHeartbeatChanged()
 {
     // If we have a current source, if the current source has a heartbeat and if the current source is a TCP source, then we simply stick with it.
@@ -178,10 +364,6 @@ void Traffic::TrafficDataProvider::onSourceHeartbeatChanged()
 
         // Disconnect old m_currentSource
         if (!m_currentSource.isNull()) {
-            disconnect(m_currentSource, &Traffic::TrafficDataSource_Abstract::pressureAltitudeUpdated, this, &Traffic::TrafficDataProvider::setPressureAltitude);
-            disconnect(m_currentSource, &Traffic::TrafficDataSource_Abstract::factorWithoutPosition, this, &Traffic::TrafficDataProvider::onTrafficFactorWithoutPosition);
-            disconnect(m_currentSource, &Traffic::TrafficDataSource_Abstract::factorWithPosition, this, &Traffic::TrafficDataProvider::onTrafficFactorWithPosition);
-            disconnect(m_currentSource, &Traffic::TrafficDataSource_Abstract::positionUpdated, this, &Traffic::TrafficDataProvider::setPositionInfo);
             disconnect(m_currentSource, &Traffic::TrafficDataSource_Abstract::warning, this, &Traffic::TrafficDataProvider::setWarning);
         }
 
@@ -189,29 +371,11 @@ void Traffic::TrafficDataProvider::onSourceHeartbeatChanged()
         m_currentSource = heartbeatDataSource;
 
         if (!m_currentSource.isNull()) {
-            // If there is a new m_currentSource, then setup Qt connections and
-            // disconnect all sources of lower priority from the traffic receivers.
-            connect(m_currentSource, &Traffic::TrafficDataSource_Abstract::pressureAltitudeUpdated, this, &Traffic::TrafficDataProvider::setPressureAltitude);
-            connect(m_currentSource, &Traffic::TrafficDataSource_Abstract::factorWithoutPosition, this, &Traffic::TrafficDataProvider::onTrafficFactorWithoutPosition);
-            connect(m_currentSource, &Traffic::TrafficDataSource_Abstract::factorWithPosition, this, &Traffic::TrafficDataProvider::onTrafficFactorWithPosition);
-            connect(m_currentSource, &Traffic::TrafficDataSource_Abstract::positionUpdated, this, &Traffic::TrafficDataProvider::setPositionInfo);
+            // If there is a new m_currentSource, then setup Qt connections.
+            // Warnings are not batched and reach us right away. Sources of
+            // lower priority stay connected to their traffic receivers,
+            // because their traffic is merged with that of m_currentSource.
             connect(m_currentSource, &Traffic::TrafficDataSource_Abstract::warning, this, &Traffic::TrafficDataProvider::setWarning);
-
-            // Disconnect from traffic receiver
-            bool doDisconnect = false;
-            foreach(auto source, m_dataSources) {
-                if ( source.isNull() ) {
-                    continue;
-                }
-                if (source == m_currentSource) {
-                    doDisconnect = true;
-                    continue;
-                }
-                if (doDisconnect) {
-                    source->disconnectFromTrafficReceiver();
-                }
-            }
-
         } else {
             // If there is no m_currentSource, then try in 1sek to (re)connect to any
             // traffic receiver out there.
@@ -248,55 +412,6 @@ void Traffic::TrafficDataProvider::onTrafficFactorWithoutPosition(const Traffic:
 }
 
 
-void Traffic::TrafficDataProvider::onTrafficFactorWithPosition(const Traffic::TrafficFactor_WithPosition &factor)
-{
-
-    // Check if traffic is too far away to be shown
-    bool farAway = false;
-    if (factor.vDist().isFinite() && (factor.vDist() > maxVerticalDistance)) {
-        farAway = true;
-    }
-    if (factor.hDist().isFinite() && (factor.hDist() > maxHorizontalDistance)) {
-        farAway = true;
-    }
-
-
-    // Check if the traffic is one of the known factors.
-    foreach(auto target, m_trafficObjects) {
-        if (factor.ID() == target->ID()) {
-            // If traffic is too far away, delete the entry. Otherwise, replace the entry by the factor.
-            if (farAway) {
-                target->setAnimate(false);
-                target->copyFrom(TrafficFactor_WithPosition());
-            } else {
-                target->setAnimate(true);
-                target->copyFrom(factor);
-                target->startLiveTime();
-            }
-            return;
-        }
-    }
-
-    // If traffic is too far away, ignore the factor.
-    if (farAway) {
-        return;
-    }
-
-    auto *lowestPriObject = m_trafficObjects.at(0);
-    foreach(auto target, m_trafficObjects) {
-        if (lowestPriObject->hasHigherPriorityThan(*target)) {
-            lowestPriObject = target;
-        }
-    }
-    if (factor.hasHigherPriorityThan(*lowestPriObject)) {
-        lowestPriObject->setAnimate(false);
-        lowestPriObject->copyFrom(factor);
-        lowestPriObject->startLiveTime();
-    }
-
-}
-
-
 void Traffic::TrafficDataProvider::onTrafficReceiverRuntimeError(const QString& msg)
 {
     Q_UNUSED(msg);
@@ -343,6 +458,49 @@ void Traffic::TrafficDataProvider::onTrafficReceiverSelfTestError(const QString&
 }
 
 
+auto Traffic::TrafficDataProvider::publishTargets() -> bool
+{
+    m_publishTargetsPending = false;
+
+    // Drop targets that have not been reported for a while
+    auto lifeTimeMS = std::chrono::duration_cast<std::chrono::milliseconds>(Traffic::TrafficFactor_Abstract::lifeTime).count();
+    m_targets.removeOlderThan(m_targetClock.elapsed() - lifeTimeMS);
+    m_fusion.prune(m_targets);
+
+    // Predict separations, then record tracks and estimate climb and turn
+    // rates. The track history ranks targets by the current predictions
+    // when it runs out of buffers.
+    m_targets.updateAll([this](std::span<Traffic::TrafficTargetTable::Entry> entries) {
+        m_conflictPredictor.predict(entries);
+        m_trackHistory.record(entries);
+    });
+
+    auto topTargets = m_targets.topN(numTrafficTargets4QML);
+    auto changed = m_trafficTargets->setTargets(topTargets);
+    m_deadReckoning->setTargets(topTargets);
+
+    // Come back later to expire the remaining targets
+    if ((m_targets.size() > 0) && !m_targetExpiryTimer.isActive()) {
+        m_targetExpiryTimer.start();
+    }
+    return changed;
+}
+
+
+void Traffic::TrafficDataProvider::schedulePublishTargets()
+{
+    if (m_publishTargetsPending) {
+        return;
+    }
+    m_publishTargetsPending = true;
+    QTimer::singleShot(0, this, [this]() {
+        if (m_publishTargetsPending) {
+            publishTargets();
+        }
+    });
+}
+
+
 void Traffic::TrafficDataProvider::resetWarning()
 {
     setWarning( Traffic::Warning() );
@@ -355,12 +513,24 @@ void Traffic::TrafficDataProvider::setPassword(const QString& SSID, const QStrin
         if (dataSource.isNull()) {
             continue;
         }
-        dataSource->setPassword(SSID, password);
+        auto* source = dataSource.data();
+        QMetaObject::invokeMethod(source, [source, SSID, password]() { source->setPassword(SSID, password); });
     }
 
 }
 
 
+void Traffic::TrafficDataProvider::setTargetCapacity(int newCapacity)
+{
+    if (newCapacity == m_targets.capacity()) {
+        return;
+    }
+    m_targets.setCapacity(newCapacity);
+    publishTargets();
+    emit targetCapacityChanged();
+}
+
+
 void Traffic::TrafficDataProvider::setReceivingHeartbeat(bool newReceivingHeartbeat)
 {
     if (m_receivingHeartbeat == newReceivingHeartbeat) {
@@ -371,10 +541,21 @@ void Traffic::TrafficDataProvider::setReceivingHeartbeat(bool newReceivingHeartb
 }
 
 
+void Traffic::TrafficDataProvider::setRenderWindow(QQuickWindow* window)
+{
+    Q_ASSERT(window != nullptr);
+
+    // These signals are emitted in the render thread
+    connect(window, &QQuickWindow::afterSynchronizing, this, [this]() { m_latency.onAfterSynchronizing(); }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() { m_latency.onFrameSwapped(); }, Qt::DirectConnection);
+}
+
+
 void Traffic::TrafficDataProvider::setWarning(const Traffic::Warning& warning)
 {
     if (warning.alarmLevel() > -1) {
         m_WarningTimer.start();
+        m_latency.addWarning(warning.receiveTime());
     }
 
     if (m_Warning == warning) {
@@ -383,6 +564,69 @@ void Traffic::TrafficDataProvider::setWarning(const Traffic::Warning& warning)
 
     m_Warning = warning;
     emit warningChanged(m_Warning);
+    m_latency.markRenderPending(m_Warning.receiveTime());
+}
+
+
+void Traffic::TrafficDataProvider::updateIngestionStatistics()
+{
+    m_ingestionSnapshots.resize(m_dataSources.size());
+
+    QStringList sourceNames;
+    QVector<QVariantMap> statistics;
+    for(qsizetype i=0; i<m_dataSources.size(); i++) {
+        auto dataSource = m_dataSources.at(i);
+        if (dataSource.isNull()) {
+            continue;
+        }
+        auto snapshot = dataSource->ingestionStatistics().snapshot();
+        sourceNames << dataSource->sourceName();
+        statistics << snapshot.toJSON(m_ingestionSnapshots.at(i)).toVariantMap();
+        m_ingestionSnapshots[i] = snapshot;
+    }
+
+    m_ingestionStatistics->setStatistics(sourceNames, statistics);
+}
+
+
+void Traffic::TrafficDataProvider::onIngestionStatisticsActiveChanged()
+{
+    if (!m_ingestionStatistics->active()) {
+        m_ingestionStatisticsTimer.stop();
+        return;
+    }
+
+    // Old snapshots would yield rates averaged over the time when nobody
+    // looked. Start afresh, without rates for the first update.
+    m_ingestionSnapshots.clear();
+    updateIngestionStatistics();
+    m_ingestionStatisticsTimer.start();
+}
+
+
+void Traffic::TrafficDataProvider::updateOwnshipPosition()
+{
+    auto* positionProvider = GlobalObject::positionProvider();
+    if (positionProvider == nullptr) {
+        return;
+    }
+    auto positionInfo = positionProvider->positionInfo();
+    auto lastValidCoordinate = Positioning::PositionProvider::lastValidCoordinate();
+    m_conflictPredictor.setOwnship(positionInfo);
+    m_deadReckoning->setOwnship(positionInfo, lastValidCoordinate);
+
+    foreach(auto dataSource, m_dataSources) {
+        if (dataSource.isNull()) {
+            continue;
+        }
+        auto* source = dataSource.data();
+        QMetaObject::invokeMethod(source, [source, positionInfo, lastValidCoordinate]() { source->setOwnshipPosition(positionInfo, lastValidCoordinate); });
+    }
+
+    // Predictions depend on the own position. This method is called for
+    // several signals that accompany the same new position, so the targets
+    // are published only once.
+    schedulePublishTargets();
 }
 
 
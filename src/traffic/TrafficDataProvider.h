@@ -20,24 +20,39 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QNetworkDatagram>
 #include <QPointer>
-#include <QQmlListProperty>
+#include <QThread>
 #include <QUdpSocket>
 
 #include "positioning/PositionInfoSource_Abstract.h"
+#include "traffic/ConflictPredictor.h"
+#include "traffic/DeadReckoning.h"
+#include "traffic/IngestionStatistics.h"
+#include "traffic/IngestionStatisticsModel.h"
+#include "traffic/TrackHistory.h"
+#include "traffic/TrafficDataBatch.h"
+#include "traffic/TrafficFusion.h"
 #include "traffic/TrafficFactor_DistanceOnly.h"
 #include "traffic/TrafficFactor_WithPosition.h"
+#include "traffic/TrafficLatency.h"
+#include "traffic/TrafficTargetModel.h"
+#include "traffic/TrafficTargetTable.h"
 #include "traffic/Warning.h"
 
+class QQuickWindow;
+
 
 namespace Traffic {
 
 /*! \brief Traffic receiver
  *
  *  This class manages multiple TrafficDataSources. It combines the data
- *  streams, and passes data from the most relevant (if any) traffic data source
- *  on to the consumers of this class.
+ *  streams and passes them on to the consumers of this class.  Traffic from
+ *  all sources is merged into one target table, see TrafficFusion.  Position
+ *  data and traffic warnings are taken from the most relevant (if any)
+ *  traffic data source.
  *
  *  By default, it watches the following data channels:
  *
@@ -47,6 +62,11 @@ namespace Traffic {
  *  This class also acts as a PositionInfoSource, and passes position data (that
  *  some traffic receivers provide) on to the the consumers of this class.
  *
+ *  The TCP and UDP data sources live in a dedicated traffic I/O thread, where
+ *  they read from the network and decode the data. Decoded data reaches this
+ *  class in batches, at most once per display frame.  Traffic warnings are
+ *  delivered immediately.
+ *
  *  Following the standards established by the app ForeFlight, this classEnroute
  *  broadcasts a UDP message on port 63093 every 5 seconds while the app is
  *  running in the foreground. This message allows devices to discover Enroute’s
@@ -62,6 +82,9 @@ public:
      */
     explicit TrafficDataProvider(QObject *parent = nullptr);
 
+    // Standard destructor. This method stops the traffic I/O thread.
+    ~TrafficDataProvider() override;
+
     //
     // Methods
     //
@@ -70,7 +93,8 @@ public:
      *
      *  This method adds an additional data source to this TrafficDataProvider,
      *  typically a simulator source used for debugging purposes. The
-     *  TrafficDataProvider takes ownership of the source.
+     *  TrafficDataProvider takes ownership of the source. The source is used
+     *  in the thread where it lives.
      *
      *  @param source New TrafficDataSource that is to be added.
      */
@@ -79,6 +103,68 @@ public:
     /*! \brief Clear all data sources */
     void clearDataSources();
 
+    /*! \brief Start recording raw data of all data sources
+     *
+     *  Every data source writes the data it receives from the traffic
+     *  receiver into a capture file of its own, see
+     *  TrafficDataSource_Abstract::startCapture(). The files are named
+     *  "traffic-<time>-<n>.capture", where n is the index of the data source,
+     *  and can be replayed with TrafficDataSource_File.
+     *
+     *  @param directory Directory for the capture files. The directory is
+     *  created if it does not exist.
+     */
+    Q_INVOKABLE void startCapture(const QString& directory);
+
+    /*! \brief Stop recording raw data of all data sources */
+    Q_INVOKABLE void stopCapture();
+
+    /*! \brief Latency statistics
+     *
+     *  @returns JSON object with latency histograms for traffic reports and
+     *  warnings, from the socket to the TrafficDataProvider and from the
+     *  TrafficDataProvider to the screen, as described in
+     *  TrafficLatency::toJSON()
+     */
+    Q_INVOKABLE [[nodiscard]] QJsonObject latencyStatistics() const
+    {
+        return m_latency.toJSON();
+    }
+
+    /*! \brief Latency statistics, for export
+     *
+     *  @returns latencyStatistics(), as an indented JSON document
+     */
+    Q_INVOKABLE [[nodiscard]] QByteArray latencyStatisticsJSON() const;
+
+    /*! \brief Reset latency statistics */
+    Q_INVOKABLE void resetLatencyStatistics()
+    {
+        m_latency.reset();
+    }
+
+    /*! \brief Recent track of a traffic target
+     *
+     *  @param ID Target ID
+     *
+     *  @returns List of coordinates, for use as the path of a MapPolyline,
+     *  as described in TrackHistory::polyline()
+     */
+    Q_INVOKABLE [[nodiscard]] QVariantList trackPolyline(const QString& ID) const
+    {
+        return m_trackHistory.polyline(ID);
+    }
+
+    /*! \brief Measure latency up to the screen
+     *
+     *  This method connects to the signals of the window that shows the
+     *  traffic data, in order to find out when an update of the traffic data
+     *  reaches the screen.  The signals are handled in the render thread.
+     *
+     *  @param window Window that shows the traffic data
+     */
+    void setRenderWindow(QQuickWindow* window);
+
     //
     // Properties
     //
@@ -101,23 +187,68 @@ public:
         return m_receivingHeartbeat;
     }
 
-    /*! \brief Traffic objects whose position is known
+    /*! \brief Number of traffic targets exposed to QML
      *
-     *  This property holds a list of the most relevant traffic objects, as a
-     *  QQmlListProperty for better cooperation with QML. Note that only the
-     *  valid items in this list pertain to actual traffic. Invalid items should
-     *  be ignored. The list is not sorted in any way. The items themselves are
-     *  owned by this class.
+     *  The model in the property trafficTargets contains at most this many
+     *  rows.
+     */
+    static constexpr qsizetype numTrafficTargets4QML = 20;
+
+    /*! \brief Maximal number of traffic targets with known position
+     *
+     *  This class keeps track of up to this many targets, in a table that
+     *  allows fast updates. Only the most relevant of these targets are
+     *  exposed to QML, in the property trafficTargets.
+     */
+    Q_PROPERTY(int targetCapacity READ targetCapacity WRITE setTargetCapacity NOTIFY targetCapacityChanged)
+
+    /*! \brief Getter method for property with the same name
+     *
+     *  @returns Property targetCapacity
+     */
+    [[nodiscard]] auto targetCapacity() const -> int
+    {
+        return static_cast<int>(m_targets.capacity());
+    }
+
+    /*! \brief Setter method for property with the same name
+     *
+     *  @param newCapacity Property targetCapacity
+     */
+    void setTargetCapacity(int newCapacity);
+
+    /*! \brief Traffic targets whose position is known
+     *
+     *  This property holds a list model with the numTrafficTargets4QML most
+     *  relevant traffic targets.  The model is updated at most once per
+     *  batch of traffic data and is not sorted in any way.  It is owned by
+     *  this class.
+     */
+    Q_PROPERTY(Traffic::TrafficTargetModel* trafficTargets READ trafficTargets CONSTANT)
+
+    /*! \brief Getter method for property with the same name
+     *
+     *  @returns Property trafficTargets
+     */
+    [[nodiscard]] auto trafficTargets() const -> Traffic::TrafficTargetModel*
+    {
+        return m_trafficTargets;
+    }
+
+    /*! \brief Dead reckoning of traffic and own aircraft
+     *
+     *  This object extrapolates the positions of the targets in
+     *  trafficTargets and of the own aircraft at display rate.
      */
-    Q_PROPERTY(QQmlListProperty<Traffic::TrafficFactor_WithPosition> trafficObjects4QML READ trafficObjects4QML CONSTANT)
+    Q_PROPERTY(Traffic::DeadReckoning* deadReckoning READ deadReckoning CONSTANT)
 
     /*! \brief Getter method for property with the same name
      *
-     *  @returns Property trafficObjects4QML
+     *  @returns Property deadReckoning
      */
-    auto trafficObjects4QML() -> QQmlListProperty<Traffic::TrafficFactor_WithPosition>
+    [[nodiscard]] auto deadReckoning() const -> Traffic::DeadReckoning*
     {
-        return {this, &m_trafficObjects};
+        return m_deadReckoning;
     }
 
     /*! \brief Most relevant traffic object whose position is not known
@@ -137,6 +268,26 @@ public:
         return m_trafficObjectWithoutPosition;
     }
 
+    /*! \brief Ingestion statistics of the traffic data sources
+     *
+     *  This property holds a list model with one row per traffic data
+     *  source, in order of preference, as described in
+     *  IngestionStatisticsModel.  The statistics include the rates measured
+     *  over the last update interval.  While the property active of the
+     *  model is set, the model is updated once per second.  The model is
+     *  owned by this class.
+     */
+    Q_PROPERTY(Traffic::IngestionStatisticsModel* ingestionStatistics READ ingestionStatistics CONSTANT)
+
+    /*! \brief Getter function for the property with the same name
+     *
+     *  @returns Property ingestionStatistics
+     */
+    [[nodiscard]] auto ingestionStatistics() const -> Traffic::IngestionStatisticsModel*
+    {
+        return m_ingestionStatistics;
+    }
+
     /*! \brief String describing the current traffic data receiver errors
      *
      *  This property holds a translated, human-readable string that describes
@@ -225,6 +376,9 @@ signals:
     /*! \brief Notifier signal */
     void receivingHeartbeatChanged(bool);
 
+    /*! \brief Notifier signal */
+    void targetCapacityChanged();
+
     /*! \brief Notifier signal */
     void trafficReceiverRuntimeErrorChanged(QString message);
 
@@ -265,19 +419,32 @@ public slots:
 private slots:   
     // Intializations that are moved out of the constructor, in order to avoid
     // nested uses of constructors in Global.
-    void deferredInitialization() const;
+    void deferredInitialization();
 
     // Sends out foreflight broadcast message See
     // https://www.foreflight.com/connect/spec/
     void foreFlightBroadcast();
 
+    // Called if one of the sources has decoded data. Traffic is taken from
+    // all sources, data about the own aircraft only from m_currentSource.
+    void onDataBatch(Traffic::TrafficDataSource_Abstract* source, const Traffic::TrafficDataBatch& batch);
+
+    // Called if one of the sources asks for a password. Looks up the SSID and
+    // the stored password in the main thread and passes them on to the source.
+    void onPasswordLookupRequest(Traffic::TrafficDataSource_Abstract* source);
+
+    // Called if one of the sources reports that a password has been rejected.
+    // Removes the password from the database.
+    void onPasswordRejected(const QString& SSID);
+
+    // Called if one of the sources reports that a password has been accepted.
+    // Emits passwordStorageRequest if the password is not yet in the database.
+    void onPasswordStorageRequest(const QString& SSID, const QString& password);
+
     // Called if one of the sources indicates a heartbeat change
     void onSourceHeartbeatChanged();
 
     // Called if one of the sources reports traffic (position unknown)
-    void onTrafficFactorWithPosition(const Traffic::TrafficFactor_WithPosition& factor);
-
-    // Called if one of the sources reports traffic (position known)
     void onTrafficFactorWithoutPosition(const Traffic::TrafficFactor_DistanceOnly& factor);
 
     // Called if one of the sources reports or clears an error string
@@ -295,28 +462,95 @@ private slots:
     // Setter method
     void setWarning(const Traffic::Warning& warning);
 
+    // Passes the position of the own aircraft on to all sources, to the
+    // conflict predictor and to dead reckoning
+    void updateOwnshipPosition();
+
+    // Samples the ingestion statistics of all sources and updates the
+    // model m_ingestionStatistics
+    void updateIngestionStatistics();
+
+    // Starts or stops m_ingestionStatisticsTimer, depending on whether a
+    // view shows the ingestion statistics
+    void onIngestionStatisticsActiveChanged();
+
     // Updates the property statusString that is inherited from
     // Positioning::PositionInfoSource_Abstract
     void updateStatusString();
 
 private:
+    // Removes outdated entries from m_targets, updates the conflict
+    // predictions and copies the most relevant entries into
+    // m_trafficTargets. Returns true if rows of m_trafficTargets changed.
+    auto publishTargets() -> bool;
+
+    // Calls publishTargets() once the control returns to the event loop.
+    // Several calls within one turn of the event loop, for instance when a
+    // new own position arrives through several signals, result in a single
+    // call to publishTargets(), or none if publishTargets() is called
+    // directly in the meantime.
+    void schedulePublishTargets();
+
+    // Thread for network I/O and decoding
+    QThread m_ioThread;
+
     // UDP Socket for ForeFlight Broadcast messages.
     // See https://www.foreflight.com/connect/spec/
     QNetworkDatagram foreFlightBroadcastDatagram {R"({"App":"Enroute Flight Navigation","GDL90":{"port":4000}})", QHostAddress::Broadcast, 63093};
     QUdpSocket foreFlightBroadcastSocket;
     QTimer foreFlightBroadcastTimer;
 
-    // Targets
-    QList<Traffic::TrafficFactor_WithPosition *> m_trafficObjects;
+    // Targets with known position. The table m_targets holds all targets
+    // that we know of.  The most relevant ones are copied to
+    // m_trafficTargets, for use in QML. Since targets expire even if no new
+    // data comes in, m_targetExpiryTimer triggers publishTargets()
+    // regularly while the table is not empty.
+    Traffic::TrafficTargetTable m_targets;
+    QElapsedTimer m_targetClock;
+    Traffic::TimingWheel::Timer m_targetExpiryTimer;
+    QPointer<Traffic::TrafficTargetModel> m_trafficTargets;
+
+    // Set by schedulePublishTargets(), cleared by publishTargets()
+    bool m_publishTargetsPending {false};
+
+    // Extrapolates the positions of the targets in m_trafficTargets
+    QPointer<Traffic::DeadReckoning> m_deadReckoning;
+
+    // Recent positions of the targets in m_targets, used to estimate climb
+    // and turn rates and to draw trails
+    Traffic::TrackHistory m_trackHistory;
+
+    // Correlates reports from different sources that describe the same
+    // aircraft
+    Traffic::TrafficFusion m_fusion;
+
+    // Predicts closest points of approach for the targets in m_targets.
+    // Predictions are updated whenever targets or own position change.
+    Traffic::ConflictPredictor m_conflictPredictor;
     QPointer<Traffic::TrafficFactor_DistanceOnly> m_trafficObjectWithoutPosition;
 
-    // TrafficData Sources
+    // TrafficData Sources, in order of preference. The current source is the
+    // most preferred source with heartbeat; it provides the data about the
+    // own aircraft and the traffic warnings.
     QList<QPointer<Traffic::TrafficDataSource_Abstract>> m_dataSources;
     QPointer<Traffic::TrafficDataSource_Abstract> m_currentSource;
 
+    // Ingestion statistics. m_ingestionSnapshots holds the last snapshot of
+    // every source in m_dataSources, for computing rates.
+    QTimer m_ingestionStatisticsTimer;
+    QVector<Traffic::IngestionStatistics::Snapshot> m_ingestionSnapshots;
+    QPointer<Traffic::IngestionStatisticsModel> m_ingestionStatistics;
+
+    // Scratch object, used to feed traffic reports from data batches into
+    // the method onTrafficFactorWithoutPosition
+    Traffic::TrafficFactor_DistanceOnly m_incomingFactorDistanceOnly;
+
+    // Latency of reports and warnings, from socket to screen
+    Traffic::TrafficLatency m_latency;
+
     // Property cache
     Traffic::Warning m_Warning;
-    QTimer m_WarningTimer;
+    Traffic::TimingWheel::Timer m_WarningTimer;
     QString m_trafficReceiverRuntimeError {};
     QString m_trafficReceiverSelfTestError {};
 
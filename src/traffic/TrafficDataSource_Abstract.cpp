@@ -18,8 +18,6 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
-#include <QQmlEngine>
-
 #include "traffic/TrafficDataSource_Abstract.h"
 
 
@@ -27,19 +25,72 @@
 
 Traffic::TrafficDataSource_Abstract::TrafficDataSource_Abstract(QObject *parent) : QObject(parent) {
 
-    QQmlEngine::setObjectOwnership(&m_factor, QQmlEngine::CppOwnership);
-
     // Setup heartbeat timer
-    m_heartbeatTimer.setSingleShot(true);
     m_heartbeatTimer.setInterval(5s);
-    connect(&m_heartbeatTimer, &QTimer::timeout, this, &Traffic::TrafficDataSource_Abstract::resetReceivingHeartbeat);
+    m_heartbeatTimer.callOnTimeout([this]() { resetReceivingHeartbeat(); });
 
     // Setup other times
     m_pressureAltitudeTimer.setInterval(5s);
-    m_pressureAltitudeTimer.setSingleShot(true);
     m_trueAltitudeTimer.setInterval(5s);
-    m_trueAltitudeTimer.setSingleShot(true);
 
+    // Setup batch timer
+    m_batchTimer.setInterval(batchInterval);
+    m_batchTimer.setSingleShot(true);
+    connect(&m_batchTimer, &QTimer::timeout, this, &Traffic::TrafficDataSource_Abstract::flushBatch);
+
+}
+
+
+void Traffic::TrafficDataSource_Abstract::enqueueFactorWithPosition(const Traffic::TrafficReport& report)
+{
+    m_batch.factorsWithPosition.append(report);
+    m_batch.factorsWithPosition.last().receiveTime = m_receiveTime;
+    scheduleFlush();
+}
+
+
+void Traffic::TrafficDataSource_Abstract::enqueueFactorWithoutPosition(const Traffic::TrafficReport& report)
+{
+    m_batch.factorsWithoutPosition.append(report);
+    m_batch.factorsWithoutPosition.last().receiveTime = m_receiveTime;
+    scheduleFlush();
+}
+
+
+void Traffic::TrafficDataSource_Abstract::enqueuePositionInfo(const Positioning::PositionInfo& positionInfo)
+{
+    m_batch.positionInfo = positionInfo;
+    scheduleFlush();
+}
+
+
+void Traffic::TrafficDataSource_Abstract::enqueuePressureAltitude(Units::Distance pressureAltitude)
+{
+    m_batch.pressureAltitude = pressureAltitude;
+    scheduleFlush();
+}
+
+
+void Traffic::TrafficDataSource_Abstract::flushBatch()
+{
+    if (m_batch.isEmpty()) {
+        return;
+    }
+    emit dataBatchReady(m_batch);
+
+    // Reset the batch, but keep the allocated memory
+    m_batch.positionInfo = {};
+    m_batch.pressureAltitude = {};
+    m_batch.factorsWithPosition.clear();
+    m_batch.factorsWithoutPosition.clear();
+}
+
+
+void Traffic::TrafficDataSource_Abstract::scheduleFlush()
+{
+    if (!m_batchTimer.isActive()) {
+        m_batchTimer.start();
+    }
 }
 
 
@@ -49,7 +100,10 @@ void Traffic::TrafficDataSource_Abstract::setConnectivityStatus(const QString& n
         return;
     }
 
-    m_connectivityStatus = newConnectivityStatus;
+    {
+        QMutexLocker locker(&m_propertyMutex);
+        m_connectivityStatus = newConnectivityStatus;
+    }
     emit connectivityStatusChanged(m_connectivityStatus);
 }
 
@@ -60,7 +114,10 @@ void Traffic::TrafficDataSource_Abstract::setErrorString(const QString& newError
         return;
     }
 
-    m_errorString = newErrorString;
+    {
+        QMutexLocker locker(&m_propertyMutex);
+        m_errorString = newErrorString;
+    }
     emit errorStringChanged(m_errorString);
 }
 
@@ -81,6 +138,30 @@ void Traffic::TrafficDataSource_Abstract::setReceivingHeartbeat(bool newReceivin
 }
 
 
+void Traffic::TrafficDataSource_Abstract::setOwnshipPosition(const Positioning::PositionInfo& positionInfo, const QGeoCoordinate& lastValidCoordinate)
+{
+    m_ownshipPositionInfo = positionInfo;
+    m_ownshipLastValidCoordinate = lastValidCoordinate;
+    if (m_ownshipTangentPlane.origin() != lastValidCoordinate) {
+        m_ownshipTangentPlane = Positioning::LocalTangentPlane(lastValidCoordinate);
+    }
+}
+
+
+void Traffic::TrafficDataSource_Abstract::startCapture(const QString& fileName)
+{
+    if (!m_captureWriter.open(fileName)) {
+        setErrorString( tr("Cannot write capture file %1: %2").arg(fileName, m_captureWriter.errorString()) );
+    }
+}
+
+
+void Traffic::TrafficDataSource_Abstract::stopCapture()
+{
+    m_captureWriter.close();
+}
+
+
 void Traffic::TrafficDataSource_Abstract::resetReceivingHeartbeat()
 {
     setReceivingHeartbeat(false);
@@ -93,7 +174,10 @@ void Traffic::TrafficDataSource_Abstract::setTrafficReceiverRuntimeError(const Q
         return;
     }
 
-    m_trafficReceiverRuntimeError = newErrorString;
+    {
+        QMutexLocker locker(&m_propertyMutex);
+        m_trafficReceiverRuntimeError = newErrorString;
+    }
     emit trafficReceiverRuntimeErrorChanged(newErrorString);
 }
 
@@ -104,6 +188,9 @@ void Traffic::TrafficDataSource_Abstract::setTrafficReceiverSelfTestError(const
         return;
     }
 
-    m_trafficReceiverSelfTestError = newErrorString;
+    {
+        QMutexLocker locker(&m_propertyMutex);
+        m_trafficReceiverSelfTestError = newErrorString;
+    }
     emit trafficReceiverSelfTestErrorChanged(newErrorString);
 }
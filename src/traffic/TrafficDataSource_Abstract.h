@@ -20,9 +20,18 @@
 
 #pragma once
 
+#include <QMutex>
+#include <QTimer>
+#include <atomic>
+#include <chrono>
+
+#include "positioning/LocalTangentPlane.h"
 #include "positioning/PositionInfo.h"
-#include "traffic/TrafficFactor_DistanceOnly.h"
-#include "traffic/TrafficFactor_WithPosition.h"
+#include "traffic/GDL90.h"
+#include "traffic/IngestionStatistics.h"
+#include "traffic/TimingWheel.h"
+#include "traffic/TrafficCapture.h"
+#include "traffic/TrafficDataBatch.h"
 #include "traffic/Warning.h"
 
 
@@ -32,9 +41,17 @@ namespace Traffic {
  *
  *  This is an abstract base class for all classes that connect to a traffic
  *  receiver.  In addition to the properties listed below, the class also emits
- *  imporant data via the signals barometricAltitudeUpdated,
- *  factorWithoutPosition, factorWithPosition and warning. It contains methods
- *  to interpret FLARM and GDL90 data streams.
+ *  imporant data via the signals dataBatchReady and warning. It contains
+ *  methods to interpret FLARM and GDL90 data streams.
+ *
+ *  Decoded position, pressure altitude and traffic data is collected in a
+ *  TrafficDataBatch that is emitted at most once per batchInterval.  Traffic
+ *  warnings are time-critical and are emitted immediately.
+ *
+ *  Sources that talk to the network live in the traffic I/O thread of the
+ *  TrafficDataProvider.  Consumers in other threads must therefore use queued
+ *  connections or QMetaObject::invokeMethod to call slots.  The property
+ *  getters can be called from any thread.
  */
 class TrafficDataSource_Abstract : public QObject {
     Q_OBJECT
@@ -49,6 +66,12 @@ public:
     // Standard destructor
     ~TrafficDataSource_Abstract() override = default;
 
+    /*! \brief Maximal time that decoded data is held back before it is emitted
+     *
+     *  This is roughly the duration of one display frame.
+     */
+    static constexpr std::chrono::milliseconds batchInterval {16};
+
     //
     // Properties
     //
@@ -67,6 +90,7 @@ public:
      */
     auto errorString() -> QString
     {
+        QMutexLocker locker(&m_propertyMutex);
         return m_errorString;
     }
 
@@ -89,6 +113,7 @@ public:
      */
     [[nodiscard]] auto connectivityStatus() const -> QString
     {
+        QMutexLocker locker(&m_propertyMutex);
         return m_connectivityStatus;
     }
 
@@ -110,7 +135,7 @@ public:
      */
     auto receivingHeartbeat() -> bool
     {
-        return m_heartbeatTimer.isActive();
+        return m_hasHeartbeat;
     }
 
     /*! \brief Source name
@@ -142,6 +167,7 @@ public:
      */
     auto trafficReceiverRuntimeError() -> QString
     {
+        QMutexLocker locker(&m_propertyMutex);
         return m_trafficReceiverRuntimeError;
     }
 
@@ -160,9 +186,22 @@ public:
      */
     auto trafficReceiverSelfTestError() -> QString
     {
+        QMutexLocker locker(&m_propertyMutex);
         return m_trafficReceiverSelfTestError;
     }
 
+    /*! \brief Health and throughput counters
+     *
+     *  The counters are updated by the decoders.  They are lock-free and can
+     *  be read from any thread.
+     *
+     *  @returns Counters of this source
+     */
+    [[nodiscard]] auto ingestionStatistics() const -> const Traffic::IngestionStatistics&
+    {
+        return m_ingestionStatistics;
+    }
+
 signals:
     /*! \brief Notifier signal */
     void connectivityStatusChanged(QString newStatus);
@@ -170,28 +209,42 @@ signals:
     /*! \brief Notifier signal */
     void errorStringChanged(QString newError);
 
-    /*! \brief Traffic factor without position
+    /*! \brief Decoded data
      *
-     *  This signal is emitted when the traffic receiver informs this class
-     *  about traffic whose position is not known.
+     *  This signal is emitted at most once per batchInterval, whenever the
+     *  traffic receiver has sent position, pressure altitude or traffic
+     *  information.  Pressure altitude is the altitude shown by your
+     *  altimeter if the altimeter is set to 1013.2 hPa.
      *
-     *  \param factor Traffic factor.
+     *  \param batch Data decoded since the last emission
      */
-    void factorWithoutPosition(const Traffic::TrafficFactor_DistanceOnly &factor);
+    void dataBatchReady(const Traffic::TrafficDataBatch& batch);
 
-    /*! \brief Traffic factor with position
+    /* \brief Password lookup request
      *
-     *  This signal is emitted when the traffic receiver informs this class
-     *  about traffic whose position is known.
+     *  This signal is emitted whenever the traffic receiver asks for a
+     *  password. Sources might live in a thread other than the main thread,
+     *  and must not touch the password database or the platform adaptor. The
+     *  TrafficDataProvider therefore looks up the SSID and the stored password
+     *  in the main thread and answers by calling answerPasswordLookup().
+     */
+    void passwordLookupRequest();
+
+    /* \brief Password rejected
+     *
+     *  This signal is emitted whenever the traffic receiver has rejected a
+     *  password. The TrafficDataProvider removes the password from the
+     *  database.
      *
-     *  \param factor Traffic factor.
+     *  @param SSID Name of the WiFi network that is was used in use.
      */
-    void factorWithPosition(const Traffic::TrafficFactor_WithPosition& factor);
+    void passwordRejected(const QString& SSID);
 
     /* \brief Password request
      *
      *  This signal is emitted whenever the traffic receiver asks for a
-     *  password. Note that this is not the WiFi-Password.
+     *  password and no password is stored in the database. Note that this is
+     *  not the WiFi-Password.
      *
      *  @param SSID Name of the WiFi network that is currently in use.
      */
@@ -200,28 +253,13 @@ signals:
     /* \brief Password storage request
      *
      *  This signal is emitted whenever the traffic receiver has successfully
-     *  connected using a password that was not yet in the database.
+     *  connected using a password. The TrafficDataProvider passes the request
+     *  on only if the password is not yet in the database.
      *
      *  @param SSID Name of the WiFi network that is was used in use.
      */
     void passwordStorageRequest(const QString& SSID, const QString& password);
 
-    /*! \brief Pressure altitude
-     *
-     *  If this class received pressure altitude information from a connected
-     *  traffic receiver, this information is emitted here. Pressure altitude is
-     *  the altitude shown by your altimeter if the altimeter is set to 1013.2
-     *  hPa.
-     */
-    void pressureAltitudeUpdated(Units::Distance);
-
-    /*! \brief Position info
-     *
-     *  If this class received position information from a connected traffic
-     *  receiver, this information is emitted here.
-     */
-    void positionUpdated(Positioning::PositionInfo pInfo);
-
     /*! \brief Notifier signal */
     void receivingHeartbeatChanged(bool);
 
@@ -263,13 +301,26 @@ signals:
      *  This signal is emitted when the traffic receiver issues a traffic
      *  warning. An invalid warning (i.e. a warning with alarm level = -1) is
      *  emitted to indicate that the last warning is no longer active and should
-     *  be disregarded.
+     *  be disregarded.  Warnings are not batched.
      *
      *  \param warning Traffic warning.
      */
     void warning(const Traffic::Warning& warning);
 
 public slots:
+    /*! \brief Set position of own aircraft
+     *
+     *  The decoders need the position of the own aircraft to compute the
+     *  position of traffic. Because sources might live in a different thread,
+     *  they do not query the PositionProvider directly. Instead, the
+     *  TrafficDataProvider uses this slot to keep the sources informed.
+     *
+     *  @param positionInfo Current position of the own aircraft
+     *
+     *  @param lastValidCoordinate Last valid coordinate of the own aircraft
+     */
+    void setOwnshipPosition(const Positioning::PositionInfo& positionInfo, const QGeoCoordinate& lastValidCoordinate);
+
     /*! \brief Start attempt to connect to traffic receiver
      *
      *  If this class is connected to a traffic receiver, this method does
@@ -301,6 +352,42 @@ public slots:
         Q_UNUSED(password)
     }
 
+    /*! \brief Answer password lookup request
+     *
+     *  The TrafficDataProvider calls this method in response to the signal
+     *  passwordLookupRequest(). If the implementation of the traffic data
+     *  source supports passwords, it sends the stored password to the traffic
+     *  data receiver or, if no password is stored, emits passwordRequest(). If
+     *  the implementation does not support passwords, this method does
+     *  nothing.
+     *
+     *  @param SSID Name of the WiFi network that is currently in use.
+     *
+     *  @param storedPassword Password stored in the database for this SSID,
+     *  or an empty string if there is none
+     */
+    virtual void answerPasswordLookup(const QString& SSID, const QString& storedPassword)
+    {
+        Q_UNUSED(SSID)
+        Q_UNUSED(storedPassword)
+    }
+
+    /*! \brief Start recording raw data
+     *
+     *  From now on, the source writes all data it receives from the traffic
+     *  receiver, as received, into a capture file. Sources that do not read
+     *  from the network do not record anything. Because sources might live
+     *  in a different thread, this slot should be invoked with a queued
+     *  connection.
+     *
+     *  @param fileName Name of the capture file. Existing files are
+     *  overwritten.
+     */
+    void startCapture(const QString& fileName);
+
+    /*! \brief Stop recording raw data */
+    void stopCapture();
+
 protected:
     /*! \brief Process one FLARM/NMEA sentence
      *
@@ -310,20 +397,23 @@ protected:
      *  interprets the string and updates the properties and emits signals as
      *  appropriate. Invalid strings are silently ignored.
      *
-     *  @param sentence A QString containing a FLARM/NMEA sentence.
+     *  The sentence is tokenized in place by Traffic::NMEASentence, so that
+     *  no memory is allocated for the common message types.
+     *
+     *  @param data Latin1-encoded FLARM/NMEA sentence.
      */
-    void processFLARMSentence(QString sentence);
+    void processFLARMSentence(QByteArrayView data);
 
-    /*! \brief Process one GDL90 message
+    /*! \brief Process GDL90 data
      *
-     *  This method expects exactly one GDL90 message, including starting and
-     *  trailing 0x7e bytes.  The method interprets the string and updates the
-     *  properties and emits signals as appropriate. Invalid messages are
-     *  silently ignored.
+     *  This method expects a datagram containing one or more GDL90 messages,
+     *  each delimited by 0x7e bytes.  The method interprets the messages and
+     *  updates the properties and emits signals as appropriate. Invalid
+     *  messages are silently ignored.
      *
-     *  @param message A QByteArray containing a GDL90 message.
+     *  @param data GDL90 data
      */
-    void processGDLMessage(const QByteArray& message);
+    void processGDLDatagram(QByteArrayView data);
 
     /*! \brief Process one XGPS string
      *
@@ -334,9 +424,95 @@ protected:
      *  The method interprets the string and updates the properties and emits
      *  signals as appropriate. Invalid messages are silently ignored.
      *
-     *  @param data A QByteArray containing an XGPS string.
+     *  @param data An XGPS string.
+     */
+    void processXGPSString(QByteArrayView data);
+
+    /*! \brief Record raw data
+     *
+     *  Implementations call this method with all data received from the
+     *  traffic receiver, before decoding. Nothing happens unless
+     *  startCapture() has been called.
+     *
+     *  @param channel Kind of data
+     *
+     *  @param data Data, as received
      */
-    void processXGPSString(const QByteArray& data);
+    void capture(Traffic::TrafficCapture::Channel channel, QByteArrayView data)
+    {
+        if (m_captureWriter.isOpen()) {
+            m_captureWriter.write(channel, data);
+        }
+    }
+
+    /*! \brief Report the counters of a duplicate filter
+     *
+     *  Implementations that drop duplicate datagrams call this method in
+     *  their constructor, so that the datagrams and duplicates counted by the
+     *  filter appear in ingestionStatistics().
+     *
+     *  @param filter Filter, which must outlive this object
+     */
+    void setDatagramFilter(const Traffic::DatagramFilter& filter)
+    {
+        m_ingestionStatistics.setDatagramFilter(&filter);
+    }
+
+    /*! \brief Add traffic report with position to the current batch
+     *
+     *  The report is stamped with the time set by stampReceiveTime().
+     *
+     *  @param report Traffic report
+     */
+    void enqueueFactorWithPosition(const Traffic::TrafficReport& report);
+
+    /*! \brief Add traffic report without position to the current batch
+     *
+     *  The report is stamped with the time set by stampReceiveTime().
+     *
+     *  @param report Traffic report
+     */
+    void enqueueFactorWithoutPosition(const Traffic::TrafficReport& report);
+
+    /*! \brief Set position of own aircraft in the current batch
+     *
+     *  @param positionInfo Position of own aircraft
+     */
+    void enqueuePositionInfo(const Positioning::PositionInfo& positionInfo);
+
+    /*! \brief Set pressure altitude of own aircraft in the current batch
+     *
+     *  @param pressureAltitude Pressure altitude of own aircraft
+     */
+    void enqueuePressureAltitude(Units::Distance pressureAltitude);
+
+    /*! \brief Last valid coordinate of own aircraft
+     *
+     *  @returns Coordinate, as set with setOwnshipPosition()
+     */
+    [[nodiscard]] auto ownshipLastValidCoordinate() const -> QGeoCoordinate
+    {
+        return m_ownshipLastValidCoordinate;
+    }
+
+    /*! \brief Current position of own aircraft
+     *
+     *  @returns Position, as set with setOwnshipPosition()
+     */
+    [[nodiscard]] auto ownshipPositionInfo() const -> Positioning::PositionInfo
+    {
+        return m_ownshipPositionInfo;
+    }
+
+    /*! \brief Local tangent plane at own aircraft
+     *
+     *  @returns Tangent plane anchored at ownshipLastValidCoordinate(),
+     *  updated by setOwnshipPosition()
+     */
+    [[nodiscard]] auto ownshipTangentPlane() const -> const Positioning::LocalTangentPlane&
+    {
+        return m_ownshipTangentPlane;
+    }
 
     /*! \brief Resetter method for the property with the same name
      *
@@ -344,6 +520,18 @@ protected:
      */
     void resetReceivingHeartbeat();
 
+    /*! \brief Stamp data with the current time
+     *
+     *  Implementations call this method whenever they read data from the
+     *  socket, before the data is processed.  Traffic reports and warnings
+     *  decoded from the data carry the time stamp, so that the
+     *  TrafficDataProvider can measure latency.
+     */
+    void stampReceiveTime()
+    {
+        m_receiveTime = Traffic::IngestionStatistics::now();
+    }
+
     /*! \brief Setter function for the property with the same name
      *
      *  @param newConnectivityStatus Property connectivityStatus
@@ -377,7 +565,39 @@ protected:
      */
     void setTrafficReceiverSelfTestError(const QString& newErrorString);
 
+private slots:
+    // Emits dataBatchReady and clears m_batch
+    void flushBatch();
+
 private:
+    // Starts m_batchTimer, unless it is already running
+    void scheduleFlush();
+
+    // Handlers for GDL90 messages, one for each supported message ID
+    using GDLHandler = void (TrafficDataSource_Abstract::*)(const Traffic::GDL90::Frame&);
+    static auto gdlHandler(quint8 messageID) -> GDLHandler;
+    void onGDLHeartbeat(const Traffic::GDL90::Frame& frame);
+    void onGDLOwnshipReport(const Traffic::GDL90::Frame& frame);
+    void onGDLOwnshipGeometricAltitude(const Traffic::GDL90::Frame& frame);
+    void onGDLTrafficReport(const Traffic::GDL90::Frame& frame);
+
+    // Splits GDL90 data into messages
+    Traffic::GDL90::Deframer m_gdl90Deframer;
+
+    // Records raw data, if capturing
+    Traffic::TrafficCapture::Writer m_captureWriter;
+
+    // Health and throughput counters
+    Traffic::IngestionStatistics m_ingestionStatistics;
+
+    // Time at which the data currently processed was read, see
+    // stampReceiveTime()
+    qint64 m_receiveTime {0};
+
+    // Protects the property caches, so that getters can be called from other
+    // threads
+    mutable QMutex m_propertyMutex;
+
     // Property caches
     QString m_connectivityStatus {};
     QString m_errorString {};
@@ -392,20 +612,26 @@ private:
     // timer should be stopped.
     Units::Distance m_trueAltitude;
     Units::Distance m_trueAltitudeFOM; // Fig. of Merit
-    QTimer m_trueAltitudeTimer;
+    Traffic::TimingWheel::Timer m_trueAltitudeTimer;
 
     // Pressure altitude of own aircraft. See the member m_trueAltitude for a
     // description how the timer should be used.
     Units::Distance m_pressureAltitude;
-    QTimer m_pressureAltitudeTimer;
+    Traffic::TimingWheel::Timer m_pressureAltitudeTimer;
 
     // Heartbeat timer
-    QTimer m_heartbeatTimer;
-    bool m_hasHeartbeat {false};
-
-    // Targets
-    Traffic::TrafficFactor_WithPosition m_factor;
-    Traffic::TrafficFactor_DistanceOnly m_factorDistanceOnly;
+    Traffic::TimingWheel::Timer m_heartbeatTimer;
+    std::atomic<bool> m_hasHeartbeat {false};
+
+    // Data collected since the last emission of dataBatchReady, and timer
+    // that triggers the emission
+    Traffic::TrafficDataBatch m_batch;
+    QTimer m_batchTimer;
+
+    // Position of own aircraft, as set by setOwnshipPosition()
+    Positioning::PositionInfo m_ownshipPositionInfo;
+    QGeoCoordinate m_ownshipLastValidCoordinate;
+    Positioning::LocalTangentPlane m_ownshipTangentPlane;
 };
 
 } // namespace Traffic
@@ -18,6 +18,8 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <QCoreApplication>
+
 #include "GlobalObject.h"
 #include "platform/PlatformAdaptor_Abstract.h"
 #include "traffic/TrafficDataSource_AbstractSocket.h"
@@ -28,8 +30,9 @@
 Traffic::TrafficDataSource_AbstractSocket::TrafficDataSource_AbstractSocket(QObject *parent) :
     Traffic::TrafficDataSource_Abstract(parent) {
 
-    // Connect WiFi locker/unlocker
-    connect(this, &Traffic::TrafficDataSource_Abstract::receivingHeartbeatChanged, this, &Traffic::TrafficDataSource_AbstractSocket::onReceivingHeartbeatChanged);
+    // Connect WiFi locker/unlocker. The platform adaptor lives in the main
+    // thread, so we use the application object as the context.
+    connect(this, &Traffic::TrafficDataSource_Abstract::receivingHeartbeatChanged, QCoreApplication::instance(), &Traffic::TrafficDataSource_AbstractSocket::onReceivingHeartbeatChanged);
 
 }
 
@@ -20,103 +20,105 @@
 
 #include "GlobalObject.h"
 #include "platform/PlatformAdaptor_Abstract.h"
-#include "positioning/PositionProvider.h"
 #include "traffic/FlarmnetDB.h"
+#include "traffic/NMEASentence.h"
 #include "traffic/TrafficDataSource_Abstract.h"
 
 
 // Static Helper functions
 
-auto interpretNMEALatLong(const QString& A, const QString& B) -> qreal
+// Checks if the argument is a valid NMEA time of the form hhmmss(.sss)
+auto isValidNMEATime(QByteArrayView timeString) -> bool
 {
-    bool ok1 = false;
-    bool ok2 = false;
-    qreal result = A.left(2).toDouble(&ok1) + A.mid(2).toDouble(&ok2)/60.0;
-    if (!ok1 || !ok2) {
-        return qQNaN();
+    if (timeString.size() < 6) {
+        return false;
     }
-
-    if ((B == u"S") || (B == u"W")) {
-        result *= -1.0;
-    }
-    return result;
+    bool okHH = false;
+    bool okMM = false;
+    bool okSS = false;
+    auto HH = Traffic::NMEASentence::parseInt(timeString.sliced(0, 2), &okHH);
+    auto MM = Traffic::NMEASentence::parseInt(timeString.sliced(2, 2), &okMM);
+    auto SS = Traffic::NMEASentence::parseInt(timeString.sliced(4, 2), &okSS);
+    return okHH && okMM && okSS && QTime::isValid(HH, MM, SS);
 }
 
-auto interpretNMEATime(const QString& timeString) -> QDateTime
+// Translates the FLARM aircraft type field into an AircraftType
+auto interpretFLARMAircraftType(QByteArrayView targetType) -> Traffic::TrafficFactor_Abstract::AircraftType
 {
-    auto HH = timeString.mid(0,2);
-    auto MM = timeString.mid(2,2);
-    auto SS = timeString.mid(4,2);
-    auto MS = timeString.mid(6);
-    QTime time(HH.toInt(), MM.toInt(), SS.toInt());
-    if (MS.isEmpty()) {
-        time = time.addMSecs(qRound(MS.toDouble()*1000.0));
+    if (targetType.size() != 1) {
+        return Traffic::TrafficFactor_Abstract::unknown;
+    }
+
+    switch(targetType[0]) {
+    case '1':
+        return Traffic::TrafficFactor_Abstract::Glider;
+    case '2':
+        return Traffic::TrafficFactor_Abstract::TowPlane;
+    case '3':
+        return Traffic::TrafficFactor_Abstract::Copter;
+    case '4':
+        return Traffic::TrafficFactor_Abstract::Skydiver;
+    case '5':
+        return Traffic::TrafficFactor_Abstract::Aircraft;
+    case '6':
+        return Traffic::TrafficFactor_Abstract::HangGlider;
+    case '7':
+        return Traffic::TrafficFactor_Abstract::Paraglider;
+    case '8':
+        return Traffic::TrafficFactor_Abstract::Aircraft;
+    case '9':
+        return Traffic::TrafficFactor_Abstract::Jet;
+    case 'B':
+        return Traffic::TrafficFactor_Abstract::Balloon;
+    case 'C':
+        return Traffic::TrafficFactor_Abstract::Airship;
+    case 'D':
+        return Traffic::TrafficFactor_Abstract::Drone;
+    case 'F':
+        return Traffic::TrafficFactor_Abstract::StaticObstacle;
+    default:
+        return Traffic::TrafficFactor_Abstract::unknown;
     }
-    auto dateTime = QDateTime::currentDateTimeUtc();
-    dateTime.setTime(time);
-    return dateTime;
 }
 
 
 // Member functions
 
-void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
+void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QByteArrayView data)
 {
-    if (sentence.isEmpty()) {
-        return;
-    }
-
-    // Check that line starts with a dollar sign
-    if (sentence.isEmpty()) {
-        return;
-    }
-    if (sentence[0] != QStringLiteral("$")) {
+    const Traffic::IngestionStatistics::ParseTimer parseTimer(m_ingestionStatistics);
+    m_ingestionStatistics.addBytes(data.size());
+
+    // Tokenize the sentence and check the NMEA checksum. This does not copy
+    // any data; the fields are views into data.
+    Traffic::NMEASentence sentence(data);
+    if (!sentence.isValid()) {
+        m_ingestionStatistics.addChecksumErrors();
         return;
     }
-    sentence = sentence.mid(1);
+    m_ingestionStatistics.addMessage();
 
-    // Check the NMEA checksum
-    auto pieces = sentence.split(QStringLiteral("*"));
-    if (pieces.length() != 2) {
-        return;
-    }
-    sentence = pieces[0];
-    auto checksum = pieces[1].toInt(nullptr, 16);
-    quint8 myChecksum = 0;
-    for(auto && i : sentence) {
-        myChecksum ^= static_cast<quint8>(i.toLatin1());
-    }
-    if (checksum != myChecksum) {
-        return;
-    }
-
-    // Split the message into pieces
-    auto arguments = sentence.split(QStringLiteral(","));
-    if (arguments.isEmpty()) {
-        return;
-    }
-    auto messageType = arguments.takeFirst();
+    switch(sentence.tag()) {
 
     // NMEA GPS 3D-fix data
-    if (messageType == u"GPGGA") {
-        if (arguments.length() < 9) {
+    case Traffic::NMEASentence::packTag("GPGGA"): {
+        if (sentence.size() < 9) {
             return;
         }
 
         // Quality check
-        if (arguments[5] == u"0") {
+        if (sentence.fieldEquals(5, "0")) {
             return;
         }
 
         // Get Time
-        auto dateTime = interpretNMEATime(arguments[0]);
-        if (!dateTime.isValid()) {
+        if (!isValidNMEATime(sentence[0])) {
             return;
         }
 
         // Get coordinate
         bool ok = false;
-        auto alt = arguments[8].toDouble(&ok);
+        auto alt = sentence.toDouble(8, &ok);
         if (!ok) {
             m_trueAltitude = {};
             m_trueAltitudeFOM = {};
@@ -131,41 +133,27 @@ void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
     }
 
     // Recommended minimum specific GPS/Transit data
-    if (messageType == u"GPRMC") {
-        if (arguments.length() < 8) {
+    case Traffic::NMEASentence::packTag("GPRMC"): {
+        if (sentence.size() < 8) {
             return;
         }
 
         // Quality check
-        if (arguments[1] != u"A") {
+        if (!sentence.fieldEquals(1, "A")) {
             return;
         }
 
         // Get Time
-        auto dateTime = interpretNMEATime(arguments[0]);
-        if (!dateTime.isValid()) {
+        if (!isValidNMEATime(sentence[0])) {
             return;
         }
 
         // Get coordinate
-        bool ok1 = false;
-        bool ok2 = false;
-        auto lat = arguments[2].left(2).toDouble(&ok1) + arguments[2].mid(2).toDouble(&ok2)/60.0;
-        if (!ok1 || !ok2) {
+        auto lat = sentence.toLatLong(2, 2);
+        auto lon = sentence.toLatLong(4, 3);
+        if (!qIsFinite(lat) || !qIsFinite(lon)) {
             return;
         }
-        if (arguments[3] == u"S") {
-            lat *= -1.0;
-        }
-
-        auto lon = arguments[4].left(3).toDouble(&ok1) + arguments[4].mid(3).toDouble(&ok2)/60.0;
-        if (!ok1 || !ok2) {
-            return;
-        }
-        if (arguments[5] == u"W") {
-            lon *= -1.0;
-        }
-
         QGeoCoordinate coordinate(lat, lon);
         if (!coordinate.isValid()) {
             return;
@@ -176,30 +164,26 @@ void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
         QGeoPositionInfo pInfo(coordinate, QDateTime::currentDateTimeUtc());
 
         // Ground speed
-        bool ok = false;
-        auto groundSpeed = Units::Speed::fromKN(arguments[6].toDouble(&ok));
-        if (!ok) {
-            groundSpeed = Units::Speed::fromKN(qQNaN());
-        }
+        auto groundSpeed = Units::Speed::fromKN(sentence.toDouble(6));
         if (groundSpeed.isFinite()) {
             pInfo.setAttribute(QGeoPositionInfo::GroundSpeed, groundSpeed.toMPS() );
         }
 
         // Track
-        auto TT = arguments[7].toDouble(&ok);
-        if (!ok) {
-            TT = qQNaN();
-        }
-        if (TT != qQNaN()) {
+        auto TT = sentence.toDouble(7);
+        if (qIsFinite(TT)) {
             pInfo.setAttribute(QGeoPositionInfo::Direction, TT );
         }
 
-        emit positionUpdated( Positioning::PositionInfo(pInfo));
+        enqueuePositionInfo( Positioning::PositionInfo(pInfo) );
         return;
     }
 
     // Data on other proximate aircraft
-    if (messageType == u"PFLAA") {
+    case Traffic::NMEASentence::packTag("PFLAA"): {
+        if (sentence.size() < 11) {
+            return;
+        }
 
         // Helper variable
         bool ok = false;
@@ -209,7 +193,7 @@ void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
         //
 
         // Alarm level is mandatory
-        auto alarmLevel = arguments[0].toInt(&ok);
+        auto alarmLevel = sentence.toInt(0, &ok);
         if (!ok) {
             return;
         }
@@ -219,101 +203,40 @@ void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
 
         // Relative vertical information is optional
         // Vertical distance is optional
-        auto vDist = Units::Distance::fromM(arguments[3].toDouble(&ok));
-        if (!ok) {
-            vDist = Units::Distance::fromM(qQNaN());
-        }
+        auto vDist = Units::Distance::fromM(sentence.toDouble(3));
 
         // Target type is optional
-        Traffic::TrafficFactor_Abstract::AircraftType type = Traffic::TrafficFactor_Abstract::unknown;
-        {
-            auto targetType = arguments[10];
-            if (targetType == u"1") {
-                type = Traffic::TrafficFactor_Abstract::Glider;
-            }
-            if (targetType == u"2") {
-                type = Traffic::TrafficFactor_Abstract::TowPlane;
-            }
-            if (targetType == u"3") {
-                type = Traffic::TrafficFactor_Abstract::Copter;
-            }
-            if (targetType == u"4") {
-                type = Traffic::TrafficFactor_Abstract::Skydiver;
-            }
-            if (targetType == u"5") {
-                type = Traffic::TrafficFactor_Abstract::Aircraft;
-            }
-            if (targetType == u"6") {
-                type = Traffic::TrafficFactor_Abstract::HangGlider;
-            }
-            if (targetType == u"7") {
-                type = Traffic::TrafficFactor_Abstract::Paraglider;
-            }
-            if (targetType == u"8") {
-                type = Traffic::TrafficFactor_Abstract::Aircraft;
-            }
-            if (targetType == u"9") {
-                type = Traffic::TrafficFactor_Abstract::Jet;
-            }
-            if (targetType == u"B") {
-                type = Traffic::TrafficFactor_Abstract::Balloon;
-            }
-            if (targetType == u"C") {
-                type = Traffic::TrafficFactor_Abstract::Airship;
-            }
-            if (targetType == u"D") {
-                type = Traffic::TrafficFactor_Abstract::Drone;
-            }
-            if (targetType == u"F") {
-                type = Traffic::TrafficFactor_Abstract::StaticObstacle;
-            }
-        }
+        auto type = interpretFLARMAircraftType(sentence[10]);
 
         // Ground speed it optimal. If ground speed is zero that means:
         // target is on the ground. Ignore these targets, unless they are known static obstacles!
-        auto groundSpeedInMPS = arguments[8].toDouble(&ok);
-        if (!ok) {
-            groundSpeedInMPS = qQNaN();
-        }
+        auto groundSpeedInMPS = sentence.toDouble(8);
         if ((groundSpeedInMPS == 0.0) && (type != Traffic::TrafficFactor_Abstract::StaticObstacle)) {
             return;
         }
 
-
         // Target ID is optional
-        auto targetID = arguments[5];
-
+        auto targetID = QString::fromLatin1(sentence[5]);
 
         //
         // Handle non-directional targets
         //
-        if (arguments[2] == u"") {
+        if (sentence[2].isEmpty()) {
             // Horizontal distance is mandatory
-            auto hDist = Units::Distance::fromM(arguments[1].toDouble(&ok));
+            auto hDist = Units::Distance::fromM(sentence.toDouble(1, &ok));
             if (!ok) {
                 return;
             }
 
-            // Construct a PositionInfo object that contains additional information (such as ground speed, if available)
-            QGeoPositionInfo pInfo(QGeoCoordinate(), QDateTime::currentDateTimeUtc());
-            auto targetGS = arguments[8].toDouble(&ok);
-            if (ok) {
-                pInfo.setAttribute(QGeoPositionInfo::GroundSpeed, targetGS);
-            }
-            auto targetVS = arguments[9].toDouble(&ok);
-            if (ok) {
-                pInfo.setAttribute(QGeoPositionInfo::VerticalSpeed, targetVS);
-            }
-
-            m_factorDistanceOnly.setAlarmLevel(alarmLevel);
-            m_factorDistanceOnly.setCallSign( GlobalObject::flarmnetDB()->getRegistration(targetID) );
-            m_factorDistanceOnly.setCoordinate(Positioning::PositionProvider::lastValidCoordinate());
-            m_factorDistanceOnly.setID(targetID);
-            m_factorDistanceOnly.setHDist(hDist);
-            m_factorDistanceOnly.setType(type);
-            m_factorDistanceOnly.setVDist(vDist);
-            m_factorDistanceOnly.startLiveTime();
-            emit factorWithoutPosition(m_factorDistanceOnly);
+            Traffic::TrafficReport report;
+            report.alarmLevel = alarmLevel;
+            report.callSign = GlobalObject::flarmnetDB()->getRegistration(targetID);
+            report.coordinate = ownshipLastValidCoordinate();
+            report.ID = targetID;
+            report.hDist = hDist;
+            report.type = type;
+            report.vDist = vDist;
+            enqueueFactorWithoutPosition(report);
             return;
         }
 
@@ -321,62 +244,59 @@ void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
         // From now on, we assume that we have a directional target
         //
 
-        // As a first step, we obtain the target's coordinate. We take our own coordinate as a starting point.
-        auto targetCoordinate = Positioning::PositionProvider::lastValidCoordinate();
-        if (!targetCoordinate.isValid()) {
+        // As a first step, we obtain the target's coordinate, from the local tangent plane at our own position.
+        const auto& tangentPlane = ownshipTangentPlane();
+        if (!tangentPlane.isValid()) {
             return;
         }
-        auto relativeNorth = arguments[1].toDouble(&ok);
+        auto relativeNorth = sentence.toDouble(1, &ok);
         if (!ok) {
             return;
         }
-        targetCoordinate = targetCoordinate.atDistanceAndAzimuth(relativeNorth, 0);
-        auto relativeEast = arguments[2].toDouble(&ok);
+        auto relativeEast = sentence.toDouble(2, &ok);
         if (!ok) {
             return;
         }
-        targetCoordinate = targetCoordinate.atDistanceAndAzimuth(relativeEast, 90);
-        if (vDist.isFinite()) {
-            targetCoordinate = targetCoordinate.atDistanceAndAzimuth(0, 0, vDist.toM());
-        }
+        // If the vertical distance is unknown, the target is assumed at our own altitude.
+        auto targetCoordinate = tangentPlane.toCoordinate(relativeNorth, relativeEast, vDist.isFinite() ? vDist : Units::Distance::fromM(0.0));
         auto hDist = Units::Distance::fromM(sqrt(relativeNorth*relativeNorth+relativeEast*relativeEast));
 
         // Construct a PositionInfo object that contains additional information (such as ground speed, if available)
         QGeoPositionInfo pInfo(targetCoordinate, QDateTime::currentDateTimeUtc());
-        auto targetTT = arguments[6].toInt(&ok);
+        auto targetTT = sentence.toInt(6, &ok);
         if (ok) {
             pInfo.setAttribute(QGeoPositionInfo::Direction, targetTT);
         }
-        auto targetGS = arguments[8].toDouble(&ok);
-        if (ok) {
-            pInfo.setAttribute(QGeoPositionInfo::GroundSpeed, targetGS);
+        if (qIsFinite(groundSpeedInMPS)) {
+            pInfo.setAttribute(QGeoPositionInfo::GroundSpeed, groundSpeedInMPS);
         }
-        auto targetVS = arguments[9].toDouble(&ok);
+        auto targetVS = sentence.toDouble(9, &ok);
         if (ok) {
             pInfo.setAttribute(QGeoPositionInfo::VerticalSpeed, targetVS);
         }
 
-        // Construct a traffic object
-        m_factor.setAlarmLevel(alarmLevel);
-        m_factor.setCallSign( GlobalObject::flarmnetDB()->getRegistration(targetID) );
-        m_factor.setHDist(hDist);
-        m_factor.setID(targetID);
-        m_factor.setPositionInfo( Positioning::PositionInfo(pInfo) );
-        m_factor.setType(type);
-        m_factor.setVDist(vDist);
-        m_factor.startLiveTime();
-        emit factorWithPosition(m_factor);
+        // Construct a traffic report
+        Traffic::TrafficReport report;
+        report.alarmLevel = alarmLevel;
+        report.callSign = GlobalObject::flarmnetDB()->getRegistration(targetID);
+        report.hDist = hDist;
+        report.ID = targetID;
+        report.positionInfo = Positioning::PositionInfo(pInfo);
+        report.type = type;
+        report.vDist = vDist;
+        enqueueFactorWithPosition(report);
         return;
     }
 
     // Self-test result and errors codes
-    if (messageType == u"PFLAE") {
-        if (arguments.length() < 3) {
+    case Traffic::NMEASentence::packTag("PFLAE"): {
+        if (sentence.size() < 3) {
             return;
         }
 
-        auto severity = arguments[1];
-        auto errorCode = arguments[2];
+        // PFLAE is rare, so we do not mind converting to QString here
+        auto severity = QString::fromLatin1(sentence[1]);
+        auto errorCode = QString::fromLatin1(sentence[2]);
 
         QStringList results;
         if (severity == u"0") {
@@ -522,75 +442,76 @@ void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
     }
 
     // Debug Information -- Ignore
-    if (messageType == u"PFLAS") {
+    case Traffic::NMEASentence::packTag("PFLAS"):
         return;
-    }
 
     // FLARM Heartbeat
-    if (messageType == u"PFLAU") {
+    case Traffic::NMEASentence::packTag("PFLAU"): {
         // Heartbeat received.
         setReceivingHeartbeat(true);
 
-        if (arguments.length() < 9) {
+        if (sentence.size() < 9) {
             return;
         }
 
         // Handle runtime errors
         QStringList results;
-        // auto RX = arguments[0];
-        auto TX = arguments[1];
-        if (TX == QLatin1String("0")) {
+        // RX is field 0
+        if (sentence.fieldEquals(1, "0")) {
             results += tr("No FLARM transmission");
         }
-        auto GPS = arguments[2];
-        if (GPS == QLatin1String("0")) {
+        if (sentence.fieldEquals(2, "0")) {
             results += tr("No GPS reception");
         }
-        auto Power = arguments[3];
-        if (Power == QLatin1String("0")) {
+        if (sentence.fieldEquals(3, "0")) {
             results += tr("Under- or Overvoltage");
         }
         setTrafficReceiverRuntimeError(results.join(QStringLiteral(" • ")));
 
-        auto AlarmLevel = arguments[4];
-        auto RelativeBearing = arguments[5];
-        auto AlarmType = arguments[6];
-        auto RelativeVertical = arguments[7];
-        auto RelativeDistance = arguments[8];
+        bool ok = false;
+        auto alarmLevel = sentence.toInt(4, &ok);
+        if (!ok) {
+            alarmLevel = -1;
+        }
+        auto alarmType = sentence.toInt(6, &ok);
+        if (!ok) {
+            alarmType = -1;
+        }
+        auto relativeBearing = Units::Angle::fromDEG(sentence.toDouble(5));
+        auto vDist = Units::Distance::fromM(sentence.toDouble(7));
+        auto hDist = Units::Distance::fromM(sentence.toDouble(8));
 
-        auto wrning = Traffic::Warning(AlarmLevel, RelativeBearing, AlarmType, RelativeVertical, RelativeDistance);
+        auto wrning = Traffic::Warning(alarmLevel, relativeBearing, alarmType, vDist, hDist);
+        wrning.m_receiveTime = m_receiveTime;
         emit warning(wrning);
-
         return;
     }
 
     // Version information
-    if (messageType == u"PFLAV") {
-        if (arguments.length() < 4) {
+    case Traffic::NMEASentence::packTag("PFLAV"): {
+        if (sentence.size() < 4) {
             return;
         }
 
-        emit trafficReceiverHwVersion(arguments[1]);
-        emit trafficReceiverSwVersion(arguments[2]);
-        emit trafficReceiverObVersion(arguments[3]);
-
-
+        emit trafficReceiverHwVersion(QString::fromLatin1(sentence[1]));
+        emit trafficReceiverSwVersion(QString::fromLatin1(sentence[2]));
+        emit trafficReceiverObVersion(QString::fromLatin1(sentence[3]));
         return;
     }
 
     // Garmin's barometric altitude
-    if (messageType == u"PGRMZ") {
-        if (arguments.length() < 2) {
+    case Traffic::NMEASentence::packTag("PGRMZ"): {
+        if (sentence.size() < 2) {
             return;
         }
 
         // Quality check
-        if (arguments[1] != u"F") {
+        if (!sentence.fieldEquals(1, "F")) {
             return;
         }
 
         bool ok = false;
-        auto barometricAlt = Units::Distance::fromFT(arguments[0].toDouble(&ok));
+        auto barometricAlt = Units::Distance::fromFT(sentence.toDouble(0, &ok));
         if (!ok) {
             return;
         }
@@ -598,7 +519,12 @@ void Traffic::TrafficDataSource_Abstract::processFLARMSentence(QString sentence)
             return;
         }
 
-        emit pressureAltitudeUpdated(barometricAlt);
+        enqueuePressureAltitude(barometricAlt);
+        return;
+    }
+
+    default:
+        m_ingestionStatistics.addUnknownMessage();
         return;
     }
 }
@@ -18,15 +18,20 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
-#include "GlobalObject.h"
-#include "positioning/PositionProvider.h"
 #include "traffic/TrafficDataSource_Abstract.h"
 
 
 // Member functions
 
-void Traffic::TrafficDataSource_Abstract::processXGPSString(const QByteArray& data)
+void Traffic::TrafficDataSource_Abstract::processXGPSString(QByteArrayView data)
 {
+    const Traffic::IngestionStatistics::ParseTimer parseTimer(m_ingestionStatistics);
+    m_ingestionStatistics.addBytes(data.size());
+    if (data.startsWith("XGPS") || data.startsWith("XTRA")) {
+        m_ingestionStatistics.addMessage();
+    } else {
+        m_ingestionStatistics.addUnknownMessage();
+    }
 
     //
     // Handle the various message types
@@ -69,7 +74,7 @@ void Traffic::TrafficDataSource_Abstract::processXGPSString(const QByteArray& da
 
         // Update position information and continue
         if (_geoPos.isValid()) {
-            emit positionUpdated( Positioning::PositionInfo(_geoPos) );
+            enqueuePositionInfo( Positioning::PositionInfo(_geoPos) );
             setReceivingHeartbeat(true);
         }
 
@@ -130,24 +135,21 @@ void Traffic::TrafficDataSource_Abstract::processXGPSString(const QByteArray& da
         // is known.
         Units::Distance hDist {};
         Units::Distance vDist {};
-        auto* positionProviderPtr = GlobalObject::positionProvider();
-        if (positionProviderPtr != nullptr) {
-            auto ownShipCoordinate = positionProviderPtr->positionInfo().coordinate();
-            if (ownShipCoordinate.isValid()) {
-                hDist = Units::Distance::fromM( ownShipCoordinate.distanceTo(trafficCoordinate) );
-                vDist = alt - Units::Distance::fromM(ownShipCoordinate.altitude());
-            }
-        }
-
-        m_factor.setAlarmLevel(0);
-        m_factor.setCallSign(callsign);
-        m_factor.setHDist(hDist);
-        m_factor.setID(targetID);
-        m_factor.setPositionInfo( Positioning::PositionInfo(geoPositionInfo) );
-        m_factor.setType(Traffic::TrafficFactor_Abstract::unknown);
-        m_factor.setVDist(vDist);
-        m_factor.startLiveTime();
-        emit factorWithPosition(m_factor);
+        auto ownShipCoordinate = ownshipPositionInfo().coordinate();
+        if (ownShipCoordinate.isValid()) {
+            hDist = ownshipTangentPlane().distanceTo(trafficCoordinate);
+            vDist = alt - Units::Distance::fromM(ownShipCoordinate.altitude());
+        }
+
+        Traffic::TrafficReport report;
+        report.alarmLevel = 0;
+        report.callSign = callsign;
+        report.hDist = hDist;
+        report.ID = targetID;
+        report.positionInfo = Positioning::PositionInfo(geoPositionInfo);
+        report.type = Traffic::TrafficFactor_Abstract::unknown;
+        report.vDist = vDist;
+        enqueueFactorWithPosition(report);
         return;
     }
 
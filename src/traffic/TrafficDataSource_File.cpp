@@ -20,6 +20,9 @@
 
 #include <QRegExp>
 
+#include <charconv>
+#include <cstring>
+
 #include "traffic/TrafficDataSource_File.h"
 
 
@@ -28,7 +31,10 @@
 Traffic::TrafficDataSource_File::TrafficDataSource_File(const QString& fileName, QObject *parent) :
     TrafficDataSource_Abstract(parent), simulatorFile(fileName) {
 
+    simulatorTimer.setSingleShot(true);
+    simulatorTimer.setTimerType(Qt::PreciseTimer);
     connect(&simulatorTimer, &QTimer::timeout, this, &Traffic::TrafficDataSource_File::readFromSimulatorStream);
+    setDatagramFilter(m_datagramFilter);
 
     // Initially, set properties
     updateProperties();
@@ -48,10 +54,15 @@ void Traffic::TrafficDataSource_File::connectToTrafficReceiver()
     // Open the file
     simulatorFile.unsetError();
     if (simulatorFile.open(QIODevice::ReadOnly)) {
-        simulatorTextStream.setDevice(&simulatorFile);
-        simulatorTextStream.setEncoding(QStringConverter::Latin1);
-        lastPayload = QString();
-        lastTime = 0;
+        // Check format. Simulator files are read from the beginning.
+        m_isCapture = m_captureReader.setDevice(&simulatorFile);
+        if (!m_isCapture) {
+            simulatorFile.seek(0);
+        }
+        m_lineFramer.reset();
+        m_hasRecord = readRecord();
+        m_firstTimestamp = m_record.timestamp;
+        m_replayClock.start();
         readFromSimulatorStream();
     }
 
@@ -91,6 +102,8 @@ auto Traffic::TrafficDataSource_File::containsFLARMSimulationData(const QString&
 void Traffic::TrafficDataSource_File::disconnectFromTrafficReceiver()
 {
     // Stop any simulation that might be running
+    m_captureReader.setDevice(nullptr);
+    m_hasRecord = false;
     simulatorFile.close();
     simulatorTimer.stop();
 
@@ -100,39 +113,97 @@ void Traffic::TrafficDataSource_File::disconnectFromTrafficReceiver()
 }
 
 
-void Traffic::TrafficDataSource_File::readFromSimulatorStream()
+void Traffic::TrafficDataSource_File::processRecord()
 {
-    if ((simulatorFile.error() != QFileDevice::NoError) || simulatorTextStream.atEnd()) {
-        disconnectFromTrafficReceiver();
-        return;
+    stampReceiveTime();
+    switch (m_record.channel) {
+    case Traffic::TrafficCapture::Channel::Sentence:
+        processFLARMSentence(m_record.data);
+        break;
+    case Traffic::TrafficCapture::Channel::TCP: {
+        auto data = m_record.data;
+        while (!data.isEmpty()) {
+            auto buffer = m_lineFramer.writeBuffer();
+            auto size = qMin(data.size(), static_cast<qsizetype>(buffer.size()));
+            memcpy(buffer.data(), data.data(), size);
+            m_lineFramer.commit(size);
+            m_lineFramer.takeLines([this](QByteArrayView line) { processFLARMSentence(line); });
+            data = data.sliced(size);
+        }
+        break;
     }
-
-    if (!lastPayload.isEmpty()) {
-        processFLARMSentence(lastPayload);
+    case Traffic::TrafficCapture::Channel::UDP:
+        // Use the time of reception, so that the replay drops the same
+        // datagrams as the live source, at any replay speed
+        if (m_datagramFilter.isDuplicate(m_record.data, m_record.timestamp/1000)) {
+            break;
+        }
+        if (m_record.data.startsWith("XGPS") || m_record.data.startsWith("XTRA")) {
+            processXGPSString(m_record.data);
+        } else {
+            processGDLDatagram(m_record.data);
+        }
+        break;
     }
+}
 
-    // Read line
-    QString line;
-    if (!simulatorTextStream.readLineInto(&line)) {
-        disconnectFromTrafficReceiver();
-        return;
+
+void Traffic::TrafficDataSource_File::readFromSimulatorStream()
+{
+    int count = 0;
+    while (m_hasRecord) {
+        // Wait until the record is due, or return to the event loop from time
+        // to time when replaying as fast as possible
+        if (m_replaySpeed > 0.0) {
+            auto due = static_cast<qint64>(static_cast<double>(m_record.timestamp-m_firstTimestamp)/(1000.0*m_replaySpeed));
+            auto wait = due - m_replayClock.elapsed();
+            if (wait > 0) {
+                simulatorTimer.start(static_cast<int>(qMin(wait, qint64(60000))));
+                return;
+            }
+        } else if (count == fastReplayChunk) {
+            simulatorTimer.start(0);
+            return;
+        }
+
+        processRecord();
+        count++;
+        m_hasRecord = readRecord();
     }
 
-    // Set lastPayload, set timer
-    auto tuple = line.split(QStringLiteral(" "));
-    if (tuple.length() < 2) {
-        return;
+    disconnectFromTrafficReceiver();
+    emit replayFinished();
+}
+
+
+auto Traffic::TrafficDataSource_File::readRecord() -> bool
+{
+    if (m_isCapture) {
+        return m_captureReader.read(m_record);
     }
-    auto time = tuple[0].toInt();
-    lastPayload = tuple[1];
 
-    if (lastTime == 0) {
-        simulatorTimer.setInterval(0);
-    } else {
-        simulatorTimer.setInterval(time-lastTime);
+    // Lines of simulator files typically look like
+    // "851342 $PFLAA,0,2205,-598,-71,1,AA123F,180,,0,1.5,1*24", with a time
+    // stamp in milliseconds. Lines without time stamp are skipped.
+    while (true) {
+        auto length = simulatorFile.readLine(m_lineBuffer.data(), static_cast<qint64>(m_lineBuffer.size()));
+        if (length <= 0) {
+            return false;
+        }
+        const auto* begin = m_lineBuffer.data();
+        const auto* end = begin + length;
+        qint64 time = 0;
+        auto [pos, errorCode] = std::from_chars(begin, end, time);
+        if ((errorCode != std::errc()) || (pos == end) || (*pos != ' ')) {
+            continue;
+        }
+        pos++;
+
+        m_record.timestamp = time*1000;
+        m_record.channel = Traffic::TrafficCapture::Channel::Sentence;
+        m_record.data = QByteArrayView(pos, end-pos);
+        return true;
     }
-    simulatorTimer.start();
-    lastTime = time;
 }
 
 
@@ -20,18 +20,32 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QFile>
-#include <QTextStream>
 
+#include "traffic/DatagramFilter.h"
+#include "traffic/LineFramer.h"
+#include "traffic/TrafficCapture.h"
 #include "traffic/TrafficDataSource_Abstract.h"
 
 
 namespace Traffic {
 
-/*! \brief Traffic receiver: Simulator file with FLARM/NMEA sentences
+/*! \brief Traffic receiver: Simulator file or capture file
  *
- *  For testing purposes, this class connects to a simulator file with time
- *  stamps and FLARM/NMEA sentences, as provided by FLARM Inc.
+ *  For testing purposes, this class replays one of the following.
+ *
+ *  - A simulator file with time stamps in milliseconds and FLARM/NMEA
+ *    sentences, as provided by FLARM Inc.
+ *
+ *  - A binary capture file, as described in Traffic::TrafficCapture.  TCP
+ *    data is split into lines and handled as FLARM/NMEA sentences; UDP
+ *    datagrams are handled as GDL90 or XGPS data, exactly as the live
+ *    sources do.
+ *
+ *  Data is replayed in real time, at a multiple of real time, or as fast as
+ *  possible, see setReplaySpeed(). Replay times are computed from the start
+ *  of the replay, so that timer latencies do not accumulate.
  */
 class TrafficDataSource_File : public TrafficDataSource_Abstract {
     Q_OBJECT
@@ -56,6 +70,43 @@ public:
      */
     static auto containsFLARMSimulationData(const QString& fileName) -> bool;
 
+    /*! \brief Reads file and checks if the file is a capture file
+     *
+     *  @param fileName Name of the file to be checked
+     *
+     *  @returns True if the file starts with the header of a capture file
+     */
+    static auto containsTrafficCapture(const QString& fileName) -> bool
+    {
+        return Traffic::TrafficCapture::Reader::isCaptureFile(fileName);
+    }
+
+    /*! \brief Replay speed
+     *
+     *  @returns Replay speed, as set with setReplaySpeed()
+     */
+    [[nodiscard]] auto replaySpeed() const -> double
+    {
+        return m_replaySpeed;
+    }
+
+    /*! \brief Set replay speed
+     *
+     *  Changes take effect with the next call to connectToTrafficReceiver().
+     *
+     *  @param speed Factor by which the replay is faster than real time.  The
+     *  default is 1.0, which replays in real time.  Zero or negative values
+     *  replay as fast as possible, returning to the event loop after every
+     *  fastReplayChunk records.
+     */
+    void setReplaySpeed(double speed)
+    {
+        m_replaySpeed = speed;
+    }
+
+    /*! \brief Number of records processed per event loop iteration, when replaying as fast as possible */
+    static constexpr int fastReplayChunk = 1000;
+
     /*! \brief Getter function for the property with the same name
      *
      *  This method implements the pure virtual method declared by its
@@ -83,24 +134,51 @@ public slots:
      */
     void disconnectFromTrafficReceiver() override;
 
+signals:
+    /*! \brief Replay finished
+     *
+     *  This signal is emitted when the end of the file has been reached, or
+     *  when the file cannot be read any further.
+     */
+    void replayFinished();
+
 private slots:
-    // Read one line from the simulator file's text stream and passes the string
-    // on to processFLARMMessage.  Sets up a timer to read the next line in due
-    // time.
+    // Processes all records that are due, then sets up a timer for the next
+    // record
     void readFromSimulatorStream();
 
     // Update the properties "errorString" and "connectivityStatus".
     void updateProperties();
 
 private:
-    QTextStream textStream;
+    // Reads the next record into m_record. Returns false at the end of the
+    // file.
+    auto readRecord() -> bool;
+
+    // Feeds m_record through the parsers
+    void processRecord();
 
     // Simulator related members
     QFile simulatorFile;
-    QTextStream simulatorTextStream;
     QTimer simulatorTimer;
-    int lastTime {0};
-    QString lastPayload;
+    double m_replaySpeed {1.0};
+
+    // Format of the file
+    bool m_isCapture {false};
+    Traffic::TrafficCapture::Reader m_captureReader;
+    std::array<char, LineFramer::maxLineLength+2> m_lineBuffer {};
+
+    // Next record to be processed, if m_hasRecord is true
+    Traffic::TrafficCapture::Record m_record;
+    bool m_hasRecord {false};
+
+    // Replay clock. m_firstTimestamp is the timestamp of the first record.
+    QElapsedTimer m_replayClock;
+    qint64 m_firstTimestamp {0};
+
+    // Decoding state for captured TCP and UDP data, as in the live sources
+    Traffic::LineFramer m_lineFramer;
+    Traffic::DatagramFilter m_datagramFilter;
 };
 
 } // namespace Traffic
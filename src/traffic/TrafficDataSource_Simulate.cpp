@@ -18,7 +18,6 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
-
 #include "traffic/TrafficDataSource_Simulate.h"
 
 
@@ -31,6 +30,10 @@ Traffic::TrafficDataSource_Simulate::TrafficDataSource_Simulate(QObject *parent)
     simulatorTimer.setSingleShot(false);
     connect(&simulatorTimer, &QTimer::timeout, this, &Traffic::TrafficDataSource_Simulate::sendSimulatorData);
 
+    syntheticTimer.setInterval(1s);
+    syntheticTimer.setSingleShot(false);
+    connect(&syntheticTimer, &QTimer::timeout, this, &Traffic::TrafficDataSource_Simulate::sendSyntheticTraffic);
+
     // Initially, set properties
     TrafficDataSource_Simulate::disconnectFromTrafficReceiver();
 }
@@ -45,6 +48,10 @@ void Traffic::TrafficDataSource_Simulate::connectToTrafficReceiver()
 
     setConnectivityStatus( tr("Connected.") );
     simulatorTimer.start();
+    if (!m_syntheticTraffic.isEmpty()) {
+        syntheticClock.start();
+        syntheticTimer.start();
+    }
 }
 
 
@@ -53,15 +60,17 @@ void Traffic::TrafficDataSource_Simulate::disconnectFromTrafficReceiver()
     setConnectivityStatus( tr("Not connected.") );
     setReceivingHeartbeat(false);
     simulatorTimer.stop();
+    syntheticTimer.stop();
 }
 
 
 void Traffic::TrafficDataSource_Simulate::sendSimulatorData()
 {
+    stampReceiveTime();
 
     geoInfo.setTimestamp( QDateTime::currentDateTimeUtc() );
     if (geoInfo.isValid()) {
-        emit positionUpdated( Positioning::PositionInfo(geoInfo) );
+        enqueuePositionInfo( Positioning::PositionInfo(geoInfo) );
         setReceivingHeartbeat(true);
     } else {
         setReceivingHeartbeat(false);
@@ -74,13 +83,59 @@ void Traffic::TrafficDataSource_Simulate::sendSimulatorData()
 
         trafficFactor->startLiveTime();
         if (trafficFactor->valid()) {
-            emit factorWithPosition(*trafficFactor);
+            enqueueFactorWithPosition(Traffic::TrafficReport::fromFactor(*trafficFactor));
         }
     }
 
     if (!trafficFactor_DistanceOnly.isNull()) {
-        emit factorWithoutPosition(*trafficFactor_DistanceOnly);
+        enqueueFactorWithoutPosition(Traffic::TrafficReport::fromFactor(*trafficFactor_DistanceOnly));
+    }
+
+    enqueuePressureAltitude(barometricHeight);
+}
+
+
+void Traffic::TrafficDataSource_Simulate::addSyntheticTarget(const Traffic::SyntheticTraffic::Target& target)
+{
+    m_syntheticTraffic.addTarget(target);
+    if (simulatorTimer.isActive() && !syntheticTimer.isActive()) {
+        syntheticClock.start();
+        syntheticTimer.start();
+    }
+}
+
+
+void Traffic::TrafficDataSource_Simulate::addRandomSyntheticTargets(int count, quint32 seed, Units::Distance radius)
+{
+    m_syntheticTraffic.addRandomTargets(count, seed, radius);
+    if (simulatorTimer.isActive() && !syntheticTimer.isActive() && !m_syntheticTraffic.isEmpty()) {
+        syntheticClock.start();
+        syntheticTimer.start();
     }
+}
+
 
-    emit pressureAltitudeUpdated(barometricHeight);
+void Traffic::TrafficDataSource_Simulate::removeSyntheticTargets()
+{
+    syntheticTimer.stop();
+    m_syntheticTraffic.clear();
+}
+
+
+void Traffic::TrafficDataSource_Simulate::sendSyntheticTraffic()
+{
+    stampReceiveTime();
+    m_syntheticTraffic.advance(std::chrono::milliseconds(syntheticClock.restart()));
+
+    switch (m_syntheticProtocol) {
+    case Traffic::SyntheticTraffic::Protocol::FLARM:
+        m_syntheticTraffic.encode(m_syntheticProtocol, geoInfo, barometricHeight, [this](QByteArrayView sentence) { processFLARMSentence(sentence); });
+        break;
+    case Traffic::SyntheticTraffic::Protocol::GDL90:
+        m_syntheticTraffic.encode(m_syntheticProtocol, geoInfo, barometricHeight, [this](QByteArrayView datagram) { processGDLDatagram(datagram); });
+        break;
+    case Traffic::SyntheticTraffic::Protocol::XGPS:
+        m_syntheticTraffic.encode(m_syntheticProtocol, geoInfo, barometricHeight, [this](QByteArrayView datagram) { processXGPSString(datagram); });
+        break;
+    }
 }
@@ -20,9 +20,11 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QGeoPositionInfo>
 #include <QPointer>
 
+#include "traffic/SyntheticTraffic.h"
 #include "traffic/TrafficDataSource_Abstract.h"
 
 
@@ -31,6 +33,13 @@ namespace Traffic {
 /*! \brief Traffic receiver: Simulator that provides constant data
  *
  *  For testing purposes, this class provides constant traffic data.
+ *
+ *  In addition, the class can simulate a large number of moving synthetic
+ *  targets, for stress testing and profiling. Unlike the traffic factors,
+ *  synthetic targets are encoded by Traffic::SyntheticTraffic as FLARM NMEA
+ *  sentences, GDL90 messages or XGPS strings and fed through the same
+ *  parsers that handle data from real traffic receivers, so that the whole
+ *  pipeline runs under realistic load.
  */
 class TrafficDataSource_Simulate : public TrafficDataSource_Abstract {
     Q_OBJECT
@@ -140,19 +149,69 @@ public slots:
         trafficFactors.clear();
     }
 
+    /*! \brief Add a synthetic target
+     *
+     *  @param target Initial position and motion of the target
+     */
+    void addSyntheticTarget(const Traffic::SyntheticTraffic::Target& target);
+
+    /*! \brief Add synthetic targets at random
+     *
+     *  See Traffic::SyntheticTraffic::addRandomTargets for details.
+     *
+     *  @param count Number of targets to add
+     *
+     *  @param seed Seed for the random number generator. The same seed yields
+     *  the same targets.
+     *
+     *  @param radius Radius of the area around ownship
+     */
+    void addRandomSyntheticTargets(int count, quint32 seed = 1, Units::Distance radius = Units::Distance::fromNM(10));
+
+    /*! \brief Remove all synthetic targets */
+    void removeSyntheticTargets();
+
+    /*! \brief Set data format for synthetic targets
+     *
+     *  @param protocol Data format. The default is FLARM.
+     */
+    void setSyntheticProtocol(Traffic::SyntheticTraffic::Protocol protocol)
+    {
+        m_syntheticProtocol = protocol;
+    }
+
+    /*! \brief Set update interval for synthetic targets
+     *
+     *  @param interval Interval between two reports of each synthetic
+     *  target. The default is one second, as with most traffic receivers.
+     */
+    void setSyntheticInterval(std::chrono::milliseconds interval)
+    {
+        syntheticTimer.setInterval(interval);
+    }
+
 private slots:
     // Send out simulated data. This slot will be called once per second once
     // connectToTrafficReceiver() has been called
     void sendSimulatorData();
 
-private:
+    // Move synthetic targets and send them out in the chosen data format.
+    // This slot will be called by syntheticTimer.
+    void sendSyntheticTraffic();
 
+private:
     // Simulator related members
     QTimer simulatorTimer;
     QGeoPositionInfo geoInfo;
     Units::Distance barometricHeight;
     QVector<QPointer<TrafficFactor_WithPosition>> trafficFactors;
     QPointer<TrafficFactor_DistanceOnly> trafficFactor_DistanceOnly;
+
+    // Synthetic targets
+    QTimer syntheticTimer;
+    QElapsedTimer syntheticClock;
+    Traffic::SyntheticTraffic::Protocol m_syntheticProtocol {Traffic::SyntheticTraffic::Protocol::FLARM};
+    Traffic::SyntheticTraffic m_syntheticTraffic;
 };
 
 } // namespace Traffic
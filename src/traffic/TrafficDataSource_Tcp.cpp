@@ -18,9 +18,6 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
-#include "GlobalObject.h"
-#include "platform/PlatformAdaptor_Abstract.h"
-#include "traffic/PasswordDB.h"
 #include "traffic/TrafficDataSource_Tcp.h"
 
 // Member functions
@@ -34,10 +31,6 @@ Traffic::TrafficDataSource_Tcp::TrafficDataSource_Tcp(QString hostName, quint16
     connect(&m_socket, &QTcpSocket::stateChanged, this, &Traffic::TrafficDataSource_Tcp::onStateChanged);
     connect(&m_socket, &QAbstractSocket::disconnected, this, &Traffic::TrafficDataSource_Tcp::connectToTrafficReceiver, Qt::ConnectionType::QueuedConnection);
 
-    // Set up text stream
-    m_textStream.setDevice(&m_socket);
-    m_textStream.setEncoding(QStringConverter::Latin1);
-
     //
     // Initialize properties
     //
@@ -70,8 +63,8 @@ void Traffic::TrafficDataSource_Tcp::connectToTrafficReceiver()
     setErrorString();
     m_socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
     m_socket.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    m_lineFramer.reset();
     m_socket.connectToHost(m_hostName, m_port);
-    m_textStream.setDevice(&m_socket);
 
     // Update properties
     onStateChanged(m_socket.state());
@@ -97,26 +90,49 @@ void Traffic::TrafficDataSource_Tcp::disconnectFromTrafficReceiver()
 void Traffic::TrafficDataSource_Tcp::onReadyRead()
 {
 
-    QString sentence;
-    while( m_textStream.readLineInto(&sentence) ) {
-
-        // Check if the TCP connection asks for a password
-        if (sentence.startsWith(QLatin1String("PASS?"))) {
-            passwordRequest_Status = waitingForPassword;
-            passwordRequest_SSID = GlobalObject::platformAdaptor()->currentSSID();
-            auto* passwordDB = GlobalObject::passwordDB();
-            if (passwordDB->contains(passwordRequest_SSID)) {
-                setPassword(passwordRequest_SSID, passwordDB->getPassword(passwordRequest_SSID));
-            } else {
-                emit passwordRequest(passwordRequest_SSID);
-            }
-            continue;
+    while (true) {
+        auto buffer = m_lineFramer.writeBuffer();
+        auto bytesRead = m_socket.read(buffer.data(), static_cast<qint64>(buffer.size()));
+        if (bytesRead <= 0) {
+            break;
         }
+        stampReceiveTime();
+        capture(Traffic::TrafficCapture::Channel::TCP, QByteArrayView(buffer.data(), bytesRead));
+        m_lineFramer.commit(bytesRead);
+        m_lineFramer.takeLines([this](QByteArrayView line) { processLine(line); });
+    }
+
+}
+
+
+void Traffic::TrafficDataSource_Tcp::processLine(QByteArrayView line)
+{
+
+    // Check if the TCP connection asks for a password
+    if (line.startsWith("PASS?")) {
+        passwordRequest_Status = waitingForPassword;
+        emit passwordLookupRequest();
+        return;
+    }
+
+    // Process FLARM sentence
+    processFLARMSentence(line);
 
-        // Process FLARM sentence
-        processFLARMSentence(sentence);
+}
+
+
+void Traffic::TrafficDataSource_Tcp::answerPasswordLookup(const QString& SSID, const QString& storedPassword)
+{
+    if (passwordRequest_Status != waitingForPassword) {
+        return;
     }
 
+    passwordRequest_SSID = SSID;
+    if (!storedPassword.isEmpty()) {
+        setPassword(passwordRequest_SSID, storedPassword);
+    } else {
+        emit passwordRequest(passwordRequest_SSID);
+    }
 }
 
 
@@ -143,15 +159,10 @@ void Traffic::TrafficDataSource_Tcp::setPassword(const QString& SSID, const QStr
 
     // First case: the device is already delivering data. This happens for Stratux devices
     // that request a password for historical reasons, but really do not need one.
-    // In this case, accept the password immediately and issue a password storage request
-    // if appropriate
+    // In this case, accept the password immediately and issue a password storage request.
+    // The TrafficDataProvider drops the request if the password is already stored.
     if (receivingHeartbeat()) {
-        // emit a password storage request if appropriate
-        auto* passwordDB = GlobalObject::passwordDB();
-        if (!passwordDB->contains(passwordRequest_SSID) ||
-            (passwordDB->getPassword(passwordRequest_SSID) != passwordRequest_password)) {
-            emit passwordStorageRequest(passwordRequest_SSID, passwordRequest_password);
-        }
+        emit passwordStorageRequest(passwordRequest_SSID, passwordRequest_password);
         return;
     }
 
@@ -177,8 +188,8 @@ void Traffic::TrafficDataSource_Tcp::sendPassword_internal()
     connect(this, &Traffic::TrafficDataSource_Abstract::receivingHeartbeatChanged, this, &Traffic::TrafficDataSource_Tcp::updatePasswordStatusOnHeartbeatChange);
     connect(&m_socket, &QTcpSocket::disconnected, this, &Traffic::TrafficDataSource_Tcp::updatePasswordStatusOnDisconnected);
 
-    m_textStream << passwordRequest_password+"\n";
-    m_textStream.flush();
+    m_socket.write( QString(passwordRequest_password+"\n").toLatin1() );
+    m_socket.flush();
     passwordRequest_Status = waitingForDevice;
 
 }
@@ -191,8 +202,8 @@ void Traffic::TrafficDataSource_Tcp::updatePasswordStatusOnDisconnected()
         return;
     }
 
-    // Remove password from database
-    GlobalObject::passwordDB()->removePassword(passwordRequest_SSID);
+    // Have the password removed from database
+    emit passwordRejected(passwordRequest_SSID);
 
     // Schedule reconnection in 500ms
     QTimer::singleShot(500ms, this, &Traffic::TrafficDataSource_Tcp::connectToTrafficReceiver);
@@ -213,12 +224,9 @@ void Traffic::TrafficDataSource_Tcp::updatePasswordStatusOnHeartbeatChange(bool
         return;
     }
 
-    // emit a password storage request if appropriate
-    auto* passwordDB = GlobalObject::passwordDB();
-    if (!passwordDB->contains(passwordRequest_SSID) ||
-        (passwordDB->getPassword(passwordRequest_SSID) != passwordRequest_password)) {
-        emit passwordStorageRequest(passwordRequest_SSID, passwordRequest_password);
-    }
+    // emit a password storage request; the TrafficDataProvider drops it if
+    // the password is already stored
+    emit passwordStorageRequest(passwordRequest_SSID, passwordRequest_password);
 
     resetPasswordLifecycle();
 }
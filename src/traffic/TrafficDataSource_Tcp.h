@@ -23,6 +23,7 @@
 #include <QPointer>
 #include <QTcpSocket>
 
+#include "traffic/LineFramer.h"
 #include "traffic/TrafficDataSource_AbstractSocket.h"
 
 
@@ -90,9 +91,14 @@ public slots:
      */
     void setPassword(const QString& SSID, const QString& password) override;
 
+    /*! \brief Answer password lookup request
+     *
+     *  This method implements the virtual method declared by its superclass.
+     */
+    void answerPasswordLookup(const QString& SSID, const QString& storedPassword) override;
+
 private slots:
-    // Read lines from the socket's text stream and passes the string on to
-    // processFLARMMessage.
+    // Read lines from the socket and passes them on to processLine
     void onReadyRead();
 
     // This method does the actual job of sending the password to the traffic
@@ -114,32 +120,38 @@ private slots:
     void resetPasswordLifecycle();
 
     // This slot is called when the password has been rejected by the traffic
-    // data receiver. It clears the password from the database, schedules a
-    // reconnect and calls resetPasswordLifecycle().
+    // data receiver. It emits passwordRejected, schedules a reconnect and
+    // calls resetPasswordLifecycle().
     void updatePasswordStatusOnDisconnected();
 
     // This slot is called when the password has been accepted by the traffic
-    // data receiver. It emits a password storage request if appropriate and
-    // calls resetPasswordLifecycle().
+    // data receiver. It emits a password storage request and calls
+    // resetPasswordLifecycle().
     void updatePasswordStatusOnHeartbeatChange(bool newHeartbeat);
 
 private:
+    // Handles password requests and passes all other lines on to
+    // processFLARMSentence
+    void processLine(QByteArrayView line);
+
     QTcpSocket m_socket;
-    QTextStream m_textStream;
+    Traffic::LineFramer m_lineFramer;
     QString m_hostName;
     quint16 m_port;
 
 
     /* Password lifecycle
      *
-     * - The method onReadyRead detects that the device requests password. It
-     *   will store the current SSID in passwordRequest_SSID and set
-     *   passwordRequest_Status to waitingForPassword.
+     * - The method processLine detects that the device requests password. It
+     *   will set passwordRequest_Status to waitingForPassword and emit
+     *   passwordLookupRequest.
      *
-     * - If a password for the SSID is found in the database, the method
-     *   sendPassword is called with that password.  Otherwise, the signal
-     *   passwordRequest is emitted, which will hopefully lead to lead to a
-     *   user-provided password through sendPassword()
+     * - The TrafficDataProvider answers in the main thread by calling
+     *   answerPasswordLookup, which stores the current SSID in
+     *   passwordRequest_SSID. If a password for the SSID is found in the
+     *   database, the method setPassword is called with that password.
+     *   Otherwise, the signal passwordRequest is emitted, which will hopefully
+     *   lead to lead to a user-provided password through setPassword()
      *
      * - The method send password will store the password in
      *   passwordRequest_password, send the password to the device and set
@@ -147,9 +159,9 @@ private:
      *
      * - When the connection is closed while passwordRequest_Status ==
      *   waitingForDevice, this means that the traffic data receiver has
-     *   rejected the password. The password stored in passwordRequest_password
-     *   for passwordRequest_SSID is removed from the password database,
-     *   passwordRequest_Status is set to idle, the members passwordRequest_SSID
+     *   rejected the password. The signal passwordRejected is emitted, so that
+     *   the TrafficDataProvider removes the password for passwordRequest_SSID
+     *   from the password database, passwordRequest_Status is set to idle, the members passwordRequest_SSID
      *   and passwordRequest_password are cleared and an immediate reconnect is
      *   scheduled.
      *
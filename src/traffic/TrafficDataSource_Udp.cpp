@@ -20,6 +20,14 @@
 
 #include <QNetworkDatagram>
 
+#if defined(Q_OS_LINUX)
+#include <array>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 #include "traffic/TrafficDataSource_Udp.h"
 
 
@@ -28,9 +36,7 @@
 Traffic::TrafficDataSource_Udp::TrafficDataSource_Udp(quint16 port, QObject *parent) :
     Traffic::TrafficDataSource_AbstractSocket(parent), m_port(port) {
 
-    // Initialize timers
-    m_trueAltitudeTimer.setInterval(5s);
-    m_trueAltitudeTimer.setSingleShot(true);
+    setDatagramFilter(m_datagramFilter);
 
     //
     // Initialize properties
@@ -60,6 +66,15 @@ void Traffic::TrafficDataSource_Udp::connectToTrafficReceiver()
         delete m_socket;
     }
 
+#if defined(Q_OS_LINUX)
+    closeNativeSocket();
+    if (openNativeSocket()) {
+        setErrorString();
+        onStateChanged(QAbstractSocket::BoundState);
+        return;
+    }
+#endif
+
     // Create socket
     m_socket = new QUdpSocket(this);
     connect(m_socket, &QUdpSocket::errorOccurred, this, &Traffic::TrafficDataSource_Udp::onErrorOccurred);
@@ -81,6 +96,9 @@ void Traffic::TrafficDataSource_Udp::disconnectFromTrafficReceiver()
         m_socket->abort();
     }
     delete m_socket;
+#if defined(Q_OS_LINUX)
+    closeNativeSocket();
+#endif
 
     // Update properties
     onStateChanged(QAbstractSocket::UnconnectedState);
@@ -97,30 +115,111 @@ void Traffic::TrafficDataSource_Udp::onReadyRead()
 
     // Read datagrams
     while (m_socket->hasPendingDatagrams()) {
-        QByteArray data = m_socket->receiveDatagram().data();
+        processDatagram(m_socket->receiveDatagram().data());
+    }
+
+}
+
+
+void Traffic::TrafficDataSource_Udp::processDatagram(QByteArrayView data)
+{
+    stampReceiveTime();
+
+    // Record the datagram before anything is dropped, so that replays see
+    // the same data as the live source
+    capture(Traffic::TrafficCapture::Channel::UDP, data);
+
+    // Skip the datagram if it has already been received
+    if (m_datagramFilter.isDuplicate(data)) {
+        return;
+    }
+
+    // Process datagrams, depending on content type
+    if (data.startsWith("XGPS") || data.startsWith("XTRA")) {
+        processXGPSString(data);
+        return;
+    }
+
+    processGDLDatagram(data);
+}
+
+
+#if defined(Q_OS_LINUX)
 
-        // Return immediately if the datagram has already been received.
-        auto currentDatagramHash = qHash(data);
-        foreach(auto hash, receivedDatagramHashes) {
-            if (hash == currentDatagramHash) {
-                return;
+void Traffic::TrafficDataSource_Udp::closeNativeSocket()
+{
+    delete m_nativeSocketNotifier;
+    if (m_nativeSocket >= 0) {
+        ::close(m_nativeSocket);
+        m_nativeSocket = -1;
+    }
+}
+
+
+auto Traffic::TrafficDataSource_Udp::openNativeSocket() -> bool
+{
+    // Like QUdpSocket::bind(port), we bind a dual-stack socket to the any
+    // address, with SO_REUSEADDR set.
+    auto socketDescriptor = ::socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (socketDescriptor < 0) {
+        return false;
+    }
+    int off = 0;
+    int on = 1;
+    ::setsockopt(socketDescriptor, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    ::setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in6 address {};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(m_port);
+    if (::bind(socketDescriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(socketDescriptor);
+        return false;
+    }
+
+    m_nativeSocket = socketDescriptor;
+    m_nativeSocketNotifier = new QSocketNotifier(m_nativeSocket, QSocketNotifier::Read, this);
+    connect(m_nativeSocketNotifier, &QSocketNotifier::activated, this, [this]() { readNativeSocket(); });
+    if (m_receiveBuffer.size() != batchSize*maxDatagramSize) {
+        m_receiveBuffer = QByteArray(batchSize*maxDatagramSize, Qt::Uninitialized);
+    }
+    return true;
+}
+
+
+void Traffic::TrafficDataSource_Udp::readNativeSocket()
+{
+    std::array<iovec, batchSize> buffers {};
+    std::array<mmsghdr, batchSize> messages {};
+    auto* slab = m_receiveBuffer.data();
+    for(int i=0; i<batchSize; i++) {
+        buffers[i].iov_base = slab + i*maxDatagramSize;
+        buffers[i].iov_len = maxDatagramSize;
+        messages[i].msg_hdr.msg_iov = &buffers[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // Drain the socket. If fewer datagrams than requested arrive, the socket
+    // is empty.
+    while (m_nativeSocket >= 0) {
+        auto count = ::recvmmsg(m_nativeSocket, messages.data(), batchSize, MSG_DONTWAIT, nullptr);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            return;
         }
-        receivedDatagramHashes[nextHashIndex] = currentDatagramHash;
-        nextHashIndex = (nextHashIndex+1) % receivedDatagramHashes.size();
-
-        // Process datagrams, depending on content type
-        if (data.startsWith("XGPS") || data.startsWith("XTRA")) {
-            processXGPSString(data);
-        } else {
-            // Split data into raw messages
-            foreach(auto rawMessage, data.split(0x7e)) {
-                if (!rawMessage.isEmpty()) {
-                    processGDLMessage(rawMessage);
-                }
+        for(int i=0; i<count; i++) {
+            if ((messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+                continue;
             }
-
+            processDatagram(QByteArrayView(slab + i*maxDatagramSize, messages[i].msg_len));
+        }
+        if (count < batchSize) {
+            return;
         }
     }
-
 }
+
+#endif
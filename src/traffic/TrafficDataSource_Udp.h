@@ -22,8 +22,10 @@
 
 
 #include <QPointer>
+#include <QSocketNotifier>
 #include <QUdpSocket>
 
+#include "traffic/DatagramFilter.h"
 #include "traffic/TrafficDataSource_AbstractSocket.h"
 
 
@@ -38,6 +40,12 @@ namespace Traffic {
  *  In most use cases, the connection will be established via the device's WiFi
  *  interface.  The class will therefore try to lock the WiFi once a heartbeat
  *  has been detected, and release the WiFi at the appropriate time.
+ *
+ *  On Linux and Android, the class uses a native socket and drains it with
+ *  recvmmsg(), up to batchSize datagrams per system call, into a buffer that
+ *  is allocated once. The datagrams are passed on to the decoders as views
+ *  into that buffer.  If the native socket cannot be set up, and on all other
+ *  platforms, the class uses QUdpSocket.
  */
 class TrafficDataSource_Udp : public TrafficDataSource_AbstractSocket {
     Q_OBJECT
@@ -82,24 +90,43 @@ public slots:
     void disconnectFromTrafficReceiver() override;
 
 private slots:
-    // Read messages from the socket datagrams and passes the messages on to
-    // processGDLMessage
+    // Read datagrams from the socket and passes them on to processDatagram
     void onReadyRead();
 
 private:
+    // Drops duplicates and passes the datagram on to processGDLDatagram or
+    // processXGPSString
+    void processDatagram(QByteArrayView data);
+
     QPointer<QUdpSocket> m_socket;
     quint16 m_port;
 
-    // We use this vector to store the last 512 datatgram hashes in a circular
-    // array. This is used to sort out doubly sent datagrams. The nextHashIndex
-    // points to the next vector entry that will be re-written.
-    QVector<uint> receivedDatagramHashes {512, 0};
-    int nextHashIndex {0};
+#if defined(Q_OS_LINUX)
+    // Maximal number of datagrams read per system call
+    static constexpr int batchSize = 32;
+
+    // Maximal size of a datagram. Larger datagrams are truncated by the
+    // kernel and ignored.
+    static constexpr qsizetype maxDatagramSize = 2048;
+
+    // Creates and binds a native socket. Returns false on failure, in which
+    // case the caller falls back to QUdpSocket.
+    auto openNativeSocket() -> bool;
+
+    // Closes the native socket, if open
+    void closeNativeSocket();
+
+    // Reads all pending datagrams from the native socket
+    void readNativeSocket();
+
+    // Native socket, notifier, and receive buffer for batchSize datagrams
+    int m_nativeSocket {-1};
+    QPointer<QSocketNotifier> m_nativeSocketNotifier;
+    QByteArray m_receiveBuffer;
+#endif
 
-    // GPS altitude of owncraft
-    Units::Distance m_trueAltitude;
-    Units::Distance m_trueAltitude_FOM;
-    QTimer m_trueAltitudeTimer;
+    // Used to sort out doubly sent datagrams
+    Traffic::DatagramFilter m_datagramFilter;
 
 };
 
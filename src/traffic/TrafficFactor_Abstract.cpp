@@ -26,7 +26,6 @@
 Traffic::TrafficFactor_Abstract::TrafficFactor_Abstract(QObject* parent) : QObject(parent)
 {  
 
-    lifeTimeCounter.setSingleShot(true);
     lifeTimeCounter.setInterval(lifeTime);
 
     // Bindings for property color
@@ -38,13 +37,25 @@ Traffic::TrafficFactor_Abstract::TrafficFactor_Abstract(QObject* parent) : QObje
     connect(this, &Traffic::TrafficFactor_Abstract::vDistChanged, this, &Traffic::TrafficFactor_Abstract::dispatchUpdateDescription);
 
     // Bindings for property valid
-    connect(&lifeTimeCounter, &QTimer::timeout, this, &Traffic::TrafficFactor_Abstract::dispatchUpdateValid);
+    lifeTimeCounter.callOnTimeout([this]() { dispatchUpdateValid(); });
     connect(this, &Traffic::TrafficFactor_Abstract::alarmLevelChanged, this, &Traffic::TrafficFactor_Abstract::dispatchUpdateValid);
     connect(this, &Traffic::TrafficFactor_Abstract::hDistChanged, this, &Traffic::TrafficFactor_Abstract::dispatchUpdateValid);
 
 }
 
 
+auto Traffic::TrafficFactor_Abstract::colorForAlarmLevel(int alarmLevel) -> QString
+{
+    if (alarmLevel == 0) {
+        return QStringLiteral("green");
+    }
+    if (alarmLevel == 1) {
+        return QStringLiteral("yellow");
+    }
+    return QStringLiteral("red");
+}
+
+
 void Traffic::TrafficFactor_Abstract::dispatchUpdateDescription()
 {
     updateDescription();
@@ -93,57 +104,51 @@ void Traffic::TrafficFactor_Abstract::startLiveTime()
 }
 
 
-void Traffic::TrafficFactor_Abstract::updateDescription()
+auto Traffic::TrafficFactor_Abstract::typeToString(AircraftType type) -> QString
 {
-    QStringList results;
-
-    // CallSign
-    if (!callSign().isEmpty()) {
-        results << callSign();
-    }
-
-    // Aircraft type
-    switch(type()) {
+    switch(type) {
     case Aircraft:
-        results << tr("Aircraft");
-        break;
+        return tr("Aircraft");
     case Airship:
-        results << tr("Airship");
-        break;
+        return tr("Airship");
     case Balloon:
-        results << tr("Balloon");
-        break;
+        return tr("Balloon");
     case Copter:
-        results << tr("Copter");
-        break;
+        return tr("Copter");
     case Drone:
-        results << tr("Drone");
-        break;
+        return tr("Drone");
     case Glider:
-        results << tr("Glider");
-        break;
+        return tr("Glider");
     case HangGlider:
-        results << tr("Hang glider");
-        break;
+        return tr("Hang glider");
     case Jet:
-        results << tr("Jet");
-        break;
+        return tr("Jet");
     case Paraglider:
-        results << tr("Paraglider");
-        break;
+        return tr("Paraglider");
     case Skydiver:
-        results << tr("Skydiver");
-        break;
+        return tr("Skydiver");
     case StaticObstacle:
-        results << tr("Static Obstacle");
-        break;
+        return tr("Static Obstacle");
     case TowPlane:
-        results << tr("Tow Plane");
-        break;
+        return tr("Tow Plane");
     default:
-        results << tr("Traffic");
         break;
     }
+    return tr("Traffic");
+}
+
+
+void Traffic::TrafficFactor_Abstract::updateDescription()
+{
+    QStringList results;
+
+    // CallSign
+    if (!callSign().isEmpty()) {
+        results << callSign();
+    }
+
+    // Aircraft type
+    results << typeToString(type());
 
     // Position
     results << tr("Position unknown");
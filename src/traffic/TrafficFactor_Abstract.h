@@ -20,9 +20,10 @@
 
 #pragma once
 
-#include <QTimer>
+#include <QObject>
 #include <chrono>
 
+#include "traffic/TimingWheel.h"
 #include "units/Distance.h"
 
 using namespace std::chrono_literals;
@@ -114,6 +115,10 @@ public:
      * - Traffic objects with higher alarm level have higher priority.
      * - Traffic objects that are closer have higher priority.
      *
+     * This method does not take the closest point of approach into account.
+     * Traffic with position is ranked by TrafficTargetTable::isMoreRelevant
+     * instead.
+     *
      * @param rhs Right hand side of the comparison
      *
      * @returns Boolean with the result
@@ -128,6 +133,22 @@ public:
      */
     void startLiveTime();
 
+    /*! \brief Suggested color for a given alarm level
+     *
+     *  @param alarmLevel Alarm level
+     *
+     *  @returns Color name, as described in the documentation of the property color
+     */
+    static auto colorForAlarmLevel(int alarmLevel) -> QString;
+
+    /*! \brief Human-readable, translated name of an aircraft type
+     *
+     *  @param type Aircraft type
+     *
+     *  @returns Translated string such as "Glider" or "Traffic"
+     */
+    static auto typeToString(AircraftType type) -> QString;
+
 
     //
     // PROPERTIES
@@ -260,13 +281,7 @@ public:
      */
     [[nodiscard]] auto color() const -> QString
     {
-        if (m_alarmLevel == 0) {
-            return QStringLiteral("green");
-        }
-        if (m_alarmLevel == 1) {
-            return QStringLiteral("yellow");
-        }
-        return QStringLiteral("red");
+        return colorForAlarmLevel(m_alarmLevel);
     }
 
     /*! \brief Description of the traffic, for use in GUI
@@ -477,7 +492,7 @@ private:
 
     // Timer for timeout. Traffic objects become invalid if their data has not been
     // refreshed for longer than timeout.
-    QTimer lifeTimeCounter;
+    Traffic::TimingWheel::Timer lifeTimeCounter;
 };
 
 } // namespace Traffic
@@ -54,79 +54,68 @@ void Traffic::TrafficFactor_WithPosition::setPositionInfo(const Positioning::Pos
 }
 
 
-void Traffic::TrafficFactor_WithPosition::updateDescription()
+auto Traffic::TrafficFactor_WithPosition::climbTrendFor(const QGeoPositionInfo& positionInfo, Units::Speed climbRate) -> QString
+{
+    auto climbRateMPS = climbRate.isFinite() ? climbRate.toMPS() : positionInfo.attribute(QGeoPositionInfo::VerticalSpeed);
+    if ( !qIsFinite(climbRateMPS) ) {
+        return {};
+    }
+    if (climbRateMPS < -1.0) {
+        return QStringLiteral("↘");
+    }
+    if (climbRateMPS > 1.0) {
+        return QStringLiteral("↗");
+    }
+    return QStringLiteral("→");
+}
+
+
+auto Traffic::TrafficFactor_WithPosition::descriptionFor(const QString& callSign, AircraftType type, const QGeoPositionInfo& positionInfo, Units::Distance vDist, Units::Speed climbRate) -> QString
 {
     QStringList results;
 
-    if (!callSign().isEmpty()) {
-        results << callSign();
+    if (!callSign.isEmpty()) {
+        results << callSign;
     }
 
-    switch(type()) {
-    case TrafficFactor_Abstract::Aircraft:
-        results << tr("Aircraft");
-        break;
-    case TrafficFactor_Abstract::Airship:
-        results << tr("Airship");
-        break;
-    case TrafficFactor_Abstract::Balloon:
-        results << tr("Balloon");
-        break;
-    case TrafficFactor_Abstract::Copter:
-        results << tr("Copter");
-        break;
-    case TrafficFactor_Abstract::Drone:
-        results << tr("Drone");
-        break;
-    case TrafficFactor_Abstract::Glider:
-        results << tr("Glider");
-        break;
-    case TrafficFactor_Abstract::HangGlider:
-        results << tr("Hang glider");
-        break;
-    case TrafficFactor_Abstract::Jet:
-        results << tr("Jet");
-        break;
-    case TrafficFactor_Abstract::Paraglider:
-        results << tr("Paraglider");
-        break;
-    case TrafficFactor_Abstract::Skydiver:
-        results << tr("Skydiver");
-        break;
-    case TrafficFactor_Abstract::StaticObstacle:
-        results << tr("Static Obstacle");
-        break;
-    case TrafficFactor_Abstract::TowPlane:
-        results << tr("Tow Plane");
-        break;
-    default:
-        results << tr("Traffic");
-        break;
-    }
+    results << typeToString(type);
 
-    if (!positionInfo().coordinate().isValid()) {
+    if (!positionInfo.coordinate().isValid()) {
         results << tr("Position unknown");
     }
 
-    if (vDist().isFinite()) {       
-        QString result = GlobalObject::navigator()->aircraft().verticalDistanceToString(vDist(), true);
-        auto climbRateMPS = m_positionInfo.attribute(QGeoPositionInfo::VerticalSpeed);
-        if ( qIsFinite(climbRateMPS) ) {
-            if (climbRateMPS < -1.0) {
-                result += QStringLiteral(" ↘");
-            }
-            if ((climbRateMPS >= -1.0) && (climbRateMPS <= +1.0)) {
-                result += QStringLiteral(" →");
-            }
-            if (climbRateMPS > 1.0) {
-                result += QStringLiteral(" ↗");
-            }
+    if (vDist.isFinite()) {
+        QString result = GlobalObject::navigator()->aircraft().verticalDistanceToString(vDist, true);
+        auto trend = climbTrendFor(positionInfo, climbRate);
+        if (!trend.isEmpty()) {
+            result += u' ' + trend;
         }
         results << result;
     }
 
+    return results.join(u"<br>");
+}
+
+
+auto Traffic::TrafficFactor_WithPosition::iconFor(const QGeoPositionInfo& positionInfo, const QString& color) -> QString
+{
+    // BaseType
+    QString baseType = QStringLiteral("noDirection");
+    if (positionInfo.hasAttribute(QGeoPositionInfo::GroundSpeed) && positionInfo.hasAttribute(QGeoPositionInfo::Direction)) {
+        auto GS = Units::Speed::fromMPS( positionInfo.attribute(QGeoPositionInfo::GroundSpeed) );
+        if (GS.isFinite() && (GS.toKN() > 4)) {
+            baseType = QStringLiteral("withDirection");
+        }
+    }
+
+    return "/icons/traffic-"+baseType+"-"+color+".svg";
+}
+
+
+void Traffic::TrafficFactor_WithPosition::updateDescription()
+{
     // Set property value
-    auto newDescription = results.join(u"<br>");
+    auto newDescription = descriptionFor(callSign(), type(), m_positionInfo, vDist());
     if (m_description == newDescription) {
         return;
     }
@@ -138,16 +127,7 @@ void Traffic::TrafficFactor_WithPosition::updateDescription()
 
 void Traffic::TrafficFactor_WithPosition::updateIcon()
 {
-    // BaseType
-    QString baseType = QStringLiteral("noDirection");
-    if (m_positionInfo.hasAttribute(QGeoPositionInfo::GroundSpeed) && m_positionInfo.hasAttribute(QGeoPositionInfo::Direction)) {
-        auto GS = Units::Speed::fromMPS( m_positionInfo.attribute(QGeoPositionInfo::GroundSpeed) );
-        if (GS.isFinite() && (GS.toKN() > 4)) {
-            baseType = QStringLiteral("withDirection");
-        }
-    }
-
-    auto newIcon = "/icons/traffic-"+baseType+"-"+color()+".svg";
+    auto newIcon = iconFor(m_positionInfo, color());
     if (m_icon == newIcon) {
         return;
     }
@@ -67,6 +67,53 @@ public:
         TrafficFactor_Abstract::copyFrom(other); // This will also call updateDescription
     }
 
+    /*! \brief Climb trend of a traffic factor, for use in GUI
+     *
+     *  The trend is shown in the description of the traffic factor.
+     *  Climb rates between -1 m/s and +1 m/s count as level flight.
+     *
+     *  @param positionInfo Position of the traffic
+     *
+     *  @param climbRate Climb rate, as in descriptionFor()
+     *
+     *  @returns One of the arrows "↗", "→" and "↘", or an empty string if
+     *  the climb rate is unknown
+     */
+    static auto climbTrendFor(const QGeoPositionInfo& positionInfo, Units::Speed climbRate = {}) -> QString;
+
+    /*! \brief Description of a traffic factor, for use in GUI
+     *
+     *  This method computes the string that is held in the property
+     *  description, for traffic with the given data.
+     *
+     *  @param callSign Call sign, or empty string
+     *
+     *  @param type Aircraft type
+     *
+     *  @param positionInfo Position of the traffic
+     *
+     *  @param vDist Vertical distance to own aircraft, might be NaN
+     *
+     *  @param climbRate Climb rate, typically estimated from the recent track.
+     *  If NaN, the vertical speed reported in positionInfo is used.
+     *
+     *  @returns Rich-text description
+     */
+    static auto descriptionFor(const QString& callSign, AircraftType type, const QGeoPositionInfo& positionInfo, Units::Distance vDist, Units::Speed climbRate = {}) -> QString;
+
+    /*! \brief Suggested icon for a traffic factor
+     *
+     *  This method computes the string that is held in the property icon,
+     *  for traffic with the given data.
+     *
+     *  @param positionInfo Position of the traffic
+     *
+     *  @param color Color, as returned by colorForAlarmLevel()
+     *
+     *  @returns Path to icon
+     */
+    static auto iconFor(const QGeoPositionInfo& positionInfo, const QString& color) -> QString;
+
 
     //
     // PROPERTIES
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <QtMath>
+
+#include "positioning/LocalTangentPlane.h"
+#include "traffic/TrafficFusion.h"
+
+
+// Static Helper functions
+
+// Computes north and east components of the velocity. Returns false if ground
+// speed or track are unknown.
+auto velocityOf(const Positioning::PositionInfo& info, double& north, double& east) -> bool
+{
+    auto groundSpeed = info.groundSpeed().toMPS();
+    auto track = info.trueTrack().toRAD();
+    if (!qIsFinite(groundSpeed) || !qIsFinite(track)) {
+        return false;
+    }
+    north = groundSpeed*qCos(track);
+    east = groundSpeed*qSin(track);
+    return true;
+}
+
+
+// Member functions
+
+auto Traffic::TrafficFusion::correlate(const Traffic::TrafficTargetTable& table, const Traffic::TrafficReport& report, int source) -> QString
+{
+    // Use cached correlation, if the target still exists
+    const QPair<int, QString> key(source, report.ID);
+    auto cached = m_fusedIDs.constFind(key);
+    if (cached != m_fusedIDs.constEnd()) {
+        if (cached.value().isEmpty()) {
+            return report.ID;
+        }
+        if (table.find(cached.value()) != nullptr) {
+            return cached.value();
+        }
+        m_fusedIDs.erase(cached);
+    }
+
+    // Correlate by ID
+    if (table.find(report.ID) != nullptr) {
+        return report.ID;
+    }
+
+    // Correlate by proximity and velocity. Negative results are cached too.
+    auto result = findNearby(table, report, source);
+    m_fusedIDs.insert(key, result);
+    if (result.isEmpty()) {
+        return report.ID;
+    }
+    return result;
+}
+
+
+auto Traffic::TrafficFusion::findNearby(const Traffic::TrafficTargetTable& table, const Traffic::TrafficReport& report, int source) -> QString
+{
+    auto coordinate = report.positionInfo.coordinate();
+    if (!coordinate.isValid()) {
+        return {};
+    }
+    Positioning::LocalTangentPlane tangentPlane(coordinate);
+
+    double velocityNorth = 0.0;
+    double velocityEast = 0.0;
+    auto hasVelocity = velocityOf(report.positionInfo, velocityNorth, velocityEast);
+
+    QString result;
+    auto bestDistance = maxHorizontalDistance.toM();
+    for(const auto& entry : table.entries()) {
+        // Different IDs from the same source belong to different aircraft
+        if (entry.source == source) {
+            continue;
+        }
+
+        // Check vertical distance
+        if (report.vDist.isFinite() && entry.report.vDist.isFinite()
+            && (qAbs((report.vDist-entry.report.vDist).toM()) > maxVerticalDistance.toM())) {
+            continue;
+        }
+
+        // Check velocity
+        double entryVelocityNorth = 0.0;
+        double entryVelocityEast = 0.0;
+        if (hasVelocity && velocityOf(entry.report.positionInfo, entryVelocityNorth, entryVelocityEast)) {
+            auto dNorth = entryVelocityNorth-velocityNorth;
+            auto dEast = entryVelocityEast-velocityEast;
+            if (qSqrt(dNorth*dNorth + dEast*dEast) > maxVelocityDifference.toMPS()) {
+                continue;
+            }
+        }
+
+        // Check horizontal distance
+        auto distance = tangentPlane.distanceTo(entry.report.positionInfo.coordinate()).toM();
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            result = entry.report.ID;
+        }
+    }
+    return result;
+}
+
+
+auto Traffic::TrafficFusion::mayUpdate(const Traffic::TrafficTargetTable::Entry& entry, int source, qint64 timestamp) -> bool
+{
+    if (source <= entry.source) {
+        return true;
+    }
+    return timestamp - entry.timestamp > std::chrono::milliseconds(handoverTime).count();
+}
+
+
+void Traffic::TrafficFusion::prune(const Traffic::TrafficTargetTable& table)
+{
+    // Negative results have an empty ID, which is never found in the table
+    for(auto it = m_fusedIDs.begin(); it != m_fusedIDs.end(); ) {
+        if (table.find(it.value()) == nullptr) {
+            it = m_fusedIDs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <chrono>
+
+#include "traffic/TrafficTargetTable.h"
+#include "units/Speed.h"
+
+using namespace std::chrono_literals;
+
+
+namespace Traffic {
+
+/*! \brief Fusion of traffic reports from several data sources
+ *
+ *  If several traffic data sources are active, for instance a FLARM device
+ *  via TCP and an ADS-B receiver via UDP, the same aircraft is often reported
+ *  by more than one source, typically under different IDs.  This class
+ *  correlates the reports and assigns them a common ID, so that every
+ *  aircraft appears only once in the TrafficTargetTable.
+ *
+ *  A report is correlated with a target in the table if the target has the
+ *  same ID, or if the target was reported by a different source and is close
+ *  to the reported position, with similar velocity.  The proximity search
+ *  runs only once for every new combination of source and ID; the result is
+ *  cached.  If the search finds no target, this is cached as well, until the
+ *  next call to prune(), so that reports of an aircraft that does not make
+ *  it into the table do not trigger a search every time.
+ *
+ *  Data from preferred sources is not overwritten by data from other
+ *  sources, unless it is older than handoverTime.
+ */
+
+class TrafficFusion {
+
+public:
+    /*! \brief Time after which a less preferred source may take over a target */
+    static constexpr auto handoverTime = 3s;
+
+    /*! \brief Maximal horizontal distance of correlated reports */
+    static constexpr auto maxHorizontalDistance = Units::Distance::fromM(300.0);
+
+    /*! \brief Maximal vertical distance of correlated reports */
+    static constexpr auto maxVerticalDistance = Units::Distance::fromM(150.0);
+
+    /*! \brief Maximal difference in velocity of correlated reports */
+    static constexpr auto maxVelocityDifference = Units::Speed::fromMPS(15.0);
+
+    /*! \brief Find the ID under which a report is stored
+     *
+     *  @param table Traffic target table
+     *
+     *  @param report Traffic report
+     *
+     *  @param source Priority of the data source that provided the report
+     *
+     *  @returns ID of a target in the table that is correlated with the
+     *  report, or the ID of the report if there is no such target
+     */
+    auto correlate(const Traffic::TrafficTargetTable& table, const Traffic::TrafficReport& report, int source) -> QString;
+
+    /*! \brief Check whether a report may update a target
+     *
+     *  @param entry Entry of the target in the table
+     *
+     *  @param source Priority of the data source that provided the report
+     *
+     *  @param timestamp Time of the report, in milliseconds
+     *
+     *  @returns True if the source is at least as preferred as the source of
+     *  the entry, or if the entry is older than handoverTime
+     */
+    [[nodiscard]] static auto mayUpdate(const Traffic::TrafficTargetTable::Entry& entry, int source, qint64 timestamp) -> bool;
+
+    /*! \brief Forget correlations with targets that are no longer in the table
+     *
+     *  Cached negative results of the proximity search are forgotten as well.
+     *
+     *  @param table Traffic target table
+     */
+    void prune(const Traffic::TrafficTargetTable& table);
+
+private:
+    // Searches the table for a target of another source that matches the
+    // report. Returns the ID of the target, or an empty string.
+    [[nodiscard]] static auto findNearby(const Traffic::TrafficTargetTable& table, const Traffic::TrafficReport& report, int source) -> QString;
+
+    // Maps source priority and report ID to the ID in the table. An empty ID
+    // records that the proximity search found no target.
+    QHash<QPair<int, QString>, QString> m_fusedIDs;
+};
+
+} // namespace Traffic
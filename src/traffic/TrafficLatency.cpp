@@ -0,0 +1,107 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "traffic/IngestionStatistics.h"
+#include "traffic/TrafficLatency.h"
+
+
+// Static Helper functions
+
+// Sets value to time, unless value is already set. Times are taken from a
+// monotonic clock, so an existing value is the earlier one.
+void keepEarliest(std::atomic<qint64>& value, qint64 time)
+{
+    qint64 expected = 0;
+    value.compare_exchange_strong(expected, time, std::memory_order_relaxed);
+}
+
+
+// Member functions
+
+void Traffic::TrafficLatency::addReport(qint64 receiveTime)
+{
+    if (receiveTime > 0) {
+        m_reportToProvider.add(Traffic::IngestionStatistics::now()-receiveTime);
+    }
+}
+
+
+void Traffic::TrafficLatency::addWarning(qint64 receiveTime)
+{
+    if (receiveTime > 0) {
+        m_warningToProvider.add(Traffic::IngestionStatistics::now()-receiveTime);
+    }
+}
+
+
+void Traffic::TrafficLatency::markRenderPending(qint64 warningReceiveTime)
+{
+    keepEarliest(m_pendingUpdate, Traffic::IngestionStatistics::now());
+    if (warningReceiveTime > 0) {
+        keepEarliest(m_pendingWarning, warningReceiveTime);
+    }
+}
+
+
+void Traffic::TrafficLatency::onAfterSynchronizing()
+{
+    auto update = m_pendingUpdate.exchange(0, std::memory_order_relaxed);
+    if (update != 0) {
+        keepEarliest(m_syncedUpdate, update);
+    }
+    auto warning = m_pendingWarning.exchange(0, std::memory_order_relaxed);
+    if (warning != 0) {
+        keepEarliest(m_syncedWarning, warning);
+    }
+}
+
+
+void Traffic::TrafficLatency::onFrameSwapped()
+{
+    auto now = Traffic::IngestionStatistics::now();
+    auto update = m_syncedUpdate.exchange(0, std::memory_order_relaxed);
+    if (update != 0) {
+        m_providerToRender.add(now-update);
+    }
+    auto warning = m_syncedWarning.exchange(0, std::memory_order_relaxed);
+    if (warning != 0) {
+        m_warningToRender.add(now-warning);
+    }
+}
+
+
+void Traffic::TrafficLatency::reset()
+{
+    m_reportToProvider.reset();
+    m_warningToProvider.reset();
+    m_providerToRender.reset();
+    m_warningToRender.reset();
+}
+
+
+auto Traffic::TrafficLatency::toJSON() const -> QJsonObject
+{
+    QJsonObject result;
+    result.insert(QStringLiteral("reportToProvider"), m_reportToProvider.toJSON());
+    result.insert(QStringLiteral("warningToProvider"), m_warningToProvider.toJSON());
+    result.insert(QStringLiteral("providerToRender"), m_providerToRender.toJSON());
+    result.insert(QStringLiteral("warningToRender"), m_warningToRender.toJSON());
+    return result;
+}
@@ -0,0 +1,128 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QJsonObject>
+
+#include <atomic>
+
+#include "LatencyHistogram.h"
+
+
+namespace Traffic {
+
+/*! \brief Latency of traffic data, from socket to screen
+ *
+ *  Traffic data sources stamp their data with the time it is read from the
+ *  socket, using IngestionStatistics::now().  The stamps are carried along in
+ *  TrafficReport and Warning.  This class collects the stamps at the
+ *  TrafficDataProvider and at the display, and records latency histograms
+ *  for the following paths.
+ *
+ *  - reportToProvider: Traffic report read from socket until received by the
+ *    TrafficDataProvider.  This includes the batching in the source.
+ *
+ *  - warningToProvider: Traffic warning read from socket until received by
+ *    the TrafficDataProvider.
+ *
+ *  - providerToRender: Update of targets or warning in the
+ *    TrafficDataProvider until the first frame that shows the update is
+ *    swapped to the screen.  This includes the evaluation of QML bindings.
+ *
+ *  - warningToRender: Changed traffic warning read from socket until the
+ *    first frame that shows the warning is swapped to the screen.
+ *
+ *  The methods for the render paths are meant to be connected to the
+ *  signals QQuickWindow::afterSynchronizing and QQuickWindow::frameSwapped.
+ *  These signals are emitted in the render thread, so all methods of this
+ *  class are thread-safe.  Frames that are not rendered because the window
+ *  is hidden are included in the latency of the next frame that is.
+ */
+
+class TrafficLatency
+{
+public:
+    /*! \brief Record arrival of a traffic report at the TrafficDataProvider
+     *
+     *  @param receiveTime Time at which the report was read from the socket,
+     *  or 0 if unknown.  Reports with unknown time are ignored.
+     */
+    void addReport(qint64 receiveTime);
+
+    /*! \brief Record arrival of a traffic warning at the TrafficDataProvider
+     *
+     *  @param receiveTime Time at which the warning was read from the socket,
+     *  or 0 if unknown.  Warnings with unknown time are ignored.
+     */
+    void addWarning(qint64 receiveTime);
+
+    /*! \brief Mark data as waiting to be rendered
+     *
+     *  Call this method whenever the TrafficDataProvider has updated data that
+     *  is shown on screen.  If several updates happen before the next frame,
+     *  the earliest one counts.
+     *
+     *  @param warningReceiveTime If the update is a changed warning, the time
+     *  at which the warning was read from the socket, and 0 otherwise
+     */
+    void markRenderPending(qint64 warningReceiveTime = 0);
+
+    /*! \brief Scene graph synchronized
+     *
+     *  Connect this to QQuickWindow::afterSynchronizing.  Data marked as
+     *  pending before the synchronization is contained in the frame that is
+     *  being rendered.
+     */
+    void onAfterSynchronizing();
+
+    /*! \brief Frame swapped to the screen
+     *
+     *  Connect this to QQuickWindow::frameSwapped.
+     */
+    void onFrameSwapped();
+
+    /*! \brief Reset all histograms */
+    void reset();
+
+    /*! \brief Description in JSON format
+     *
+     *  @returns JSON object with one entry per path, in the format of
+     *  LatencyHistogram::toJSON()
+     */
+    [[nodiscard]] auto toJSON() const -> QJsonObject;
+
+private:
+    LatencyHistogram m_reportToProvider;
+    LatencyHistogram m_warningToProvider;
+    LatencyHistogram m_providerToRender;
+    LatencyHistogram m_warningToRender;
+
+    // Times of the earliest pending update and of the earliest pending
+    // warning, as set by markRenderPending(), or 0 if there is none. At scene
+    // graph synchronization, the values move to m_synced*, and are recorded
+    // when the frame is swapped.
+    std::atomic<qint64> m_pendingUpdate {0};
+    std::atomic<qint64> m_pendingWarning {0};
+    std::atomic<qint64> m_syncedUpdate {0};
+    std::atomic<qint64> m_syncedWarning {0};
+};
+
+} // namespace Traffic
@@ -0,0 +1,222 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "traffic/TrafficTargetModel.h"
+
+
+// Static Helper functions
+
+// Appends role to roles, unless it is already there
+void appendRole(QList<int>& roles, int role)
+{
+    if (!roles.contains(role)) {
+        roles.append(role);
+    }
+}
+
+
+Traffic::TrafficTargetModel::TrafficTargetModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+
+auto Traffic::TrafficTargetModel::changedRoles(const Traffic::TrafficReport& oldReport, const Traffic::TrafficReport& newReport) -> QList<int>
+{
+    QList<int> roles;
+    if (oldReport.alarmLevel != newReport.alarmLevel) {
+        appendRole(roles, AlarmLevelRole);
+        appendRole(roles, ColorRole);
+        appendRole(roles, IconRole);
+    }
+    if (oldReport.callSign != newReport.callSign) {
+        appendRole(roles, CallSignRole);
+        appendRole(roles, DescriptionRole);
+    }
+    // The climb rate is estimated anew with every report. The description
+    // shows only its trend.
+    if (Traffic::TrafficFactor_WithPosition::climbTrendFor(oldReport.positionInfo, oldReport.climbRate) != Traffic::TrafficFactor_WithPosition::climbTrendFor(newReport.positionInfo, newReport.climbRate)) {
+        appendRole(roles, DescriptionRole);
+    }
+    if (oldReport.hDist != newReport.hDist) {
+        appendRole(roles, HDistRole);
+    }
+    if (!(oldReport.positionInfo == newReport.positionInfo)) {
+        appendRole(roles, PositionInfoRole);
+        appendRole(roles, IconRole);
+        if (oldReport.positionInfo.coordinate().isValid() != newReport.positionInfo.coordinate().isValid()) {
+            appendRole(roles, DescriptionRole);
+        }
+    }
+    if (oldReport.type != newReport.type) {
+        appendRole(roles, TypeRole);
+        appendRole(roles, DescriptionRole);
+    }
+    if (oldReport.vDist != newReport.vDist) {
+        appendRole(roles, VDistRole);
+        appendRole(roles, DescriptionRole);
+    }
+    return roles;
+}
+
+
+auto Traffic::TrafficTargetModel::data(const QModelIndex& index, int role) const -> QVariant
+{
+    if (!index.isValid() || (index.row() < 0) || (index.row() >= m_rows.size())) {
+        return {};
+    }
+    const auto& row = m_rows[index.row()];
+
+    switch(role) {
+    case AlarmLevelRole:
+        return row.report.alarmLevel;
+    case CallSignRole:
+        return row.report.callSign;
+    case ColorRole:
+        return Traffic::TrafficFactor_Abstract::colorForAlarmLevel(row.report.alarmLevel);
+    case DescriptionRole:
+        if (row.description.isNull()) {
+            row.description = Traffic::TrafficFactor_WithPosition::descriptionFor(row.report.callSign, row.report.type, row.report.positionInfo, row.report.vDist, row.report.climbRate);
+        }
+        return row.description;
+    case HDistRole:
+        return QVariant::fromValue(row.report.hDist);
+    case IconRole:
+        if (row.icon.isNull()) {
+            row.icon = Traffic::TrafficFactor_WithPosition::iconFor(row.report.positionInfo, Traffic::TrafficFactor_Abstract::colorForAlarmLevel(row.report.alarmLevel));
+        }
+        return row.icon;
+    case IDRole:
+        return row.report.ID;
+    case PositionInfoRole:
+        return QVariant::fromValue(row.report.positionInfo);
+    case TypeRole:
+        return QVariant::fromValue(row.report.type);
+    case ValidRole:
+        // The model contains only valid targets
+        return true;
+    case VDistRole:
+        return QVariant::fromValue(row.report.vDist);
+    default:
+        break;
+    }
+    return {};
+}
+
+
+auto Traffic::TrafficTargetModel::roleNames() const -> QHash<int, QByteArray>
+{
+    return {
+        {AlarmLevelRole, "alarmLevel"},
+        {CallSignRole, "callSign"},
+        {ColorRole, "color"},
+        {DescriptionRole, "description"},
+        {HDistRole, "hDist"},
+        {IconRole, "icon"},
+        {IDRole, "ID"},
+        {PositionInfoRole, "positionInfo"},
+        {TypeRole, "type"},
+        {ValidRole, "valid"},
+        {VDistRole, "vDist"}
+    };
+}
+
+
+auto Traffic::TrafficTargetModel::rowCount(const QModelIndex& parent) const -> int
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return static_cast<int>(m_rows.size());
+}
+
+
+auto Traffic::TrafficTargetModel::setTargets(const QVector<const Traffic::TrafficTargetTable::Entry*>& entries) -> bool
+{
+    bool changed = false;
+
+    QHash<QString, const Traffic::TrafficTargetTable::Entry*> incoming;
+    incoming.reserve(entries.size());
+    for(const auto* entry : entries) {
+        incoming.insert(entry->report.ID, entry);
+    }
+
+    // Remove rows of targets that have disappeared. We go from back to front
+    // and remove contiguous ranges of rows at once.
+    auto row = m_rows.size()-1;
+    while (row >= 0) {
+        if (incoming.contains(m_rows[row].report.ID)) {
+            row--;
+            continue;
+        }
+        auto last = row;
+        while ((row >= 0) && !incoming.contains(m_rows[row].report.ID)) {
+            row--;
+        }
+        auto first = row+1;
+        beginRemoveRows(QModelIndex(), static_cast<int>(first), static_cast<int>(last));
+        m_rows.remove(first, last-first+1);
+        endRemoveRows();
+        changed = true;
+    }
+
+    // Update rows of targets that have changed. Entries that are found here
+    // are taken out of the hash, so that only new targets remain.
+    for(row = 0; row < m_rows.size(); row++) {
+        auto& currentRow = m_rows[row];
+        const auto* entry = incoming.take(currentRow.report.ID);
+        if (entry->generation == currentRow.generation) {
+            continue;
+        }
+
+        auto roles = changedRoles(currentRow.report, entry->report);
+        currentRow.report = entry->report;
+        currentRow.generation = entry->generation;
+        if (roles.contains(DescriptionRole)) {
+            currentRow.description = QString();
+        }
+        if (roles.contains(IconRole)) {
+            currentRow.icon = QString();
+        }
+        if (!roles.isEmpty()) {
+            auto modelIndex = index(static_cast<int>(row));
+            emit dataChanged(modelIndex, modelIndex, roles);
+            changed = true;
+        }
+    }
+
+    // Append rows for new targets, in the order given
+    if (incoming.isEmpty()) {
+        return changed;
+    }
+    auto first = m_rows.size();
+    beginInsertRows(QModelIndex(), static_cast<int>(first), static_cast<int>(first+incoming.size()-1));
+    for(const auto* entry : entries) {
+        if (!incoming.contains(entry->report.ID)) {
+            continue;
+        }
+        Row newRow;
+        newRow.report = entry->report;
+        newRow.generation = entry->generation;
+        m_rows.append(newRow);
+    }
+    endInsertRows();
+    return true;
+}
@@ -0,0 +1,130 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QAbstractListModel>
+
+#include "traffic/TrafficTargetTable.h"
+
+
+namespace Traffic {
+
+/*! \brief List model of traffic targets, for use in QML
+ *
+ *  This model holds a snapshot of the most relevant traffic targets, as
+ *  plain values.  The snapshot is replaced by calling setTargets(), typically
+ *  once per display frame.  The model compares the new snapshot with the old
+ *  one and informs views only about the differences: rows for targets that
+ *  have disappeared are removed, rows for new targets are appended, and for
+ *  targets whose data changed, dataChanged() is emitted with the roles that
+ *  actually changed.  Rows are not sorted.
+ *
+ *  The roles "description" and "icon" are expensive, because they involve
+ *  translated and formatted strings.  They are computed only when a view
+ *  asks for them, and cached until the target changes.
+ *
+ *  The role names match the property names of TrafficFactor_WithPosition, so
+ *  delegates can use the delegate's "model" object in place of a traffic
+ *  factor.
+ */
+
+class TrafficTargetModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    /*! \brief Roles provided by this model */
+    enum Roles {
+        AlarmLevelRole = Qt::UserRole + 1,
+        CallSignRole,
+        ColorRole,
+        DescriptionRole,
+        HDistRole,
+        IconRole,
+        IDRole,
+        PositionInfoRole,
+        TypeRole,
+        ValidRole,
+        VDistRole
+    };
+    Q_ENUM(Roles)
+
+    /*! \brief Default constructor
+     *
+     *  @param parent The standard QObject parent pointer
+     */
+    explicit TrafficTargetModel(QObject* parent = nullptr);
+
+    // Standard destructor
+    ~TrafficTargetModel() override = default;
+
+
+    //
+    // Methods
+    //
+
+    /*! \brief Replace the snapshot of traffic targets
+     *
+     *  This method compares the entries with the current rows, by target ID
+     *  and generation, and emits the minimal set of model signals.
+     *
+     *  @param entries Entries of a TrafficTargetTable, as returned by
+     *  TrafficTargetTable::topN(). The pointers need to be valid only for the
+     *  duration of the call.
+     *
+     *  @returns True if rows have been removed, inserted or changed
+     */
+    auto setTargets(const QVector<const Traffic::TrafficTargetTable::Entry*>& entries) -> bool;
+
+    // See documentation in base class
+    [[nodiscard]] auto data(const QModelIndex& index, int role = Qt::DisplayRole) const -> QVariant override;
+
+    // See documentation in base class
+    [[nodiscard]] auto roleNames() const -> QHash<int, QByteArray> override;
+
+    // See documentation in base class
+    [[nodiscard]] auto rowCount(const QModelIndex& parent = QModelIndex()) const -> int override;
+
+private:
+    Q_DISABLE_COPY_MOVE(TrafficTargetModel)
+
+    // Row of the model
+    struct Row {
+        // Snapshot of the target
+        Traffic::TrafficReport report;
+
+        // Generation of the TrafficTargetTable entry that the snapshot was
+        // taken from
+        quint64 generation {0};
+
+        // Lazily computed roles. Null strings indicate that the value has not
+        // been computed yet.
+        mutable QString description;
+        mutable QString icon;
+    };
+
+    // Roles that differ between two reports of the same target
+    static auto changedRoles(const Traffic::TrafficReport& oldReport, const Traffic::TrafficReport& newReport) -> QList<int>;
+
+    // Current snapshot
+    QVector<Row> m_rows;
+};
+
+} // namespace Traffic
@@ -0,0 +1,223 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "traffic/TrafficTargetTable.h"
+
+
+Traffic::TrafficTargetTable::TrafficTargetTable(qsizetype capacity)
+    : m_capacity(qMax(capacity, qsizetype(1)))
+{
+    m_heap.reserve(m_capacity);
+    m_positionOfID.reserve(m_capacity);
+}
+
+
+void Traffic::TrafficTargetTable::clear()
+{
+    m_heap.clear();
+    m_positionOfID.clear();
+}
+
+
+auto Traffic::TrafficTargetTable::find(const QString& ID) const -> const Entry*
+{
+    auto position = m_positionOfID.value(ID, -1);
+    if (position < 0) {
+        return nullptr;
+    }
+    return &m_heap[position];
+}
+
+
+auto Traffic::TrafficTargetTable::isMoreRelevant(const Traffic::TrafficReport& lhs, const Traffic::TrafficReport& rhs) -> bool
+{
+    if (lhs.alarmLevel != rhs.alarmLevel) {
+        return lhs.alarmLevel > rhs.alarmLevel;
+    }
+    return lhs.predictedSeparation() < rhs.predictedSeparation();
+}
+
+
+void Traffic::TrafficTargetTable::rebuildHeap()
+{
+    for(auto position = m_heap.size()/2-1; position >= 0; position--) {
+        siftDown(position);
+    }
+}
+
+
+void Traffic::TrafficTargetTable::remove(const QString& ID)
+{
+    auto position = m_positionOfID.value(ID, -1);
+    if (position < 0) {
+        return;
+    }
+    removeAt(position);
+}
+
+
+void Traffic::TrafficTargetTable::removeAt(qsizetype position)
+{
+    auto last = m_heap.size()-1;
+    if (position != last) {
+        swapEntries(position, last);
+    }
+    m_positionOfID.remove(m_heap.last().report.ID);
+    m_heap.removeLast();
+    if (position < m_heap.size()) {
+        restoreHeap(position);
+    }
+}
+
+
+void Traffic::TrafficTargetTable::removeOlderThan(qint64 timestamp)
+{
+    // Removing an entry reorders the heap, so we collect the IDs first
+    QVector<QString> outdatedIDs;
+    for(const auto& entry : m_heap) {
+        if (entry.timestamp < timestamp) {
+            outdatedIDs.append(entry.report.ID);
+        }
+    }
+    for(const auto& ID : outdatedIDs) {
+        remove(ID);
+    }
+}
+
+
+void Traffic::TrafficTargetTable::restoreHeap(qsizetype position)
+{
+    if (siftUp(position) == position) {
+        siftDown(position);
+    }
+}
+
+
+void Traffic::TrafficTargetTable::setCapacity(qsizetype newCapacity)
+{
+    m_capacity = qMax(newCapacity, qsizetype(1));
+    while (m_heap.size() > m_capacity) {
+        removeAt(0);
+    }
+}
+
+
+auto Traffic::TrafficTargetTable::siftDown(qsizetype position) -> qsizetype
+{
+    auto size = m_heap.size();
+    while (true) {
+        auto leastRelevant = position;
+        auto left = 2*position+1;
+        auto right = 2*position+2;
+        if ((left < size) && isMoreRelevant(m_heap[leastRelevant].report, m_heap[left].report)) {
+            leastRelevant = left;
+        }
+        if ((right < size) && isMoreRelevant(m_heap[leastRelevant].report, m_heap[right].report)) {
+            leastRelevant = right;
+        }
+        if (leastRelevant == position) {
+            return position;
+        }
+        swapEntries(position, leastRelevant);
+        position = leastRelevant;
+    }
+}
+
+
+auto Traffic::TrafficTargetTable::siftUp(qsizetype position) -> qsizetype
+{
+    while (position > 0) {
+        auto parent = (position-1)/2;
+        if (!isMoreRelevant(m_heap[parent].report, m_heap[position].report)) {
+            return position;
+        }
+        swapEntries(position, parent);
+        position = parent;
+    }
+    return position;
+}
+
+
+void Traffic::TrafficTargetTable::swapEntries(qsizetype a, qsizetype b)
+{
+    std::swap(m_heap[a], m_heap[b]);
+    m_positionOfID[m_heap[a].report.ID] = a;
+    m_positionOfID[m_heap[b].report.ID] = b;
+}
+
+
+auto Traffic::TrafficTargetTable::topN(qsizetype n) const -> QVector<const Entry*>
+{
+    QVector<const Entry*> result;
+    result.reserve(m_heap.size());
+    for(const auto& entry : m_heap) {
+        result.append(&entry);
+    }
+
+    n = qBound(qsizetype(0), n, result.size());
+    std::partial_sort(result.begin(), result.begin()+n, result.end(), [](const Entry* lhs, const Entry* rhs) {
+        return isMoreRelevant(lhs->report, rhs->report);
+    });
+    result.resize(n);
+    return result;
+}
+
+
+auto Traffic::TrafficTargetTable::update(const Traffic::TrafficReport& report, qint64 timestamp, int source) -> bool
+{
+    // Reports that would give invalid traffic factors are not stored
+    bool valid = (report.alarmLevel >= 0) && (report.alarmLevel <= 3) && report.hDist.isFinite();
+
+    // Update existing entry
+    auto position = m_positionOfID.value(report.ID, -1);
+    if (position >= 0) {
+        if (!valid) {
+            removeAt(position);
+            return false;
+        }
+        auto& entry = m_heap[position];
+        entry.report = report;
+        entry.timestamp = timestamp;
+        entry.source = source;
+        entry.generation = ++m_generation;
+        restoreHeap(position);
+        return true;
+    }
+    if (!valid) {
+        return false;
+    }
+
+    // If the table is full, make room by dropping the least relevant entry,
+    // provided that the new report is more relevant
+    if (m_heap.size() >= m_capacity) {
+        if (!isMoreRelevant(report, m_heap.constFirst().report)) {
+            return false;
+        }
+        removeAt(0);
+    }
+
+    // Insert new entry
+    m_heap.append( {report, timestamp, source, ++m_generation} );
+    m_positionOfID.insert(report.ID, m_heap.size()-1);
+    siftUp(m_heap.size()-1);
+    return true;
+}
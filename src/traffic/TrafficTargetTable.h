@@ -0,0 +1,223 @@
+/***************************************************************************
+ *   Copyright (C) 2022 by Stefan Kebekus                                  *
+ *   stefan.kebekus@gmail.com                                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QVector>
+#include <span>
+
+#include "traffic/TrafficDataBatch.h"
+
+
+namespace Traffic {
+
+/*! \brief Table of traffic targets
+ *
+ *  This class stores the most relevant traffic reports, at most one per
+ *  target ID.  Internally, the reports are kept in a binary heap whose top
+ *  element is the least relevant target, together with a hash that maps
+ *  target IDs to heap positions.  Inserting, updating and removing a target
+ *  therefore take O(log n) time.  If the table is full, a new target replaces
+ *  the least relevant one, provided that the new target is more relevant.
+ *
+ *  Relevance is defined by isMoreRelevant(): targets with higher alarm level
+ *  are more relevant.  Among targets with equal alarm level, the target with
+ *  smaller predicted separation is more relevant, see
+ *  TrafficReport::predictedSeparation.  This differs from
+ *  TrafficFactor_Abstract::hasHigherPriorityThan, which breaks ties by the
+ *  current horizontal distance; that method ranks traffic without position,
+ *  for which no closest point of approach can be predicted.  Reports that
+ *  would give invalid traffic factors (alarm level out of range, horizontal
+ *  distance unknown) are not stored.
+ */
+
+class TrafficTargetTable {
+
+public:
+    /*! \brief Entry in the table */
+    struct Entry {
+        /*! \brief Most recent traffic report for the target */
+        Traffic::TrafficReport report;
+
+        /*! \brief Time of the most recent report, in milliseconds */
+        qint64 timestamp {0};
+
+        /*! \brief Priority of the data source that provided the report
+         *
+         *  Smaller numbers indicate preferred sources.
+         */
+        int source {0};
+
+        /*! \brief Update counter
+         *
+         *  This number is different for every call to update(), so consumers
+         *  can find out if an entry has changed.
+         */
+        quint64 generation {0};
+    };
+
+    /*! \brief Default capacity */
+    static constexpr qsizetype defaultCapacity = 250;
+
+    /*! \brief Constructor
+     *
+     *  @param capacity Maximal number of targets
+     */
+    explicit TrafficTargetTable(qsizetype capacity = defaultCapacity);
+
+    /*! \brief Maximal number of targets
+     *
+     *  @returns Capacity
+     */
+    [[nodiscard]] auto capacity() const -> qsizetype { return m_capacity; }
+
+    /*! \brief Set maximal number of targets
+     *
+     *  If the table holds more targets than the new capacity allows, the least
+     *  relevant targets are removed.
+     *
+     *  @param newCapacity New capacity, must be positive
+     */
+    void setCapacity(qsizetype newCapacity);
+
+    /*! \brief Number of targets
+     *
+     *  @returns Number of targets in the table
+     */
+    [[nodiscard]] auto size() const -> qsizetype { return m_heap.size(); }
+
+    /*! \brief Remove all targets */
+    void clear();
+
+    /*! \brief Insert or update a target
+     *
+     *  If the table contains a target with the ID of the report, that entry is
+     *  updated. Otherwise, the report is inserted if the table has room or if
+     *  the report is more relevant than the least relevant entry, which is
+     *  then dropped.  If the report would give an invalid traffic factor, any
+     *  existing entry for the ID is removed.
+     *
+     *  @param report Traffic report
+     *
+     *  @param timestamp Time of the report, in milliseconds
+     *
+     *  @param source Priority of the data source that provided the report
+     *
+     *  @returns True if the table contains the report after the call
+     */
+    auto update(const Traffic::TrafficReport& report, qint64 timestamp, int source = 0) -> bool;
+
+    /*! \brief Find a target
+     *
+     *  @param ID Target ID
+     *
+     *  @returns Pointer to the entry for the ID, or nullptr. The pointer is
+     *  valid until the table is modified.
+     */
+    [[nodiscard]] auto find(const QString& ID) const -> const Entry*;
+
+    /*! \brief All targets
+     *
+     *  @returns Entries, in no particular order
+     */
+    [[nodiscard]] auto entries() const -> const QVector<Entry>& { return m_heap; }
+
+    /*! \brief Remove a target
+     *
+     *  @param ID Target ID. If the table does not contain the ID, nothing
+     *  happens.
+     */
+    void remove(const QString& ID);
+
+    /*! \brief Remove outdated targets
+     *
+     *  @param timestamp Entries with timestamp strictly less than this are
+     *  removed
+     */
+    void removeOlderThan(qint64 timestamp);
+
+    /*! \brief Modify all entries
+     *
+     *  The callable may change the reports, but not their IDs. Afterwards,
+     *  the heap is rebuilt in O(n) time.  The generation counters are not
+     *  changed.
+     *
+     *  @param modify Callable with signature void(std::span<Entry>)
+     */
+    template<typename F> void updateAll(F&& modify)
+    {
+        modify(std::span<Entry>(m_heap.data(), m_heap.size()));
+        rebuildHeap();
+    }
+
+    /*! \brief Most relevant targets
+     *
+     *  @param n Maximal number of targets to return
+     *
+     *  @returns Pointers to the n most relevant entries, most relevant first.
+     *  The pointers are valid until the table is modified.
+     */
+    [[nodiscard]] auto topN(qsizetype n) const -> QVector<const Entry*>;
+
+    /*! \brief Compare relevance of traffic reports
+     *
+     *  @param lhs First report
+     *
+     *  @param rhs Second report
+     *
+     *  @returns True if lhs is strictly more relevant than rhs
+     */
+    static auto isMoreRelevant(const Traffic::TrafficReport& lhs, const Traffic::TrafficReport& rhs) -> bool;
+
+private:
+    // Restores the heap property for the whole heap
+    void rebuildHeap();
+
+    // Removes the entry at the given heap position
+    void removeAt(qsizetype position);
+
+    // Restores the heap property after the entry at the given position has
+    // changed
+    void restoreHeap(qsizetype position);
+
+    // Moves the entry at position towards the root/the leaves of the heap,
+    // as long as it is more/less relevant than its parent/its children.
+    // Returns the new position.
+    auto siftUp(qsizetype position) -> qsizetype;
+    auto siftDown(qsizetype position) -> qsizetype;
+
+    // Swaps two heap entries and updates m_positionOfID
+    void swapEntries(qsizetype a, qsizetype b);
+
+    // Maximal number of targets
+    qsizetype m_capacity;
+
+    // Binary heap, least relevant entry at position 0
+    QVector<Entry> m_heap;
+
+    // Maps target ID to position in m_heap
+    QHash<QString, qsizetype> m_positionOfID;
+
+    // Source for Entry::generation
+    quint64 m_generation {0};
+};
+
+} // namespace Traffic
@@ -27,63 +27,24 @@
 
 
 Traffic::Warning::Warning(
-        const QString& AlarmLevel,
-        const QString& RelativeBearing,
-        const QString& AlarmType,
-        const QString& RelativeVertical,
-        const QString& RelativeDistance)
-{  
-
+        int alarmLevel,
+        Units::Angle relativeBearing,
+        int alarmType,
+        Units::Distance vDist,
+        Units::Distance hDist)
+    : m_hDist(hDist),
+      m_relativeBearing(relativeBearing),
+      m_vDist(vDist)
+{
     // Alarm level
-    if (AlarmLevel == QLatin1String("0")) {
-        m_alarmLevel = 0;
-    }
-    if (AlarmLevel == QLatin1String("1")) {
-        m_alarmLevel = 1;
-    }
-    if (AlarmLevel == QLatin1String("2")) {
-        m_alarmLevel = 2;
-    }
-    if (AlarmLevel == QLatin1String("3")) {
-        m_alarmLevel = 3;
+    if ((alarmLevel >= 0) && (alarmLevel <= 3)) {
+        m_alarmLevel = alarmLevel;
     }
 
     // Alarm Type
-    if (AlarmType == QLatin1String("2")) {
-        m_alarmType = 2;
-    }
-    if (AlarmType == QLatin1String("3")) {
-        m_alarmType = 3;
-    }
-    if (AlarmType == QLatin1String("4")) {
-        m_alarmType = 4;
+    if ((alarmType >= 2) && (alarmType <= 4)) {
+        m_alarmType = alarmType;
     }
-
-    // hDist
-    bool ok = false;
-    auto hDistM = RelativeDistance.toDouble(&ok);
-    if (ok) {
-        m_hDist = Units::Distance::fromM(hDistM);
-    } else {
-        m_hDist = Units::Distance::fromM(qQNaN());
-    }
-
-    // Relative Bearing
-    auto rb = RelativeBearing.toDouble(&ok);
-    if (ok) {
-        m_relativeBearing = Units::Angle::fromDEG(rb);
-    } else {
-        m_relativeBearing = Units::Angle::fromRAD(qQNaN());
-    }
-
-    // vDist
-    auto vDistM = RelativeVertical.toDouble(&ok);
-    if (ok) {
-        m_vDist = Units::Distance::fromM(vDistM);
-    } else {
-        m_vDist = Units::Distance::fromM(qQNaN());
-    }
-
 }
 
 
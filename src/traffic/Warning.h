@@ -116,6 +116,16 @@ public:
      */
     Q_INVOKABLE bool operator==(const Traffic::Warning &rhs);
 
+    /*! \brief Time at which the warning was read from the socket
+     *
+     *  @returns Time in nanoseconds on the clock of IngestionStatistics::now(),
+     *  or 0 if unknown.  The time is not considered by operator==.
+     */
+    [[nodiscard]] auto receiveTime() const -> qint64
+    {
+        return m_receiveTime;
+    }
+
     /*! \brief Direction to obstacle or aircraft
      *
      *  @returns Relative bearing, might be NaN
@@ -136,11 +146,11 @@ public:
 
 private:
     // Private constructor, only to be used by TrafficDataSource_Abstract
-    explicit Warning(const QString& AlarmLevel,
-                     const QString& RelativeBearing,
-                     const QString& AlarmType,
-                     const QString& RelativeVertical,
-                     const QString& RelativeDistance);
+    explicit Warning(int alarmLevel,
+                     Units::Angle relativeBearing,
+                     int alarmType,
+                     Units::Distance vDist,
+                     Units::Distance hDist);
 
     // Property values
     int m_alarmLevel {-1};
@@ -148,6 +158,9 @@ private:
     Units::Distance m_hDist;
     Units::Angle m_relativeBearing;
     Units::Distance m_vDist;
+
+    // Time stamp, set by TrafficDataSource_Abstract
+    qint64 m_receiveTime {0};
 };
 
 } // namespace Traffic